@@ -0,0 +1,114 @@
+// examples/shm_reader.cpp
+// Minimal consumer of the ray tracer's shared-memory frame export (ray_tracer --shm <name>).
+// Maps the ring read-only and, for every new frame, computes its average color directly from
+// the shared pixels (no copy), keeping the result only if the frame was not overwritten
+// meanwhile. Needs nothing but src/SharedFrame.h.
+//
+//   shm_reader <name> [frames]    read `frames` frames (default 100), then exit
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>    // For O_RDONLY
+#include <sys/mman.h> // For shm_open, mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close
+
+#include "SharedFrame.h"
+
+namespace {
+    // Maps "/<name>" read-only; returns nullptr if it does not exist (yet).
+    const SharedFrame::Header* mapRing(const std::string& name, size_t& bytes) {
+        const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedFrame::Header)) {
+            bytes = static_cast<size_t>(info.st_size);
+            mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        return mapping == MAP_FAILED ? nullptr : static_cast<const SharedFrame::Header*>(mapping);
+    }
+
+    // Average color of an RGB32F frame; other formats would be decoded here.
+    void averageColor(const SharedFrame::Header* header, const unsigned char* pixels, double average[3]) {
+        const size_t count = static_cast<size_t>(header->width) * header->height;
+        const float* values = reinterpret_cast<const float*>(pixels);
+        average[0] = average[1] = average[2] = 0.0;
+        for (size_t k = 0; k < count; ++k) {
+            average[0] += values[3 * k];
+            average[1] += values[3 * k + 1];
+            average[2] += values[3 * k + 2];
+        }
+        for (int c = 0; c < 3; ++c) {
+            average[c] /= count > 0 ? count : 1;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <name> [frames]\n", argv[0]);
+        return 1;
+    }
+    const std::string name = argv[1][0] == '/' ? argv[1] + 1 : argv[1];
+    const long wanted = argc > 2 ? std::atol(argv[2]) : 100;
+
+    size_t bytes = 0;
+    const SharedFrame::Header* header = nullptr;
+    uint64_t lastFrame = 0;
+    bool haveFrame = false;
+    long read = 0, retries = 0, skipped = 0;
+    while (read < wanted) {
+        if (!header) {
+            header = mapRing(name, bytes);
+            if (!header || !SharedFrame::ready(header)) {
+                if (header) {
+                    munmap(const_cast<SharedFrame::Header*>(header), bytes);
+                    header = nullptr;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Writer not started yet
+                continue;
+            }
+            printf("Mapped /%s: %ux%u, format %u, %u slots\n", name.c_str(), header->width, header->height,
+                   header->format, header->slotCount);
+        }
+        if (header->closed.load(std::memory_order_acquire)) {
+            munmap(const_cast<SharedFrame::Header*>(header), bytes); // Writer gone or resized: map again
+            header = nullptr;
+            haveFrame = false; // The new object counts its frames from 0 again
+            continue;
+        }
+
+        SharedFrame::FrameView view;
+        if (!SharedFrame::beginRead(header, view) || (haveFrame && view.frame == lastFrame)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Nothing new yet
+            continue;
+        }
+        double average[3] = { 0.0, 0.0, 0.0 };
+        if (header->format == SharedFrame::FORMAT_RGB32F) {
+            averageColor(header, view.pixels, average);
+        }
+        if (!SharedFrame::endRead(header, view)) {
+            ++retries; // Overwritten while we read it: discard and take the newest frame again
+            continue;
+        }
+        if (haveFrame && view.frame > lastFrame + 1) {
+            skipped += static_cast<long>(view.frame - lastFrame - 1);
+        }
+        lastFrame = view.frame;
+        haveFrame = true;
+        ++read;
+        printf("Frame %llu  average color (%.4f, %.4f, %.4f)\n", static_cast<unsigned long long>(view.frame),
+               average[0], average[1], average[2]);
+    }
+    printf("Read %ld frames, %ld frames skipped, %ld torn reads retried\n", read, skipped, retries);
+    if (header) {
+        munmap(const_cast<SharedFrame::Header*>(header), bytes);
+    }
+    return 0;
+}
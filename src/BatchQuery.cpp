@@ -0,0 +1,171 @@
+// src/BatchQuery.cpp
+#include "BatchQuery.h"
+#include "Parallel.h"
+#include "Random.h"
+#include <cfloat>  // For FLT_MAX
+#include <chrono>  // For benchmark timing
+#include <cstdio>  // For printf
+#include <vector>
+#include <functional> // For std::function
+
+namespace {
+    // One chunk of rays in the structure-of-arrays layout of the kernels.
+    // Lives on the worker's stack, so queries allocate nothing per chunk or per ray.
+    struct ChunkRays {
+        float ox[BatchQuery::CHUNK_SIZE], oy[BatchQuery::CHUNK_SIZE], oz[BatchQuery::CHUNK_SIZE];
+        float dx[BatchQuery::CHUNK_SIZE], dy[BatchQuery::CHUNK_SIZE], dz[BatchQuery::CHUNK_SIZE];
+
+        void load(const Vec3f* origins, const Vec3f* directions, int count, bool unitDirections) {
+            for (int k = 0; k < count; ++k) {
+                const Vec3f direction = unitDirections ? directions[k] : directions[k].normalize();
+                ox[k] = origins[k].x; oy[k] = origins[k].y; oz[k] = origins[k].z;
+                dx[k] = direction.x; dy[k] = direction.y; dz[k] = direction.z;
+            }
+        }
+
+        Kernels::RayArrays arrays() const {
+            Kernels::RayArrays r = { ox, oy, oz, dx, dy, dz };
+            return r;
+        }
+    };
+
+    // A Ray without the normalization of its constructor when the direction is already unit length.
+    Ray makeRay(const Vec3f& origin, const Vec3f& direction, bool unitDirection) {
+        Ray ray;
+        ray.origin = origin;
+        ray.direction = unitDirection ? direction : direction.normalize();
+        return ray;
+    }
+
+    // Calls body(first, count) for consecutive chunks of [0, total), spread over all cores.
+    template <typename Body>
+    void forEachChunk(size_t total, const Body& body) {
+        const size_t chunkCount = (total + BatchQuery::CHUNK_SIZE - 1) / BatchQuery::CHUNK_SIZE;
+        Parallel::forEach(static_cast<int>(chunkCount), [&](int chunk) {
+            const size_t first = static_cast<size_t>(chunk) * BatchQuery::CHUNK_SIZE;
+            const size_t remaining = total - first;
+            body(first, remaining < BatchQuery::CHUNK_SIZE ? static_cast<int>(remaining) : BatchQuery::CHUNK_SIZE);
+        });
+    }
+}
+
+BatchQuery::BatchQuery(const Scene& scene) : scene(&scene), packetScene(scene) {}
+
+void BatchQuery::traceBatch(const Vec3f* origins, const Vec3f* directions, const float* tMax, size_t count,
+                            float* distance, int* objectId, bool unitDirections) const {
+    forEachChunk(count, [&](size_t first, int n) {
+        if (packetScene.supported) {
+            ChunkRays rays;
+            rays.load(origins + first, directions + first, n, unitDirections);
+            int primitive[CHUNK_SIZE];
+            Kernels::active().closestHit(packetScene.view(), rays.arrays(), n, distance + first, primitive);
+            for (int k = 0; k < n; ++k) {
+                // The closest hit beyond tMax means no hit within it.
+                const bool hit = primitive[k] >= 0 && (!tMax || distance[first + k] < tMax[first + k]);
+                distance[first + k] = hit ? distance[first + k] : FLT_MAX;
+                objectId[first + k] = hit ? packetScene.objectIndex(primitive[k]) : -1;
+            }
+            return;
+        }
+        for (int k = 0; k < n; ++k) {
+            const size_t r = first + k;
+            float hitDistance;
+            const int closest = scene->closestHit(makeRay(origins[r], directions[r], unitDirections), hitDistance);
+            const bool hit = closest >= 0 && (!tMax || hitDistance < tMax[r]);
+            distance[r] = hit ? hitDistance : FLT_MAX;
+            objectId[r] = hit ? closest : -1;
+        }
+    });
+}
+
+void BatchQuery::occludedBatch(const Vec3f* origins, const Vec3f* directions, const float* tMax, size_t count,
+                               unsigned char* occluded, bool unitDirections) const {
+    forEachChunk(count, [&](size_t first, int n) {
+        if (packetScene.supported) {
+            ChunkRays rays;
+            rays.load(origins + first, directions + first, n, unitDirections);
+            float limit[CHUNK_SIZE];
+            for (int k = 0; k < n; ++k) {
+                limit[k] = tMax ? tMax[first + k] : FLT_MAX;
+            }
+            Kernels::active().occluded(packetScene.view(), rays.arrays(), limit, n, occluded + first);
+            return;
+        }
+        for (int k = 0; k < n; ++k) {
+            const size_t r = first + k;
+            occluded[r] = scene->occluded(makeRay(origins[r], directions[r], unitDirections), tMax ? tMax[r] : FLT_MAX) ? 1 : 0;
+        }
+    });
+}
+
+int runBatchQueryBenchmark(const Scene& scene, size_t rayCount) {
+    typedef std::chrono::steady_clock Clock;
+
+    // Random rays from a box around the origin in random directions, with random lengths.
+    std::vector<Vec3f> origins(rayCount), directions(rayCount);
+    std::vector<float> tMax(rayCount);
+    for (size_t k = 0; k < rayCount; ++k) {
+        const uint32_t index = static_cast<uint32_t>(k);
+        origins[k] = Vec3f(Random::uniform(index, 0, 0), Random::uniform(index, 0, 1), Random::uniform(index, 0, 2)) * 10.0f - Vec3f(5.0f);
+        directions[k] = (Vec3f(Random::uniform(index, 1, 0), Random::uniform(index, 1, 1), Random::uniform(index, 1, 2)) - Vec3f(0.5f)).normalize();
+        tMax[k] = 1.0f + 19.0f * Random::uniform(index, 2, 0);
+    }
+
+    BatchQuery query(scene);
+    std::vector<float> distance(rayCount), referenceDistance(rayCount);
+    std::vector<int> objectId(rayCount), referenceId(rayCount);
+    std::vector<unsigned char> occluded(rayCount), referenceOccluded(rayCount);
+    printf("Batch queries: %zu rays, %zu objects, %d threads, %s\n", rayCount, scene.objects.size(),
+           Parallel::threadCount(), query.usesKernels() ? Kernels::active().name : "scalar fallback");
+
+    // Times `body` and prints its throughput in million rays per second.
+    auto measure = [&](const char* label, const std::function<void()>& body) {
+        Clock::time_point start = Clock::now();
+        body();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("  %-36s %8.2f ms  %8.2f Mrays/s\n", label, seconds * 1000.0, rayCount / seconds / 1e6);
+    };
+
+    measure("Scene::closestHit, one Ray at a time", [&]() {
+        for (size_t k = 0; k < rayCount; ++k) {
+            float hitDistance;
+            const int closest = scene.closestHit(Ray(origins[k], directions[k]), hitDistance);
+            const bool hit = closest >= 0 && hitDistance < tMax[k];
+            referenceDistance[k] = hit ? hitDistance : FLT_MAX;
+            referenceId[k] = hit ? closest : -1;
+        }
+    });
+    measure("traceBatch", [&]() {
+        query.traceBatch(origins.data(), directions.data(), tMax.data(), rayCount, distance.data(), objectId.data());
+    });
+    // Same rays normalized by Ray's constructor: results must match exactly.
+    size_t mismatches = 0;
+    for (size_t k = 0; k < rayCount; ++k) {
+        mismatches += objectId[k] != referenceId[k] || distance[k] != referenceDistance[k];
+    }
+    measure("traceBatch, unit directions", [&]() {
+        query.traceBatch(origins.data(), directions.data(), tMax.data(), rayCount, distance.data(), objectId.data(), true);
+    });
+
+    measure("Scene::occluded, one Ray at a time", [&]() {
+        for (size_t k = 0; k < rayCount; ++k) {
+            referenceOccluded[k] = scene.occluded(Ray(origins[k], directions[k]), tMax[k]) ? 1 : 0;
+        }
+    });
+    measure("occludedBatch", [&]() {
+        query.occludedBatch(origins.data(), directions.data(), tMax.data(), rayCount, occluded.data());
+    });
+    for (size_t k = 0; k < rayCount; ++k) {
+        mismatches += occluded[k] != referenceOccluded[k];
+    }
+    measure("occludedBatch, unit directions", [&]() {
+        query.occludedBatch(origins.data(), directions.data(), tMax.data(), rayCount, occluded.data(), true);
+    });
+
+    if (mismatches > 0) {
+        fprintf(stderr, "Error: %zu batch results differ from the per-ray queries\n", mismatches);
+        return -1;
+    }
+    printf("Batch results match the per-ray queries\n");
+    return 0;
+}
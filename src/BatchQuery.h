@@ -0,0 +1,52 @@
+// src/BatchQuery.h
+#ifndef BATCH_QUERY_H
+#define BATCH_QUERY_H
+
+#include <cstddef>
+
+#include "Vec3.h"
+#include "Scene.h"
+#include "Kernels.h"
+
+// Visibility queries for many rays at once, for analyses that use the scene's geometry
+// without rendering it (line of sight, sensor coverage, ...).
+//
+// Rays are passed as contiguous arrays of origins, directions and maximum distances.
+// Batches are cut into chunks of CHUNK_SIZE rays that run on all cores; scenes made of
+// spheres and planes go through the SIMD kernels (Kernels.h), others through each
+// object's hitDistance(). Nothing is allocated per ray, and when the caller declares
+// the directions unit length they are used as given instead of being normalized.
+class BatchQuery {
+public:
+    static const int CHUNK_SIZE = 1024; // Rays per work item
+
+    // Takes a snapshot of the scene's geometry for the SIMD kernels. The scene must outlive
+    // the query object; create a new one after editing the scene.
+    explicit BatchQuery(const Scene& scene);
+
+    // Closest hit along each ray within tMax[k] (tMax == nullptr: unbounded).
+    // distance[k] receives the hit distance (FLT_MAX on a miss) and objectId[k] the index
+    // of the object in scene.objects (-1 on a miss). Distances are measured along the
+    // normalized direction, so they are only world distances if the directions are unit length
+    // or unitDirections is false.
+    void traceBatch(const Vec3f* origins, const Vec3f* directions, const float* tMax, size_t count, float* distance,
+                    int* objectId, bool unitDirections = false) const;
+
+    // occluded[k] = 1 if any object lies along ray k closer than tMax[k] (tMax == nullptr: unbounded), 0 otherwise.
+    void occludedBatch(const Vec3f* origins, const Vec3f* directions, const float* tMax, size_t count,
+                       unsigned char* occluded, bool unitDirections = false) const;
+
+    // True if the queries run on the SIMD kernels (the scene holds only spheres and planes).
+    bool usesKernels() const { return packetScene.supported; }
+
+private:
+    const Scene* scene;
+    Kernels::PacketScene packetScene;
+};
+
+// Measures the throughput of traceBatch() and occludedBatch() on `rayCount` random rays,
+// against calling Scene::closestHit / Scene::occluded once per Ray, and prints the results.
+// Returns 0, or -1 if the batch results disagree with the per-ray ones.
+int runBatchQueryBenchmark(const Scene& scene, size_t rayCount);
+
+#endif // BATCH_QUERY_H
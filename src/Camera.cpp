@@ -1,6 +1,11 @@
 // src/Camera.cpp
 #include "Camera.h"
-#include <cmath> // For tan, M_PI
+#include "Kernels.h"
+#include "Random.h"
+#include <algorithm> // For std::min
+#include <chrono>    // For the benchmark
+#include <cmath>     // For tan, M_PI
+#include <cstdio>    // For printf
 
 // Define M_PI if not already defined (common in older compilers or non-GNU C++)
 #ifndef M_PI
@@ -13,28 +18,73 @@ Camera::Camera(const Vec3f& eye, const Vec3f& look, const Vec3f& up, float fov_d
     updateBasis(); // Call updateBasis to initialize u,v,w
 }
 
-// Computes the primary ray for a given pixel (i, j).
-// This assumes a pinhole camera model.
+// Computes the primary ray for a given pixel (i, j), passing through the pixel center.
 Ray Camera::computePrimaryRay(int i, int j) const {
-    // Convert FOV from degrees to radians
-    float fov_rad = fov * M_PI / 180.0f;
-
-    // Calculate half width and half height of the image plane at distance 1 from camera
-    float aspectRatio = static_cast<float>(imageWidth) / imageHeight;
-    float halfHeight = std::tan(fov_rad / 2.0f);
-    float halfWidth = halfHeight * aspectRatio;
+    return computePrimaryRay(i + 0.5f, j + 0.5f);
+}
 
+// Computes the primary ray through the image position (px, py).
+// This assumes a pinhole camera model; halfWidth/halfHeight come from updateBasis().
+Ray Camera::computePrimaryRay(float px, float py) const {
     // Calculate pixel coordinates in camera space (normalized to [-1, 1])
-    // Map pixel (i,j) from [0, width-1]x[0, height-1] to [-halfWidth, halfWidth]x[-halfHeight, halfHeight]
-    float x_ndc = (2.0f * (i + 0.5f) / imageWidth - 1.0f) * halfWidth;
-    float y_ndc = (1.0f - 2.0f * (j + 0.5f) / imageHeight) * halfHeight; // Y-axis typically points up in camera space
+    // Map position (px,py) from [0, width]x[0, height] to [-halfWidth, halfWidth]x[-halfHeight, halfHeight]
+    float x_ndc = (2.0f * px / imageWidth - 1.0f) * halfWidth;
+    float y_ndc = (1.0f - 2.0f * py / imageHeight) * halfHeight; // Y-axis typically points up in camera space
 
     // Calculate ray direction in world space
     // The ray originates from eyePosition and points towards a point on the image plane.
     // The image plane is at distance 1 along the -w direction.
-    Vec3f rayDirection = (x_ndc * u + y_ndc * v - w).normalize();
+    // The direction is already unit length, so it is stored without Ray's normalization.
+    Ray ray;
+    ray.origin = eyePosition;
+    ray.direction = (x_ndc * u + y_ndc * v - w).normalize();
+    return ray;
+}
+
+void Camera::generateRays(const Tile& tile, int samples, RayBatch& batch, int firstSample) const {
+    samples = samples > 1 ? samples : 1;
+    batch.resize(tile.pixelCount() * samples);
+    int k = 0;
+    for (int j = tile.y0; j < tile.y1; ++j) {
+        for (int i = tile.x0; i < tile.x1; ++i) {
+            if (samples == 1 && firstSample == 0) {
+                batch.pixelX[k] = i + 0.5f;
+                batch.pixelY[k++] = j + 0.5f;
+                continue;
+            }
+            const uint32_t pixelIndex = static_cast<uint32_t>(j) * static_cast<uint32_t>(imageWidth) + static_cast<uint32_t>(i);
+            for (int s = firstSample; s < firstSample + samples; ++s) {
+                batch.pixelX[k] = i + Random::uniform(pixelIndex, s, 0);
+                batch.pixelY[k++] = j + Random::uniform(pixelIndex, s, 1);
+            }
+        }
+    }
+    generateRays(batch);
+}
 
-    return Ray(eyePosition, rayDirection);
+void Camera::generateRays(RayBatch& batch) const {
+    const Kernels::CameraView view = { eyePosition, u, v, w, halfWidth, halfHeight,
+                                       static_cast<float>(imageWidth), static_cast<float>(imageHeight) };
+    const Kernels::RayBuffers rays = { batch.originX.data(), batch.originY.data(), batch.originZ.data(),
+                                       batch.directionX.data(), batch.directionY.data(), batch.directionZ.data() };
+    Kernels::active().primaryRays(view, batch.pixelX.data(), batch.pixelY.data(), batch.size(), rays);
+}
+
+// Projects a world-space point onto the image plane.
+// This undoes computePrimaryRay: a point P = eye + t * (x * u + y * v - w) has
+// depth t along -w, and x, y are recovered by dividing its u/v components by that depth.
+bool Camera::projectToPixel(const Vec3f& point, float& px, float& py, float& depth) const {
+    Vec3f toPoint = point - eyePosition;
+    depth = -toPoint.dot(w);
+    if (depth <= 1e-4f) {
+        return false; // Behind (or on) the eye plane
+    }
+
+    float x_ndc = toPoint.dot(u) / (depth * halfWidth);
+    float y_ndc = toPoint.dot(v) / (depth * halfHeight);
+    px = (x_ndc + 1.0f) * 0.5f * imageWidth;
+    py = (1.0f - y_ndc) * 0.5f * imageHeight;
+    return true;
 }
 
 // NEW: Function to update the camera's basis vectors (u, v, w)
@@ -64,4 +114,113 @@ void Camera::updateBasis() {
     // Normalize v as well to ensure perfect orthogonality and unit length,
     // especially if 'u' was a fallback or had precision issues.
     v = v.normalize();
+
+    // Projection constants: half width and half height of the image plane at distance 1 from camera
+    float fov_rad = fov * M_PI / 180.0f;
+    float aspectRatio = static_cast<float>(imageWidth) / imageHeight;
+    halfHeight = std::tan(fov_rad / 2.0f);
+    halfWidth = halfHeight * aspectRatio;
+}
+
+void RayBatch::resize(int count) {
+    for (std::vector<float>* v : { &pixelX, &pixelY, &originX, &originY, &originZ, &directionX, &directionY, &directionZ }) {
+        v->resize(count);
+    }
+}
+
+Ray RayBatch::ray(int k) const {
+    Ray r;
+    r.origin = Vec3f(originX[k], originY[k], originZ[k]);
+    r.direction = Vec3f(directionX[k], directionY[k], directionZ[k]);
+    return r;
+}
+
+namespace {
+    // computePrimaryRay as it was before the projection constants were cached:
+    // FOV conversion, tan and aspect ratio per ray, and a second normalization by Ray.
+    Ray uncachedPrimaryRay(const Camera& camera, float px, float py) {
+        float fov_rad = camera.fov * M_PI / 180.0f;
+        float aspectRatio = static_cast<float>(camera.imageWidth) / camera.imageHeight;
+        float halfHeight = std::tan(fov_rad / 2.0f);
+        float halfWidth = halfHeight * aspectRatio;
+        float x_ndc = (2.0f * px / camera.imageWidth - 1.0f) * halfWidth;
+        float y_ndc = (1.0f - 2.0f * py / camera.imageHeight) * halfHeight;
+        return Ray(camera.eyePosition, (x_ndc * camera.u + y_ndc * camera.v - camera.w).normalize());
+    }
+}
+
+int runRayGenerationBenchmark(const Camera& camera, int frames) {
+    typedef std::chrono::steady_clock Clock;
+    const int tileSize = 32; // As Renderer::renderFrame
+    const double rayCount = static_cast<double>(camera.imageWidth) * camera.imageHeight * frames;
+    printf("Ray generation: %dx%d, %d frames, one thread, %s kernels\n", camera.imageWidth, camera.imageHeight, frames,
+           Kernels::active().name);
+
+    // Runs `perTile` over every tile of every frame and prints the throughput in million rays per second.
+    RayBatch batch;
+    auto measure = [&](const char* label, void (*perTile)(const Camera&, const Tile&, RayBatch&)) {
+        Clock::time_point start = Clock::now();
+        for (int f = 0; f < frames; ++f) {
+            for (int y = 0; y < camera.imageHeight; y += tileSize) {
+                for (int x = 0; x < camera.imageWidth; x += tileSize) {
+                    Tile tile = { x, y, std::min(x + tileSize, camera.imageWidth), std::min(y + tileSize, camera.imageHeight) };
+                    perTile(camera, tile, batch);
+                }
+            }
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("  %-40s %8.2f ms  %8.2f Mrays/s\n", label, seconds * 1000.0, rayCount / seconds / 1e6);
+    };
+
+    // The per-pixel variants store their rays in a RayBatch too, so that all of them produce the same output.
+    measure("computePrimaryRay, uncached (previous)", [](const Camera& c, const Tile& tile, RayBatch& out) {
+        out.resize(tile.pixelCount());
+        int k = 0;
+        for (int j = tile.y0; j < tile.y1; ++j) {
+            for (int i = tile.x0; i < tile.x1; ++i, ++k) {
+                const Ray ray = uncachedPrimaryRay(c, i + 0.5f, j + 0.5f);
+                out.originX[k] = ray.origin.x; out.originY[k] = ray.origin.y; out.originZ[k] = ray.origin.z;
+                out.directionX[k] = ray.direction.x; out.directionY[k] = ray.direction.y; out.directionZ[k] = ray.direction.z;
+            }
+        }
+    });
+    measure("computePrimaryRay, cached constants", [](const Camera& c, const Tile& tile, RayBatch& out) {
+        out.resize(tile.pixelCount());
+        int k = 0;
+        for (int j = tile.y0; j < tile.y1; ++j) {
+            for (int i = tile.x0; i < tile.x1; ++i, ++k) {
+                const Ray ray = c.computePrimaryRay(i, j);
+                out.originX[k] = ray.origin.x; out.originY[k] = ray.origin.y; out.originZ[k] = ray.origin.z;
+                out.directionX[k] = ray.direction.x; out.directionY[k] = ray.direction.y; out.directionZ[k] = ray.direction.z;
+            }
+        }
+    });
+    measure("generateRays, 32x32 tiles", [](const Camera& c, const Tile& tile, RayBatch& out) {
+        c.generateRays(tile, 1, out);
+    });
+
+    // The batched rays must be exactly those of computePrimaryRay.
+    long long mismatches = 0;
+    for (int y = 0; y < camera.imageHeight; y += tileSize) {
+        for (int x = 0; x < camera.imageWidth; x += tileSize) {
+            Tile tile = { x, y, std::min(x + tileSize, camera.imageWidth), std::min(y + tileSize, camera.imageHeight) };
+            camera.generateRays(tile, 1, batch);
+            int k = 0;
+            for (int j = tile.y0; j < tile.y1; ++j) {
+                for (int i = tile.x0; i < tile.x1; ++i, ++k) {
+                    const Ray expected = camera.computePrimaryRay(i, j);
+                    const Ray generated = batch.ray(k);
+                    mismatches += generated.origin.x != expected.origin.x || generated.origin.y != expected.origin.y ||
+                                  generated.origin.z != expected.origin.z || generated.direction.x != expected.direction.x ||
+                                  generated.direction.y != expected.direction.y || generated.direction.z != expected.direction.z;
+                }
+            }
+        }
+    }
+    if (mismatches > 0) {
+        fprintf(stderr, "Error: %lld batched rays differ from computePrimaryRay\n", mismatches);
+        return -1;
+    }
+    printf("Batched rays match computePrimaryRay\n");
+    return 0;
 }
@@ -2,8 +2,25 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <vector>
+
 #include "Vec3.h"
 #include "Ray.h"
+#include "Tile.h"
+
+// Primary rays in structure-of-arrays layout, as read by the SIMD kernels (Kernels::RayArrays).
+// pixelX/pixelY hold the image position each ray passes through.
+struct RayBatch {
+    std::vector<float> pixelX, pixelY;
+    std::vector<float> originX, originY, originZ;
+    std::vector<float> directionX, directionY, directionZ; // Unit length
+
+    int size() const { return static_cast<int>(pixelX.size()); }
+    void resize(int count);
+
+    // Ray k as a Ray.
+    Ray ray(int k) const;
+};
 
 // Represents the camera in the scene, responsible for generating primary rays.
 class Camera {
@@ -20,14 +37,43 @@ public:
     // Camera basis vectors (u, v, w)
     Vec3f u, v, w;
 
+    // Projection constants, cached by updateBasis() so that ray generation does not
+    // recompute them per pixel: extent of the image plane at distance 1 along -w.
+    float halfWidth, halfHeight;
+
     // Constructor
     Camera(const Vec3f& eye, const Vec3f& look, const Vec3f& up, float fov_deg, int width, int height);
 
     // Computes the primary ray for a given pixel (i, j)
     Ray computePrimaryRay(int i, int j) const;
 
+    // Computes the primary ray through a continuous image position (px, py),
+    // where pixel (i, j) covers [i, i+1) x [j, j+1). Used for jittered sampling.
+    Ray computePrimaryRay(float px, float py) const;
+
+    // Rays of a whole tile at once, in row-major pixel order with `samples` consecutive rays per
+    // pixel: through the pixel centers for one sample, through jittered positions otherwise
+    // (Random::uniform, as Renderer::samplesPerPixel). The samples are numbered from
+    // `firstSample` on; any range other than sample 0 alone is jittered. Uses the SIMD kernels;
+    // the rays are identical to computePrimaryRay's.
+    void generateRays(const Tile& tile, int samples, RayBatch& batch, int firstSample = 0) const;
+
+    // Rays through the positions already in batch.pixelX/pixelY (e.g. a picking ray).
+    void generateRays(RayBatch& batch) const;
+
+    // Projects a world-space point back onto the image plane (inverse of computePrimaryRay).
+    // px/py receive continuous pixel coordinates (pixel (i, j) covers [i, i+1) x [j, j+1)),
+    // depth the distance along the viewing axis. Returns false if the point is behind the camera.
+    bool projectToPixel(const Vec3f& point, float& px, float& py, float& depth) const;
+
     // NEW: Function to update the camera's basis vectors (u, v, w)
+    // and the projection constants. Call it after changing the eye, look-at point, FOV or image size.
     void updateBasis();
 };
 
+// Measures the rays per second of Camera::generateRays against the per-pixel ray generation
+// (computePrimaryRay, and the previous version that recomputed the projection per pixel) over
+// `frames` images of `camera`, and prints the results. Returns 0, or -1 if the rays differ.
+int runRayGenerationBenchmark(const Camera& camera, int frames);
+
 #endif // CAMERA_H
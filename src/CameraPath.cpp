@@ -0,0 +1,150 @@
+// src/CameraPath.cpp
+#include "CameraPath.h"
+#include <algorithm> // For std::lower_bound, std::max, std::min
+#include <cmath>     // For sin, cos, asin, atan2, M_PI
+#include <fstream>   // For std::ifstream
+#include <sstream>   // For std::istringstream
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+Vec3f OrbitPose::eye() const {
+    float yawRad = yaw * M_PI / 180.0f;
+    float pitchRad = pitch * M_PI / 180.0f;
+    return lookAt + Vec3f(radius * std::cos(yawRad) * std::cos(pitchRad),
+                          radius * std::sin(pitchRad),
+                          radius * std::sin(yawRad) * std::cos(pitchRad));
+}
+
+OrbitPose OrbitPose::fromEye(const Vec3f& eye, const Vec3f& lookAt, float fov) {
+    OrbitPose pose;
+    Vec3f offset = eye - lookAt;
+    pose.radius = offset.length();
+    if (pose.radius > 0.0f) {
+        pose.pitch = std::asin(std::max(-1.0f, std::min(1.0f, offset.y / pose.radius))) * 180.0f / M_PI;
+        pose.yaw = std::atan2(offset.z, offset.x) * 180.0f / M_PI;
+    }
+    pose.lookAt = lookAt;
+    pose.fov = fov;
+    return pose;
+}
+
+void OrbitPose::apply(Camera& camera) const {
+    camera.eyePosition = eye();
+    camera.lookAt = lookAt;
+    camera.fov = fov;
+    camera.updateBasis();
+}
+
+void CameraPath::addKey(int frame, const OrbitPose& pose) {
+    std::vector<Key>::iterator it = std::lower_bound(keyList.begin(), keyList.end(), frame,
+                                                     [](const Key& key, int f) { return key.frame < f; });
+    if (it != keyList.end() && it->frame == frame) {
+        it->pose = pose;
+    } else {
+        Key key;
+        key.frame = frame;
+        key.pose = pose;
+        keyList.insert(it, key);
+    }
+}
+
+int CameraPath::firstFrame() const {
+    return keyList.empty() ? 0 : keyList.front().frame;
+}
+
+int CameraPath::lastFrame() const {
+    return keyList.empty() ? -1 : keyList.back().frame;
+}
+
+OrbitPose CameraPath::at(int frame) const {
+    if (keyList.empty()) {
+        return OrbitPose();
+    }
+    if (frame <= keyList.front().frame) {
+        return keyList.front().pose;
+    }
+    if (frame >= keyList.back().frame) {
+        return keyList.back().pose;
+    }
+    // First key after `frame`; the one before it is at or before `frame`.
+    std::vector<Key>::const_iterator next = std::upper_bound(keyList.begin(), keyList.end(), frame,
+                                                             [](int f, const Key& key) { return f < key.frame; });
+    const Key& a = *(next - 1);
+    const Key& b = *next;
+    const float t = static_cast<float>(frame - a.frame) / static_cast<float>(b.frame - a.frame);
+
+    OrbitPose pose;
+    pose.yaw = a.pose.yaw + (b.pose.yaw - a.pose.yaw) * t;
+    pose.pitch = a.pose.pitch + (b.pose.pitch - a.pose.pitch) * t;
+    pose.radius = a.pose.radius + (b.pose.radius - a.pose.radius) * t;
+    pose.lookAt = a.pose.lookAt + (b.pose.lookAt - a.pose.lookAt) * t;
+    pose.fov = a.pose.fov + (b.pose.fov - a.pose.fov) * t;
+    return pose;
+}
+
+bool CameraPath::parse(const std::string& text, std::string& error) {
+    std::istringstream input(text);
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        // Strip comments and skip blank lines
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+        if (keyword != "key") {
+            error = "line " + std::to_string(lineNumber) + ": unknown keyword '" + keyword + "'";
+            return false;
+        }
+
+        int frame = 0;
+        OrbitPose pose;
+        if (!(fields >> frame >> pose.yaw >> pose.pitch >> pose.radius >> pose.lookAt.x >> pose.lookAt.y >>
+              pose.lookAt.z >> pose.fov) || frame < 0 || pose.radius <= 0.0f || pose.fov <= 0.0f || pose.fov >= 180.0f) {
+            error = "line " + std::to_string(lineNumber) + ": malformed 'key' entry";
+            return false;
+        }
+        addKey(frame, pose);
+    }
+    if (keyList.empty()) {
+        error = "no keys";
+        return false;
+    }
+    return true;
+}
+
+bool CameraPath::load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "could not open camera path file " + path;
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!parse(contents.str(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+CameraPath CameraPath::turntable(const OrbitPose& start, int frames) {
+    CameraPath path;
+    path.addKey(0, start);
+    if (frames > 1) {
+        // The key after the last frame closes the circle, so the sequence loops without a repeated frame.
+        OrbitPose end = start;
+        end.yaw += 360.0f;
+        path.addKey(frames, end);
+    }
+    return path;
+}
@@ -0,0 +1,76 @@
+// src/CameraPath.h
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+
+#include "Vec3.h"
+#include "Camera.h"
+
+// Camera placement in the orbit parameters of the interactive camera: the eye circles `lookAt`
+// at `radius`, `yaw` degrees around the vertical axis (-90 looks along -Z) and `pitch`
+// degrees above the horizon.
+struct OrbitPose {
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float radius = 6.0f;
+    Vec3f lookAt = Vec3f(0.0f);
+    float fov = 75.0f;
+
+    // Eye position for these parameters.
+    Vec3f eye() const;
+
+    // Orbit parameters that place the eye at `eye`.
+    static OrbitPose fromEye(const Vec3f& eye, const Vec3f& lookAt, float fov);
+
+    // Moves `camera` to this pose (eye, look-at point, FOV) and updates its basis.
+    void apply(Camera& camera) const;
+};
+
+// Keyframed camera animation for sequence rendering (Sequence.h).
+// Each key fixes the orbit pose at one frame; frames in between interpolate the parameters
+// linearly, so the eye moves along arcs around lookAt rather than straight lines. Yaw is not
+// wrapped: keys at yaw 0 and 360 give a full turn.
+//
+// Path files are line-based like scene files (SceneLoader.h):
+//
+//   # frame  yaw  pitch  radius  lx ly lz  fov
+//   key 0    -90  15     6       0 0 0     75
+//   key 119  270  15     6       0 0 0     75
+class CameraPath {
+public:
+    struct Key {
+        int frame;
+        OrbitPose pose;
+    };
+
+    // Keys sorted by frame, at most one per frame.
+    const std::vector<Key>& keys() const { return keyList; }
+    bool empty() const { return keyList.empty(); }
+
+    // Adds (or replaces) the key at `frame`.
+    void addKey(int frame, const OrbitPose& pose);
+
+    // Frames covered by the keys (0 and -1 without keys).
+    int firstFrame() const;
+    int lastFrame() const;
+
+    // Pose at `frame`; frames before the first or after the last key hold that key's pose.
+    OrbitPose at(int frame) const;
+
+    // Parses path text (see above). Returns false and describes the problem in `error` on
+    // malformed input.
+    bool parse(const std::string& text, std::string& error);
+
+    // Loads a path file.
+    bool load(const std::string& path, std::string& error);
+
+    // One full orbit around start.lookAt in `frames` frames, starting (and ending just short of) `start`.
+    static CameraPath turntable(const OrbitPose& start, int frames);
+
+private:
+    std::vector<Key> keyList;
+};
+
+#endif // CAMERA_PATH_H
@@ -0,0 +1,190 @@
+// src/Checkpoint.cpp
+#include "Checkpoint.h"
+#include <cstdio>  // For FILE, fopen, fwrite, fread, rename, remove
+#include <cstring> // For std::memcmp
+
+#ifndef _WIN32
+#include <unistd.h> // For fsync
+#endif
+
+namespace {
+    const char MAGIC[8] = { 'R', 'T', 'C', 'K', 'P', 'T', '2', '\n' };
+    const uint32_t BYTE_ORDER_MARK = 0x01020304U;
+
+    bool writeBytes(FILE* file, const void* data, size_t bytes) {
+        return bytes == 0 || fwrite(data, 1, bytes, file) == bytes;
+    }
+
+    bool readBytes(FILE* file, void* data, size_t bytes) {
+        return bytes == 0 || fread(data, 1, bytes, file) == bytes;
+    }
+
+    template <typename T>
+    bool writeValue(FILE* file, const T& value) {
+        return writeBytes(file, &value, sizeof(T));
+    }
+
+    template <typename T>
+    bool readValue(FILE* file, T& value) {
+        return readBytes(file, &value, sizeof(T));
+    }
+}
+
+void RenderCheckpoint::reset() {
+    const size_t count = static_cast<size_t>(width) * height;
+    accumulation.assign(count, Vec3f(0.0f));
+    sampleCounts.assign(count, 0);
+}
+
+bool RenderCheckpoint::sameSettings(const RenderCheckpoint& other) const {
+    // Exact comparisons: the settings are written and read back bit for bit.
+    return scene == other.scene && fingerprint == other.fingerprint && width == other.width && height == other.height && samples == other.samples &&
+           shadows == other.shadows && eye.x == other.eye.x && eye.y == other.eye.y && eye.z == other.eye.z &&
+           lookAt.x == other.lookAt.x && lookAt.y == other.lookAt.y && lookAt.z == other.lookAt.z &&
+           up.x == other.up.x && up.y == other.up.y && up.z == other.up.z && fov == other.fov;
+}
+
+bool RenderCheckpoint::save(const std::string& path, std::string& error) const {
+    const std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) {
+        error = "could not open " + temporary + " for writing";
+        return false;
+    }
+
+    // Sample counts as (count, length) runs.
+    std::vector<uint32_t> runs;
+    for (size_t k = 0; k < sampleCounts.size(); ++k) {
+        if (runs.empty() || runs[runs.size() - 2] != sampleCounts[k]) {
+            runs.push_back(sampleCounts[k]);
+            runs.push_back(0);
+        }
+        ++runs.back();
+    }
+
+    const int32_t sizes[4] = { width, height, samples, shadows ? 1 : 0 };
+    const float camera[10] = { eye.x, eye.y, eye.z, lookAt.x, lookAt.y, lookAt.z, up.x, up.y, up.z, fov };
+    static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be tightly packed");
+    bool ok = writeBytes(file, MAGIC, sizeof(MAGIC)) && writeValue(file, BYTE_ORDER_MARK) && writeValue(file, fingerprint) &&
+              writeBytes(file, sizes, sizeof(sizes)) && writeBytes(file, camera, sizeof(camera)) &&
+              writeValue(file, static_cast<uint32_t>(scene.size())) && writeBytes(file, scene.data(), scene.size()) &&
+              writeValue(file, static_cast<uint32_t>(runs.size() / 2)) &&
+              writeBytes(file, runs.data(), runs.size() * sizeof(uint32_t)) &&
+              writeBytes(file, accumulation.data(), accumulation.size() * sizeof(Vec3f));
+
+    // Push the data to disk before the rename makes it the checkpoint.
+    ok = fflush(file) == 0 && ok;
+#ifndef _WIN32
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        remove(temporary.c_str());
+        error = "could not write " + temporary;
+        return false;
+    }
+#ifdef _WIN32
+    remove(path.c_str()); // rename() does not replace existing files on Windows
+#endif
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "could not rename " + temporary + " to " + path;
+        return false;
+    }
+    return true;
+}
+
+bool RenderCheckpoint::load(const std::string& path, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "could not open checkpoint " + path;
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t byteOrder = 0;
+    int32_t sizes[4];
+    float camera[10];
+    uint32_t nameLength = 0;
+    bool ok = readBytes(file, magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+              readValue(file, byteOrder) && byteOrder == BYTE_ORDER_MARK && readValue(file, fingerprint) &&
+              readBytes(file, sizes, sizeof(sizes)) &&
+              readBytes(file, camera, sizeof(camera)) && readValue(file, nameLength) && nameLength < 4096 &&
+              sizes[0] > 0 && sizes[1] > 0 && sizes[2] > 0;
+    if (ok) {
+        scene.assign(nameLength, '\0');
+        ok = readBytes(file, &scene[0], nameLength);
+        width = sizes[0];
+        height = sizes[1];
+        samples = sizes[2];
+        shadows = sizes[3] != 0;
+        eye = Vec3f(camera[0], camera[1], camera[2]);
+        lookAt = Vec3f(camera[3], camera[4], camera[5]);
+        up = Vec3f(camera[6], camera[7], camera[8]);
+        fov = camera[9];
+    }
+
+    // Expand the sample count runs; they must cover the image exactly.
+    uint32_t runCount = 0;
+    if (ok) {
+        reset();
+        ok = readValue(file, runCount);
+    }
+    size_t next = 0;
+    for (uint32_t r = 0; ok && r < runCount; ++r) {
+        uint32_t run[2];
+        ok = readBytes(file, run, sizeof(run)) && run[1] <= sampleCounts.size() - next;
+        for (uint32_t k = 0; ok && k < run[1]; ++k) {
+            sampleCounts[next++] = run[0];
+        }
+    }
+    ok = ok && next == sampleCounts.size() &&
+         readBytes(file, accumulation.data(), accumulation.size() * sizeof(Vec3f));
+    fclose(file);
+    if (!ok) {
+        error = path + " is not a complete render checkpoint";
+        return false;
+    }
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path)
+    : path(path), pending(1), busy(false), failed(false), savedCount(0) {
+    worker = std::thread([this]() {
+        std::shared_ptr<RenderCheckpoint> checkpoint;
+        while (pending.pop(checkpoint)) {
+            std::string error;
+            if (checkpoint->save(this->path, error)) {
+                ++savedCount;
+            } else {
+                fprintf(stderr, "Checkpoint failed: %s\n", error.c_str());
+                failed = true;
+            }
+            checkpoint.reset(); // Free the copy before accepting the next one
+            busy = false;
+        }
+    });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    finish();
+}
+
+bool CheckpointWriter::submit(const RenderCheckpoint& checkpoint) {
+    bool idle = false;
+    if (!busy.compare_exchange_strong(idle, true)) {
+        return false;
+    }
+    if (!pending.push(std::make_shared<RenderCheckpoint>(checkpoint))) {
+        busy = false; // finish() was called
+        return false;
+    }
+    return true;
+}
+
+bool CheckpointWriter::finish() {
+    pending.close();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    return !failed;
+}
@@ -0,0 +1,91 @@
+// src/Checkpoint.h
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Vec3.h"
+#include "BoundedQueue.h"
+
+// Saved state of a progressive render (ProgressiveRender.h), enough to continue it later as
+// if it had never stopped.
+//
+// The random numbers need no saved generator: they are hashed from (pixel, sample, dimension)
+// (Random.h), so a pixel's sample count is also the number of its next sample.
+//
+// Binary layout, in host byte order:
+//   "RTCKPT2\n"  magic and format version
+//   uint32       0x01020304, to reject files written with another byte order
+//   uint64       scene fingerprint (StreamingOutput::fingerprint)
+//   int32        width, height, target samples per pixel, shadows (0/1)
+//   float        eye xyz, look-at xyz, up xyz, FOV
+//   uint32       scene name length, then the name's bytes
+//   uint32       number of runs, then (count, length) uint32 pairs: the sample counts,
+//                run-length encoded (they only differ between tiles rendered in the last pass)
+//   float        accumulated red, green, blue of every pixel
+struct RenderCheckpoint {
+    // Frame settings: a checkpoint only resumes a render with the same ones.
+    std::string scene;
+    uint64_t fingerprint = 0; // Of the scene's contents, camera and sample count
+    int width = 0;
+    int height = 0;
+    int samples = 0; // Target samples per pixel
+    bool shadows = true;
+    Vec3f eye, lookAt, up;
+    float fov = 0.0f;
+
+    // Render state
+    std::vector<Vec3f> accumulation;    // Sum of each pixel's samples so far
+    std::vector<uint32_t> sampleCounts; // Samples in each sum
+
+    // Sizes the state for width x height with no samples taken.
+    void reset();
+
+    // True if `other` describes the same frame (all settings above). The fingerprint makes an
+    // edited scene file with the same name a different frame.
+    bool sameSettings(const RenderCheckpoint& other) const;
+
+    // Writes the checkpoint atomically: to `path`.tmp, flushed to disk, then renamed over `path`,
+    // so a crash leaves either the previous or the new checkpoint. Returns false and fills
+    // `error` if it cannot be written.
+    bool save(const std::string& path, std::string& error) const;
+
+    // Reads a checkpoint written by save(). Returns false and fills `error` if the file is
+    // missing, truncated or not a checkpoint.
+    bool load(const std::string& path, std::string& error);
+};
+
+// Saves checkpoints on a background thread, so the render only pays for copying its state.
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const std::string& path);
+    ~CheckpointWriter(); // finish()
+
+    // Starts writing a copy of `checkpoint` unless the previous one is still being written
+    // (then nothing happens and false is returned: the next call saves newer state anyway).
+    bool submit(const RenderCheckpoint& checkpoint);
+
+    // Waits for the checkpoint being written and stops the thread; later submissions are
+    // ignored. Returns false if any save failed.
+    bool finish();
+
+    int saved() const { return savedCount.load(); }
+
+private:
+    std::string path;
+    BoundedQueue<std::shared_ptr<RenderCheckpoint>> pending; // Holds at most one checkpoint
+    std::atomic<bool> busy;
+    std::atomic<bool> failed;
+    std::atomic<int> savedCount;
+    std::thread worker;
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+};
+
+#endif // CHECKPOINT_H
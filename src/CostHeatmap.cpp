@@ -0,0 +1,107 @@
+// src/CostHeatmap.cpp
+#include "CostHeatmap.h"
+#include "Parallel.h"
+#include "Utils.h"
+#include <algorithm> // For std::nth_element, std::max, std::min
+#include <chrono>    // For per-pixel timing
+
+const char* CostHeatmap::METRIC_NAMES[METRIC_COUNT] = { "Intersection Tests", "Shadow Rays", "Time (ns)" };
+
+namespace {
+    // Value of metric `m` stored in a cost pixel.
+    float component(const Vec3f& cost, int m) {
+        return m == 0 ? cost.x : (m == 1 ? cost.y : cost.z);
+    }
+
+    // False-color ramp over t in [0, 1].
+    Vec3f heatColor(float t) {
+        static const Vec3f STOPS[] = {
+            Vec3f(0.0f, 0.0f, 0.3f), // No cost
+            Vec3f(0.0f, 0.3f, 1.0f),
+            Vec3f(0.0f, 0.9f, 0.9f),
+            Vec3f(0.1f, 0.9f, 0.1f),
+            Vec3f(1.0f, 0.9f, 0.0f),
+            Vec3f(1.0f, 0.0f, 0.0f)  // At or above the scale
+        };
+        const int segments = sizeof(STOPS) / sizeof(STOPS[0]) - 1;
+        const float x = std::min(std::max(t, 0.0f), 1.0f) * segments;
+        const int k = std::min(static_cast<int>(x), segments - 1);
+        const float f = x - k;
+        return STOPS[k] * (1.0f - f) + STOPS[k + 1] * f;
+    }
+}
+
+CostHeatmap::CostHeatmap()
+    : metric(METRIC_INTERSECTION_TESTS), shadows(true), percentile(99.0f), scale(0.0f), width(0), height(0) {
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        totals[m] = 0.0;
+        maxima[m] = 0.0f;
+    }
+}
+
+void CostHeatmap::measure(const Scene& scene, const Camera& camera) {
+    typedef std::chrono::steady_clock Clock;
+    width = camera.imageWidth;
+    height = camera.imageHeight;
+    pixelCosts.assign(static_cast<size_t>(width) * height, Vec3f(0.0f));
+    // Scene::trace without candidates tests every object (no frustum culling on this path).
+    const long long primaryTests = static_cast<long long>(scene.objects.size());
+
+    Parallel::forEach(height, [&](int j) {
+        std::vector<float> visibility(scene.lights.size());
+        for (int i = 0; i < width; ++i) {
+            // Same work as Renderer::renderPixel with one sample per pixel.
+            Clock::time_point start = Clock::now();
+            long long tests = primaryTests;
+            int shadowRays = 0;
+            IntersectionInfo info;
+            Object* hitObject = nullptr;
+            if (scene.trace(camera.computePrimaryRay(i, j), info, hitObject)) {
+                for (size_t l = 0; l < scene.lights.size(); ++l) {
+                    visibility[l] = 1.0f;
+                    if (shadows) {
+                        ++shadowRays;
+                        visibility[l] = scene.isInShadow(info.point, scene.lights[l], &tests) ? 0.0f : 1.0f;
+                    }
+                }
+                scene.shade(info, hitObject, visibility.data()); // Part of the pixel's cost; the color is not needed
+            }
+            const float nanoseconds = std::chrono::duration<float, std::nano>(Clock::now() - start).count();
+            pixelCosts[j * width + i] = Vec3f(static_cast<float>(tests), static_cast<float>(shadowRays), nanoseconds);
+        }
+    });
+
+    for (int m = 0; m < METRIC_COUNT; ++m) {
+        totals[m] = 0.0;
+        maxima[m] = 0.0f;
+    }
+    for (const Vec3f& cost : pixelCosts) {
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            totals[m] += component(cost, m);
+            maxima[m] = std::max(maxima[m], component(cost, m));
+        }
+    }
+}
+
+void CostHeatmap::colorize(std::vector<Vec3f>& framebuffer) {
+    if (pixelCosts.empty()) {
+        return;
+    }
+    // Scale by a percentile rather than the maximum, so that a few outliers
+    // (e.g. a pixel whose thread was preempted) do not flatten the whole map.
+    std::vector<float> values(pixelCosts.size());
+    for (size_t k = 0; k < pixelCosts.size(); ++k) {
+        values[k] = component(pixelCosts[k], metric);
+    }
+    const size_t rank = static_cast<size_t>(std::min(std::max(percentile, 0.0f), 100.0f) / 100.0f * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    scale = values[rank] > 0.0f ? values[rank] : 1.0f;
+
+    for (size_t k = 0; k < pixelCosts.size() && k < framebuffer.size(); ++k) {
+        framebuffer[k] = heatColor(component(pixelCosts[k], metric) / scale);
+    }
+}
+
+bool CostHeatmap::savePFM(const std::string& filename) const {
+    return Utils::savePFMImage(filename, width, height, pixelCosts);
+}
@@ -0,0 +1,63 @@
+// src/CostHeatmap.h
+#ifndef COST_HEATMAP_H
+#define COST_HEATMAP_H
+
+#include <string>
+#include <vector>
+
+#include "Vec3.h"
+#include "Scene.h"
+#include "Camera.h"
+
+// Diagnostic view of where a frame's time goes.
+// Every pixel is rendered once through the per-pixel (Object interface) path while counting
+// its intersection tests and shadow rays and timing it, so expensive geometry stands out
+// and acceleration structures can be checked by their test counts. Only that scalar path is
+// measured: the SIMD kernels shade packets of pixels and cannot be attributed per pixel.
+// Its counts differ from the packet renderer's: every primary ray is tested against every
+// object (the renderer's frustum culling tests fewer, see Renderer::cullingStats), and each
+// shadow ray stops at its first blocker (the kernels test a packet until all its rays are).
+class CostHeatmap {
+public:
+    // Quantities measured per pixel.
+    enum Metric {
+        METRIC_INTERSECTION_TESTS = 0, // Object::hitDistance calls, primary and shadow rays together
+        METRIC_SHADOW_RAYS,            // Shadow rays cast
+        METRIC_TIME,                   // Nanoseconds spent on the pixel
+        METRIC_COUNT
+    };
+    static const char* METRIC_NAMES[METRIC_COUNT];
+
+    int metric;          // Metric shown by colorize()
+    bool shadows;        // Cast shadow rays (as Renderer::shadows)
+    float percentile;    // colorize() maps this percentile of the metric to the top of the scale
+
+    // Statistics of the last measure() call.
+    double totals[METRIC_COUNT];  // Sum over all pixels
+    float maxima[METRIC_COUNT];   // Most expensive pixel
+    float scale;                  // Value shown as the top color by the last colorize()
+
+    CostHeatmap();
+
+    // Renders the image of `camera` (camera resolution) and records the cost of every pixel.
+    // The rendered colors are discarded.
+    void measure(const Scene& scene, const Camera& camera);
+
+    // Writes the selected metric as a false-color image: dark blue (no cost) through cyan,
+    // green and yellow to red (at or above the percentile).
+    void colorize(std::vector<Vec3f>& framebuffer);
+
+    // Saves the raw costs as a float image: red = intersection tests, green = shadow rays,
+    // blue = nanoseconds.
+    bool savePFM(const std::string& filename) const;
+
+    // Costs of the last measure(), one Vec3f per pixel in the channel order of savePFM().
+    const std::vector<Vec3f>& costs() const { return pixelCosts; }
+
+private:
+    int width;
+    int height;
+    std::vector<Vec3f> pixelCosts;
+};
+
+#endif // COST_HEATMAP_H
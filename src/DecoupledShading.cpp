@@ -0,0 +1,179 @@
+// src/DecoupledShading.cpp
+#include "DecoupledShading.h"
+#include "Parallel.h"
+#include <algorithm> // For std::min
+#include <atomic>    // For std::atomic
+#include <cmath>     // For std::fabs
+
+DecoupledShading::DecoupledShading()
+    : rate(2), normalThreshold(0.9f), depthThreshold(0.05f), refineShadowEdges(true),
+      shadowRays(0), fullRateRays(0), fallbackPixels(0), refinedPixels(0),
+      memory(MemoryTracker::MEMORY_RENDER_CACHES) {}
+
+void DecoupledShading::release() {
+    gbuf.release();
+    std::vector<float>().swap(latticeVisibility);
+    std::vector<unsigned char>().swap(latticeValid);
+    memory.set(0);
+}
+
+float DecoupledShading::edgeWeight(int pixel, int sample) const {
+    if (gbuf.object[sample] != gbuf.object[pixel]) {
+        return 0.0f; // Object boundary
+    }
+    if (gbuf.normal[pixel].dot(gbuf.normal[sample]) < normalThreshold) {
+        return 0.0f; // Crease or strongly curved region
+    }
+    if (std::fabs(gbuf.depth[pixel] - gbuf.depth[sample]) > depthThreshold * gbuf.depth[pixel]) {
+        return 0.0f; // Depth discontinuity
+    }
+    return 1.0f;
+}
+
+void DecoupledShading::render(const Scene& scene, const Camera& camera, std::vector<Vec3f>& framebuffer) {
+    const int width = camera.imageWidth;
+    const int height = camera.imageHeight;
+    const int lightCount = static_cast<int>(scene.lights.size());
+    const int step = rate < 1 ? 1 : rate;
+    if (gbuf.width != width || gbuf.height != height) {
+        gbuf.resize(width, height);
+    }
+
+    // 1. Visibility at full rate: one primary ray per pixel into the G-buffer.
+    Parallel::forEach(height, [&](int j) {
+        for (int i = 0; i < width; ++i) {
+            int index = j * width + i;
+            IntersectionInfo info;
+            Object* hitObject = nullptr;
+            scene.trace(camera.computePrimaryRay(i, j), info, hitObject);
+            gbuf.object[index] = hitObject;
+            if (hitObject) {
+                gbuf.position[index] = info.point;
+                gbuf.normal[index] = info.normal;
+                gbuf.depth[index] = info.distance;
+            }
+        }
+    });
+
+    // 2. Shadows at reduced rate: per-light visibility on a lattice with `step` pixel spacing.
+    // The lattice has one extra row/column so every pixel has four surrounding samples.
+    const int latticeWidth = (width - 1) / step + 2;
+    const int latticeHeight = (height - 1) / step + 2;
+    latticeVisibility.assign(latticeWidth * latticeHeight * lightCount, 0.0f);
+    latticeValid.assign(latticeWidth * latticeHeight, 0);
+    memory.set(gbuf.bytes() + MemoryTracker::capacityBytes(latticeVisibility) + MemoryTracker::capacityBytes(latticeValid));
+    std::atomic<long long> rays(0);
+    auto samplePixel = [&](int cx, int cy) {
+        return std::min(cy * step, height - 1) * width + std::min(cx * step, width - 1);
+    };
+
+    Parallel::forEach(latticeHeight, [&](int cy) {
+        long long rowRays = 0;
+        for (int cx = 0; cx < latticeWidth; ++cx) {
+            int pixel = samplePixel(cx, cy);
+            if (!gbuf.object[pixel]) {
+                continue;
+            }
+            int sample = cy * latticeWidth + cx;
+            latticeValid[sample] = 1;
+            for (int l = 0; l < lightCount; ++l) {
+                latticeVisibility[sample * lightCount + l] = scene.isInShadow(gbuf.position[pixel], scene.lights[l]) ? 0.0f : 1.0f;
+            }
+            rowRays += lightCount;
+        }
+        rays += rowRays;
+    });
+
+    // 3. Edge-aware upsampling and per-pixel shading.
+    std::atomic<int> fallbacks(0);
+    std::atomic<int> refined(0);
+    Parallel::forEach(height, [&](int j) {
+        std::vector<float> visibility(lightCount);
+        std::vector<float> minVisibility(lightCount);
+        std::vector<float> maxVisibility(lightCount);
+        long long rowRays = 0;
+        int rowFallbacks = 0;
+        int rowRefined = 0;
+
+        for (int i = 0; i < width; ++i) {
+            int index = j * width + i;
+            const Object* obj = gbuf.object[index];
+            if (!obj) {
+                framebuffer[index] = scene.backgroundColor;
+                continue;
+            }
+
+            // Bilinear weights of the four surrounding lattice samples, zeroed across edges.
+            int cx0 = i / step;
+            int cy0 = j / step;
+            float fx = static_cast<float>(i - cx0 * step) / step;
+            float fy = static_cast<float>(j - cy0 * step) / step;
+            float weightSum = 0.0f;
+            std::fill(visibility.begin(), visibility.end(), 0.0f);
+            std::fill(minVisibility.begin(), minVisibility.end(), 1.0f);
+            std::fill(maxVisibility.begin(), maxVisibility.end(), 0.0f);
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    float bilinear = (dx ? fx : 1.0f - fx) * (dy ? fy : 1.0f - fy);
+                    int sample = (cy0 + dy) * latticeWidth + (cx0 + dx);
+                    if (bilinear <= 0.0f || !latticeValid[sample]) {
+                        continue;
+                    }
+                    float weight = bilinear * edgeWeight(index, samplePixel(cx0 + dx, cy0 + dy));
+                    if (weight <= 0.0f) {
+                        continue;
+                    }
+                    weightSum += weight;
+                    for (int l = 0; l < lightCount; ++l) {
+                        float v = latticeVisibility[sample * lightCount + l];
+                        visibility[l] += weight * v;
+                        minVisibility[l] = std::min(minVisibility[l], v);
+                        maxVisibility[l] = std::max(maxVisibility[l], v);
+                    }
+                }
+            }
+
+            // Fall back to full-rate shadow rays at discontinuities (no compatible sample)
+            // and, optionally, on shadow boundaries where the samples disagree.
+            bool fullRate = weightSum <= 1e-4f;
+            if (fullRate) {
+                ++rowFallbacks;
+            } else {
+                for (int l = 0; l < lightCount; ++l) {
+                    visibility[l] /= weightSum;
+                    if (refineShadowEdges && minVisibility[l] != maxVisibility[l]) {
+                        fullRate = true;
+                    }
+                }
+                if (fullRate) {
+                    ++rowRefined;
+                }
+            }
+            if (fullRate) {
+                for (int l = 0; l < lightCount; ++l) {
+                    visibility[l] = scene.isInShadow(gbuf.position[index], scene.lights[l]) ? 0.0f : 1.0f;
+                }
+                rowRays += lightCount;
+            }
+
+            IntersectionInfo info;
+            info.point = gbuf.position[index];
+            info.normal = gbuf.normal[index];
+            info.distance = gbuf.depth[index];
+            framebuffer[index] = scene.shade(info, obj, visibility.data());
+        }
+        rays += rowRays;
+        fallbacks += rowFallbacks;
+        refined += rowRefined;
+    });
+
+    // Count the shadow rays a full-rate render would have needed for comparison.
+    long long hitPixels = 0;
+    for (const Object* obj : gbuf.object) {
+        hitPixels += obj ? 1 : 0;
+    }
+    shadowRays = rays;
+    fullRateRays = hitPixels * lightCount;
+    fallbackPixels = fallbacks;
+    refinedPixels = refined;
+}
@@ -0,0 +1,55 @@
+// src/DecoupledShading.h
+#ifndef DECOUPLED_SHADING_H
+#define DECOUPLED_SHADING_H
+
+#include <vector>
+
+#include "Vec3.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "GBuffer.h"
+#include "MemoryTracker.h"
+
+// Renders with visibility at full resolution but shadows at a reduced rate.
+// Primary rays are traced for every pixel into a G-buffer (position, normal, depth, object).
+// Shadow rays are only cast on a coarse lattice with one sample every `rate` pixels,
+// and each pixel interpolates the per-light visibility of the four surrounding lattice
+// samples. Samples on a different object, or whose normal or depth differ too much,
+// get zero weight (edge-aware upsampling); a pixel without any compatible sample falls
+// back to casting its own shadow rays. Diffuse N.L is always evaluated per pixel.
+class DecoupledShading {
+public:
+    int rate;                // Lattice spacing in pixels (1 = full rate, 2 = 2x2, 4 = 4x4)
+    float normalThreshold;   // Minimum N.N' between a pixel and a lattice sample
+    float depthThreshold;    // Maximum relative depth difference between a pixel and a lattice sample
+    bool refineShadowEdges;  // Trace full-rate shadow rays where compatible samples disagree
+
+    // Statistics of the last render() call.
+    long long shadowRays;     // Shadow rays actually cast
+    long long fullRateRays;   // Shadow rays a full-rate render would have cast
+    int fallbackPixels;       // Pixels shaded at full rate (geometric discontinuities)
+    int refinedPixels;        // Pixels shaded at full rate on shadow boundaries
+
+    DecoupledShading();
+
+    // Renders the image of `camera` into `framebuffer` (camera resolution).
+    void render(const Scene& scene, const Camera& camera, std::vector<Vec3f>& framebuffer);
+
+    // Frees the G-buffer and lattice, e.g. when another render mode is selected or to stay
+    // within the memory budget. The next render() allocates them again.
+    void release();
+
+    // The G-buffer of the last frame (valid after render()).
+    const GBuffer& gbuffer() const { return gbuf; }
+
+private:
+    GBuffer gbuf;
+    std::vector<float> latticeVisibility; // lightCount floats per lattice sample
+    std::vector<unsigned char> latticeValid; // 1 if the lattice sample hit a surface
+    MemoryTracker::Account memory;           // Bytes of the buffers above (render caches)
+
+    // Weight of lattice sample `sample` for shading pixel `pixel` (0 if incompatible).
+    float edgeWeight(int pixel, int sample) const;
+};
+
+#endif // DECOUPLED_SHADING_H
@@ -0,0 +1,109 @@
+// src/Denoiser.cpp
+#include "Denoiser.h"
+#include "Kernels.h"
+#include "Parallel.h"
+#include <algorithm> // For std::min
+#include <chrono>    // For lastMilliseconds
+
+void DenoiseFeatures::resize(int w, int h) {
+    width = w;
+    height = h;
+    stride = PADDING + (w + 15) / 16 * 16 + PADDING; // Rows start aligned to 16 floats
+    const size_t count = static_cast<size_t>(stride) * h;
+    for (std::vector<float>* v : { &normalX, &normalY, &normalZ, &depth }) {
+        v->assign(count, 0.0f);
+    }
+    objectKey.assign(count, -2.0f);
+}
+
+const int DenoiseFeatures::PADDING;
+const int Denoiser::MAX_ITERATIONS;
+
+Denoiser::Denoiser()
+    : iterations(4), colorSigma(0.5f), normalSigma(0.1f), depthSigma(0.05f), lastMilliseconds(0.0),
+      memory(MemoryTracker::MEMORY_RENDER_CACHES) {}
+
+DenoiseFeatures* Denoiser::prepare(int width, int height) {
+    if (features.width != width || features.height != height) {
+        features.resize(width, height);
+        size_t bytes = 0;
+        for (const std::vector<float>* v : { &features.normalX, &features.normalY, &features.normalZ, &features.depth,
+                                             &features.objectKey }) {
+            bytes += MemoryTracker::capacityBytes(*v);
+        }
+        for (std::vector<float>& plane : planes) {
+            plane.assign(features.normalX.size(), 0.0f); // The padding stays zero
+            bytes += MemoryTracker::capacityBytes(plane);
+        }
+        memory.set(bytes);
+    }
+    return &features;
+}
+
+void Denoiser::release() {
+    features = DenoiseFeatures();
+    for (std::vector<float>& plane : planes) {
+        std::vector<float>().swap(plane);
+    }
+    memory.set(0);
+}
+
+void Denoiser::filter(std::vector<Vec3f>& framebuffer) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const int width = features.width;
+    const int height = features.height;
+    if (iterations <= 0 || width == 0 || framebuffer.size() < static_cast<size_t>(width) * height) {
+        return;
+    }
+
+    // To planar color, the layout the kernel reads. The features already are.
+    Parallel::forEach(height, [&](int j) {
+        const size_t row = features.offset(0, j);
+        for (int i = 0, k = j * width; i < width; ++i, ++k) {
+            planes[0][row + i] = framebuffer[k].x;
+            planes[1][row + i] = framebuffer[k].y;
+            planes[2][row + i] = framebuffer[k].z;
+        }
+    });
+
+    const Kernels::KernelSet& kernels = Kernels::active();
+    const size_t origin = features.offset(0, 0);
+    Kernels::AtrousPass pass;
+    pass.width = width;
+    pass.height = height;
+    pass.stride = features.stride;
+    pass.normalX = features.normalX.data() + origin;
+    pass.normalY = features.normalY.data() + origin;
+    pass.normalZ = features.normalZ.data() + origin;
+    pass.depth = features.depth.data() + origin;
+    pass.objectKey = features.objectKey.data() + origin;
+    pass.normalWeight = 1.0f / normalSigma;
+    float colorScale = 1.0f / (colorSigma * colorSigma);
+    int source = 0;
+    for (int i = 0; i < std::min(iterations, MAX_ITERATIONS); ++i) {
+        const int target = 3 - source;
+        pass.step = 1 << i;
+        pass.red = planes[source].data() + origin;
+        pass.green = planes[source + 1].data() + origin;
+        pass.blue = planes[source + 2].data() + origin;
+        pass.outRed = planes[target].data() + origin;
+        pass.outGreen = planes[target + 1].data() + origin;
+        pass.outBlue = planes[target + 2].data() + origin;
+        pass.colorWeight = colorScale;
+        pass.depthWeight = 1.0f / (depthSigma * pass.step); // Taps further apart may differ more in depth
+        Parallel::forEach(height, [&](int j) {
+            kernels.atrousRow(pass, j);
+        });
+        colorScale *= 4.0f; // The color tolerance halves with every pass
+        source = target;
+    }
+
+    Parallel::forEach(height, [&](int j) {
+        const size_t row = features.offset(0, j);
+        for (int i = 0, k = j * width; i < width; ++i, ++k) {
+            framebuffer[k] = Vec3f(planes[source][row + i], planes[source + 1][row + i], planes[source + 2][row + i]);
+        }
+    });
+    lastMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
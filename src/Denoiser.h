@@ -0,0 +1,84 @@
+// src/Denoiser.h
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+
+#include "Vec3.h"
+#include "MemoryTracker.h"
+
+// Primary-hit features of every pixel, recorded by Renderer while it traces (Renderer::features).
+// Stored the way the filter kernel reads them (see Kernels::AtrousPass), so the filter uses them
+// as they are: planar (one array per component) for vector loads, with PADDING floats of
+// background on both sides of every row so that taps need no bounds checks, and the object as a
+// key that the kernel folds into the tap weight.
+struct DenoiseFeatures {
+    static const int PADDING = 32; // Floats before every row and at least as many after it
+
+    int width = 0;
+    int height = 0;
+    int stride = 0;                               // Floats per row, padding included
+    std::vector<float> normalX, normalY, normalZ; // Zero for background pixels
+    std::vector<float> depth;                     // Distance to the hit, 0 for background pixels
+    std::vector<float> objectKey;                 // Twice the index in Scene::objects, -2 for the background
+
+    void resize(int w, int h);
+
+    // Position of pixel (x, y) in the arrays.
+    size_t offset(int x, int y) const { return static_cast<size_t>(y) * stride + PADDING + x; }
+
+    // Records the primary hit of pixel (x, y) (object < 0 for the background).
+    void set(int x, int y, const Vec3f& n, float distance, int objectIndex) {
+        const size_t k = offset(x, y);
+        normalX[k] = n.x;
+        normalY[k] = n.y;
+        normalZ[k] = n.z;
+        depth[k] = objectIndex < 0 ? 0.0f : distance;
+        objectKey[k] = objectIndex < 0 ? -2.0f : 2.0f * static_cast<float>(objectIndex);
+    }
+};
+
+// Edge-aware a-trous wavelet filter ("Edge-Avoiding A-Trous Wavelet Transform for fast Global
+// Illumination Filtering", Dammertz et al. 2010), applied to a finished image so that a few
+// samples per pixel look like many.
+//
+// Each pass convolves with a 3x3 B-spline kernel (1/4, 1/2, 1/4) whose taps lie `2^pass` pixels
+// apart, so four passes cover a 31x31 pixel footprint at 9 taps per pixel and pass (the paper's
+// 5x5 kernel costs nearly three times as much for a similar result). Taps lose weight with their
+// color, normal and depth difference to the center pixel and are ignored on other objects, which
+// keeps object outlines, creases and shadow edges sharp while noise within a surface is averaged
+// out. The color tolerance halves with every pass, as in the paper. Background pixels are left as
+// rendered. Rows are filtered in parallel through the SIMD kernels (KernelSet::atrousRow).
+class Denoiser {
+public:
+    // Most passes the padding of DenoiseFeatures allows (taps 32 pixels apart).
+    static const int MAX_ITERATIONS = 6;
+
+    int iterations;     // Passes (0 = no filtering, at most MAX_ITERATIONS)
+    float colorSigma;   // Color difference that strongly reduces a tap's weight in the first pass
+    float normalSigma;  // Same for 1 - N.N' between the tap and the center pixel
+    float depthSigma;   // Same for the depth difference relative to the center depth, per pixel of tap spacing
+
+    double lastMilliseconds; // Duration of the last filter() call
+
+    Denoiser();
+
+    // Feature buffers for an image of the given size, to be filled while rendering it
+    // (pass them as Renderer::features).
+    DenoiseFeatures* prepare(int width, int height);
+
+    // Filters `framebuffer` in place, guided by the features recorded for it since prepare().
+    void filter(std::vector<Vec3f>& framebuffer);
+
+    // Frees the feature and work buffers (e.g. to stay within the memory budget).
+    // The next prepare() allocates them again.
+    void release();
+
+private:
+    DenoiseFeatures features;
+    std::vector<float> planes[6];  // Two sets of red/green/blue planes in the layout of the features,
+                                   // read and written alternately
+    MemoryTracker::Account memory; // Bytes of the buffers above (render caches)
+};
+
+#endif // DENOISER_H
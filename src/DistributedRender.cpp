@@ -0,0 +1,417 @@
+// src/DistributedRender.cpp
+#include "DistributedRender.h"
+#include "Renderer.h"
+#include "SceneCache.h"
+#include "Utils.h"
+#include "Net.h"
+#include "Tile.h"
+#include "PixelFormat.h"
+#include "MemoryTracker.h"
+#include <deque>
+#include <memory>
+#include <sstream>  // For std::istringstream
+#include <chrono>   // For std::chrono::steady_clock
+#include <thread>   // For std::this_thread::sleep_for
+#include <algorithm> // For std::find, std::find_if, std::min
+#include <cstdio>   // For fprintf
+
+#ifndef _WIN32
+#include <poll.h>     // For poll
+#include <unistd.h>   // For fork, execv, getpid
+#include <sys/wait.h> // For waitpid
+#endif
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // Names of the tile formats in the FRAME line, in PixelFormat order.
+    const char* const TILE_FORMAT_KEYS[PIXEL_FORMAT_COUNT] = { "rgb32f", "rgb16f", "rgb9e5" };
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Coordinator-side view of one connection, from before its HELLO until it is closed.
+    // The coordinator never blocks on a worker: bytes are collected in `inbox` as they arrive
+    // and handled once a complete line or tile is there.
+    struct WorkerState {
+        int fd;
+        std::string name;
+        bool alive;
+        bool greeted;                  // HELLO received and FRAME sent
+        std::string inbox;             // Received bytes not handled yet
+        int receivingTile;             // Tile whose pixels follow a DONE line (-1: expecting a line)
+        size_t receivingBytes;
+        std::vector<int> inFlight;     // Tile indices assigned but not yet returned
+        int tilesDone;
+        long long pixelsDone;
+        Clock::time_point connected;
+        Clock::time_point lastProgress; // Last returned tile, or when the oldest in-flight tile was assigned
+        Clock::time_point firstAssigned;
+        Clock::time_point lastCompleted;
+        bool started;
+    };
+
+    // Longest line a worker may send (HELLO or DONE); anything longer is not our protocol.
+    const size_t MAX_LINE = 4096;
+
+    // Takes the next complete line out of `inbox`. Returns false if none has arrived yet.
+    bool takeLine(std::string& inbox, std::string& line) {
+        std::string::size_type end = inbox.find('\n');
+        if (end == std::string::npos) {
+            return false;
+        }
+        line = inbox.substr(0, end);
+        inbox.erase(0, end + 1);
+        return true;
+    }
+}
+
+#ifndef _WIN32
+
+int runCoordinator(const CoordinatorOptions& options, const RenderJob& job, const std::string& outputPath) {
+    int listenFd = Net::listenOn(options.address);
+    if (listenFd < 0 || !Net::setNonBlocking(listenFd)) {
+        fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+        return -1;
+    }
+
+    // Split the frame into tiles.
+    std::vector<Tile> tiles;
+    for (int y = 0; y < job.height; y += options.tileSize) {
+        for (int x = 0; x < job.width; x += options.tileSize) {
+            Tile tile = { x, y, std::min(x + options.tileSize, job.width), std::min(y + options.tileSize, job.height) };
+            tiles.push_back(tile);
+        }
+    }
+    std::deque<int> pending;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        pending.push_back(static_cast<int>(t));
+    }
+    std::vector<unsigned char> done(tiles.size(), 0);
+    std::vector<Vec3f> framebuffer(static_cast<size_t>(job.width) * job.height);
+    MemoryTracker::Account framebufferMemory(MemoryTracker::MEMORY_FRAMEBUFFERS);
+    framebufferMemory.set(MemoryTracker::capacityBytes(framebuffer));
+    int completed = 0;
+    int retried = 0;
+
+    // Start the local workers: this same executable, found through /proc/self/exe (argv[0] need
+    // not be a path, e.g. when the program was started from PATH), or through PATH without /proc.
+    std::vector<pid_t> children;
+    for (int w = 0; w < options.spawnWorkers; ++w) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            const char* args[] = { options.program.c_str(), "--worker", options.address.c_str(), nullptr };
+            execv("/proc/self/exe", const_cast<char* const*>(args));
+            execvp(options.program.c_str(), const_cast<char* const*>(args));
+            _exit(127); // exec failed
+        }
+        if (pid > 0) {
+            children.push_back(pid);
+        }
+    }
+    fprintf(stdout, "Coordinator on %s: %dx%d, %d spp, %zu tiles, %zu local workers\n", options.address.c_str(),
+            job.width, job.height, job.samples, tiles.size(), children.size());
+
+    std::vector<std::unique_ptr<WorkerState> > workers;
+    const std::string frameLine = std::string("FRAME ") + TILE_FORMAT_KEYS[options.tileFormat] + " " + job.toString();
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastWorkerSeen = start;
+
+    // Drops a worker and puts its unfinished tiles back at the front of the queue.
+    auto retire = [&](WorkerState& worker) {
+        if (!worker.alive) {
+            return;
+        }
+        worker.alive = false;
+        Net::closeSocket(worker.fd);
+        for (size_t k = worker.inFlight.size(); k-- > 0;) {
+            pending.push_front(worker.inFlight[k]);
+            ++retried;
+        }
+        if (!worker.inFlight.empty()) {
+            fprintf(stdout, "Worker %s lost, re-queued %zu tiles\n", worker.name.c_str(), worker.inFlight.size());
+        }
+        worker.inFlight.clear();
+    };
+
+    // Tops up a worker's queue of assigned tiles.
+    auto assign = [&](WorkerState& worker) {
+        while (worker.alive && worker.greeted && static_cast<int>(worker.inFlight.size()) < options.tilesInFlight && !pending.empty()) {
+            int index = pending.front();
+            pending.pop_front();
+            if (done[index]) {
+                continue;
+            }
+            const Tile& tile = tiles[index];
+            std::ostringstream command;
+            command << "TILE " << index << " " << tile.x0 << " " << tile.y0 << " " << tile.x1 << " " << tile.y1;
+            if (worker.inFlight.empty()) {
+                worker.lastProgress = Clock::now(); // The tile deadline starts now
+            }
+            worker.inFlight.push_back(index);
+            if (!worker.started) {
+                worker.started = true;
+                worker.firstAssigned = Clock::now();
+            }
+            if (!Net::sendLine(worker.fd, command.str())) {
+                retire(worker);
+            }
+        }
+    };
+
+    // Handles what a worker sent: its HELLO, then DONE lines each followed by a tile's pixels.
+    // Returns false if the worker broke the protocol.
+    auto handleInput = [&](WorkerState& worker) {
+        for (;;) {
+            if (worker.receivingTile >= 0) {
+                if (worker.inbox.size() < worker.receivingBytes) {
+                    return true; // The rest of the tile is still on its way
+                }
+                const int index = worker.receivingTile;
+                const Tile& tile = tiles[index];
+                std::vector<Vec3f> pixels(tile.pixelCount());
+                PixelPacking::unpack(options.tileFormat, reinterpret_cast<const unsigned char*>(worker.inbox.data()),
+                                     pixels.size(), pixels.data());
+                worker.inbox.erase(0, worker.receivingBytes);
+                worker.receivingTile = -1;
+                worker.inFlight.erase(std::find(worker.inFlight.begin(), worker.inFlight.end(), index));
+
+                // Assemble the tile into the frame.
+                if (!done[index]) {
+                    for (int y = tile.y0; y < tile.y1; ++y) {
+                        std::copy(pixels.begin() + (y - tile.y0) * tile.width(), pixels.begin() + (y - tile.y0 + 1) * tile.width(),
+                                  framebuffer.begin() + static_cast<size_t>(y) * job.width + tile.x0);
+                    }
+                    done[index] = 1;
+                    ++completed;
+                }
+                ++worker.tilesDone;
+                worker.pixelsDone += tile.pixelCount();
+                worker.lastCompleted = Clock::now();
+                worker.lastProgress = worker.lastCompleted;
+                assign(worker);
+                continue;
+            }
+
+            std::string line;
+            if (!takeLine(worker.inbox, line)) {
+                return worker.inbox.size() <= MAX_LINE;
+            }
+            if (!worker.greeted) {
+                // New worker: greet it with the frame and give it work.
+                if (line.compare(0, 6, "HELLO ") != 0 || !Net::sendLine(worker.fd, frameLine)) {
+                    return false;
+                }
+                worker.name = line.substr(6);
+                worker.greeted = true;
+                assign(worker);
+                continue;
+            }
+
+            std::istringstream reply(line);
+            std::string kind;
+            int index = -1;
+            size_t bytes = 0;
+            reply >> kind >> index >> bytes;
+            if (kind != "DONE" || std::find(worker.inFlight.begin(), worker.inFlight.end(), index) == worker.inFlight.end() ||
+                bytes != static_cast<size_t>(tiles[index].pixelCount()) * PixelPacking::bytesPerPixel(options.tileFormat)) {
+                fprintf(stderr, "Worker %s sent an invalid reply: %s\n", worker.name.c_str(), line.c_str());
+                return false;
+            }
+            worker.receivingTile = index;
+            worker.receivingBytes = bytes;
+        }
+    };
+
+    while (completed < static_cast<int>(tiles.size())) {
+        std::vector<pollfd> fds;
+        pollfd listenPoll = { listenFd, POLLIN, 0 };
+        fds.push_back(listenPoll);
+        std::vector<WorkerState*> polled;
+        bool anyGreeted = false;
+        for (std::unique_ptr<WorkerState>& worker : workers) {
+            if (worker->alive) {
+                pollfd workerPoll = { worker->fd, POLLIN, 0 };
+                fds.push_back(workerPoll);
+                polled.push_back(worker.get());
+                anyGreeted = anyGreeted || worker->greeted;
+            }
+        }
+        if (anyGreeted) {
+            lastWorkerSeen = Clock::now();
+        } else if (secondsSince(lastWorkerSeen) > options.idleTimeoutSec) {
+            fprintf(stderr, "Error: no workers connected for %.0f s, %d of %zu tiles missing\n",
+                    options.idleTimeoutSec, static_cast<int>(tiles.size()) - completed, tiles.size());
+            break;
+        }
+
+        if (poll(&fds[0], fds.size(), 200) > 0) {
+            // New connections; they become workers once their HELLO arrives.
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = Net::acceptClient(listenFd)) >= 0) {
+                    std::unique_ptr<WorkerState> worker(new WorkerState());
+                    worker->fd = fd;
+                    worker->alive = true;
+                    worker->greeted = false;
+                    worker->receivingTile = -1;
+                    worker->receivingBytes = 0;
+                    worker->tilesDone = 0;
+                    worker->pixelsDone = 0;
+                    worker->connected = Clock::now();
+                    worker->started = false;
+                    workers.push_back(std::move(worker));
+                }
+            }
+
+            // Whatever the workers sent: greetings, finished tiles, or parts of them.
+            for (size_t p = 0; p < polled.size(); ++p) {
+                WorkerState& worker = *polled[p];
+                if ((fds[p + 1].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                    (!Net::recvAvailable(worker.fd, worker.inbox) | !handleInput(worker))) {
+                    retire(worker); // Tiles that arrived completely before the hang-up were kept above
+                }
+            }
+        }
+
+        // Deadlines: connections that never say HELLO, and workers that stop returning tiles
+        // (hung, but with the connection still open) lose their tiles to the others.
+        for (std::unique_ptr<WorkerState>& worker : workers) {
+            if (!worker->alive) {
+                continue;
+            }
+            if (!worker->greeted && secondsSince(worker->connected) > options.helloTimeoutSec) {
+                fprintf(stdout, "Connection without HELLO closed after %.0f s\n", options.helloTimeoutSec);
+                retire(*worker);
+            } else if (!worker->inFlight.empty() && secondsSince(worker->lastProgress) > options.tileTimeoutSec) {
+                fprintf(stdout, "Worker %s returned no tile for %.0f s\n", worker->name.c_str(), options.tileTimeoutSec);
+                retire(*worker);
+            }
+        }
+
+        // Hand tiles re-queued from a dead worker to the survivors.
+        for (std::unique_ptr<WorkerState>& worker : workers) {
+            assign(*worker);
+        }
+    }
+
+    double elapsed = secondsSince(start);
+    for (std::unique_ptr<WorkerState>& worker : workers) {
+        if (worker->alive) {
+            Net::sendLine(worker->fd, "BYE");
+            Net::closeSocket(worker->fd);
+        }
+    }
+    Net::closeSocket(listenFd);
+    if (options.address.find('/') != std::string::npos) {
+        unlink(options.address.c_str());
+    }
+    for (pid_t child : children) {
+        waitpid(child, NULL, 0);
+    }
+
+    // Per-worker throughput report.
+    fprintf(stdout, "%-24s %8s %10s %10s %s\n", "worker", "tiles", "Mpixels", "Mpix/s", "status");
+    for (std::unique_ptr<WorkerState>& worker : workers) {
+        if (!worker->greeted) {
+            continue; // Never became a worker
+        }
+        double busy = worker->started && worker->tilesDone > 0
+            ? std::chrono::duration<double>(worker->lastCompleted - worker->firstAssigned).count() : 0.0;
+        fprintf(stdout, "%-24s %8d %10.3f %10.3f %s\n", worker->name.c_str(), worker->tilesDone,
+                worker->pixelsDone / 1e6, busy > 0.0 ? worker->pixelsDone / 1e6 / busy : 0.0,
+                worker->alive ? "ok" : "lost");
+    }
+    fprintf(stdout, "Frame: %d/%zu tiles in %.3f s (%d tiles retried)\n", completed, tiles.size(), elapsed, retried);
+
+    if (completed < static_cast<int>(tiles.size())) {
+        return -1;
+    }
+    Utils::savePPMImage(outputPath, job.width, job.height, framebuffer);
+    return 0;
+}
+
+int runWorker(const std::string& address) {
+    // The coordinator may still be starting up: retry the connection for a few seconds.
+    int fd = -1;
+    for (int attempt = 0; attempt < 50 && fd < 0; ++attempt) {
+        fd = Net::connectTo(address);
+        if (fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    if (fd < 0 || !Net::sendLine(fd, "HELLO worker-" + std::to_string(getpid()))) {
+        fprintf(stderr, "Worker error: %s\n", Net::lastError().c_str());
+        return -1;
+    }
+
+    SceneCache cache; // Scenes stay resident across frames
+    std::shared_ptr<const Scene> scene;
+    std::unique_ptr<Camera> camera;
+    std::shared_ptr<const Kernels::PacketScene> packetScene; // The kernels' copy of `scene`, shared by its tiles
+    PixelFormat tileFormat = PIXEL_RGB32F;
+    RenderJob job;
+    std::vector<Vec3f> pixels;
+    std::vector<unsigned char> packed;
+    std::string line;
+
+    while (Net::recvLine(fd, line)) {
+        std::istringstream command(line);
+        std::string kind;
+        command >> kind;
+
+        if (kind == "FRAME") {
+            std::string format, spec, error;
+            command >> format;
+            std::getline(command, spec);
+            const char* const* key = std::find_if(TILE_FORMAT_KEYS, TILE_FORMAT_KEYS + PIXEL_FORMAT_COUNT,
+                                                  [&](const char* name) { return format == name; });
+            if (key == TILE_FORMAT_KEYS + PIXEL_FORMAT_COUNT) {
+                fprintf(stderr, "Worker error: unknown tile format %s\n", format.c_str());
+                break;
+            }
+            tileFormat = static_cast<PixelFormat>(key - TILE_FORMAT_KEYS);
+            job = RenderJob();
+            SceneCamera sceneCamera;
+            if (!job.parse(spec, error) || !(scene = cache.acquire(job.scene, sceneCamera, packetScene, error))) {
+                fprintf(stderr, "Worker error: %s\n", error.c_str());
+                break; // The coordinator re-queues our tiles when the connection drops
+            }
+            camera.reset(new Camera(job.makeCamera(sceneCamera)));
+        } else if (kind == "TILE" && scene) {
+            int index;
+            Tile tile;
+            command >> index >> tile.x0 >> tile.y0 >> tile.x1 >> tile.y1;
+            Renderer renderer(scene.get(), camera.get(), *packetScene);
+            renderer.samplesPerPixel = job.samples;
+            pixels.resize(tile.pixelCount());
+            renderer.renderTile(tile, pixels.data(), tile.width());
+
+            packed.resize(pixels.size() * PixelPacking::bytesPerPixel(tileFormat));
+            PixelPacking::pack(tileFormat, pixels.data(), pixels.size(), packed.data());
+            if (!Net::sendLine(fd, "DONE " + std::to_string(index) + " " + std::to_string(packed.size())) ||
+                !Net::sendAll(fd, packed.data(), packed.size())) {
+                break;
+            }
+        } else if (kind == "BYE") {
+            break;
+        }
+    }
+    Net::closeSocket(fd);
+    return 0;
+}
+
+#else // _WIN32: distributed rendering needs POSIX processes and sockets.
+
+int runCoordinator(const CoordinatorOptions&, const RenderJob&, const std::string&) {
+    fprintf(stderr, "Error: distributed rendering is not supported on this platform\n");
+    return -1;
+}
+
+int runWorker(const std::string&) {
+    fprintf(stderr, "Error: distributed rendering is not supported on this platform\n");
+    return -1;
+}
+
+#endif
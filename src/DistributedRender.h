@@ -0,0 +1,44 @@
+// src/DistributedRender.h
+#ifndef DISTRIBUTED_RENDER_H
+#define DISTRIBUTED_RENDER_H
+
+#include <string>
+
+#include "RenderService.h"
+#include "PixelFormat.h"
+
+// Splits one frame into tiles and renders them on worker processes.
+//
+// The coordinator listens on `address` (socket path or [host:]port, see Net.h).
+// Workers connect, announce themselves with "HELLO <name>" and receive the frame as
+// "FRAME <format> <job>". Tiles are handed out as "TILE <index> <x0> <y0> <x1> <y1>" and come
+// back as "DONE <index> <bytes>" followed by the tile's pixels in <format> (rgb32f, rgb16f or
+// rgb9e5, see PixelFormat.h). The default RGB32F frame is identical to a local render; the
+// smaller formats round the pixels.
+// Every worker keeps a small number of tiles in flight and gets a new one whenever it
+// returns one, so fast workers automatically take more of the frame. Tiles held by a
+// worker whose connection drops, or which returns none of them for `tileTimeoutSec`
+// (hung with the connection still open), are put back at the front of the queue and
+// rendered by the others. The coordinator never waits on a single connection, so a
+// client that connects but never says HELLO, or stalls halfway through a tile, only
+// costs its own slot; it is closed after `helloTimeoutSec` or `tileTimeoutSec`.
+struct CoordinatorOptions {
+    std::string address;        // Where workers connect
+    int spawnWorkers = 0;       // Local worker processes to start (more may connect on their own)
+    int tileSize = 32;          // Tile edge length in pixels
+    int tilesInFlight = 2;      // Tiles queued per worker to hide network latency
+    PixelFormat tileFormat = PIXEL_RGB32F; // How finished tiles are sent (lossy formats save bandwidth)
+    double idleTimeoutSec = 30; // Give up if no worker is connected for this long
+    double helloTimeoutSec = 5; // Close connections that have not said HELLO after this long
+    double tileTimeoutSec = 60; // Drop a worker that has tiles but returns none for this long
+    std::string program;        // argv[0] for spawned workers, which run this same executable
+                                // (/proc/self/exe; looked up in PATH where that is missing)
+};
+
+// Renders `job` with workers, saves the frame to `outputPath` and prints per-worker throughput.
+int runCoordinator(const CoordinatorOptions& options, const RenderJob& job, const std::string& outputPath);
+
+// Connects to a coordinator and renders tiles until it says BYE.
+int runWorker(const std::string& address);
+
+#endif // DISTRIBUTED_RENDER_H
@@ -0,0 +1,54 @@
+// src/Frustum.cpp
+#include "Frustum.h"
+#include <cmath> // For std::fabs
+
+namespace {
+    // Slack of the tests (relative to the sphere distances, absolute for unit vector products).
+    // The rays of a tile are computed in floating point and are not exactly inside the ideal
+    // pyramid, so objects that are only just outside it are kept.
+    const float CULL_TOLERANCE = 1e-3f;
+}
+
+Frustum::Frustum(const Camera& camera, const Tile& tile) : eye(camera.eyePosition) {
+    // Corner rays in order around the tile, through the outer edges of its corner pixels.
+    corners[0] = camera.computePrimaryRay(static_cast<float>(tile.x0), static_cast<float>(tile.y0)).direction;
+    corners[1] = camera.computePrimaryRay(static_cast<float>(tile.x1), static_cast<float>(tile.y0)).direction;
+    corners[2] = camera.computePrimaryRay(static_cast<float>(tile.x1), static_cast<float>(tile.y1)).direction;
+    corners[3] = camera.computePrimaryRay(static_cast<float>(tile.x0), static_cast<float>(tile.y1)).direction;
+
+    // Each side plane contains two neighbouring corner rays. Its normal is flipped if needed
+    // so that the tile's central ray is on the inner side.
+    const Vec3f middle = corners[0] + corners[1] + corners[2] + corners[3];
+    for (int k = 0; k < 4; ++k) {
+        Vec3f normal = corners[k].cross(corners[(k + 1) % 4]).normalize();
+        normals[k] = normal.dot(middle) < 0.0f ? normal * -1.0f : normal;
+    }
+}
+
+bool Frustum::excludesSphere(const Vec3f& center, float radius) const {
+    const Vec3f toCenter = center - eye;
+    const float slack = radius + CULL_TOLERANCE * (radius + toCenter.length());
+    for (int k = 0; k < 4; ++k) {
+        if (normals[k].dot(toCenter) < -slack) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Frustum::excludesPlane(const Vec3f& point, const Vec3f& normal) const {
+    // A ray d from the eye meets the plane in front of it when d . normal has the sign of
+    // (point - eye) . normal. The tile's rays are the combinations of its corner rays, so
+    // if no corner ray has that sign, none of them has.
+    const float side = (point - eye).dot(normal);
+    if (std::fabs(side) < CULL_TOLERANCE) {
+        return false; // Eye (nearly) on the plane: keep it
+    }
+    for (int k = 0; k < 4; ++k) {
+        const float facing = corners[k].dot(normal);
+        if (side > 0.0f ? facing > -CULL_TOLERANCE : facing < CULL_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
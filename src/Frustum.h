@@ -0,0 +1,33 @@
+// src/Frustum.h
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "Vec3.h"
+#include "Camera.h"
+#include "Tile.h"
+
+// The volume swept by the primary rays of one screen tile: a pyramid with its apex at the eye
+// and four side planes through the rays of the tile's corners (no near or far plane).
+// Used to cull objects once per tile, so that the tile's rays are only tested against the
+// objects that can appear in it. The tests are conservative: an object is only excluded if
+// no primary ray of the tile, including jittered samples, can hit it.
+class Frustum {
+public:
+    // Frustum of the pixels [x0, x1) x [y0, y1) of `tile`, built from the same mapping as
+    // Camera::computePrimaryRay (eye position, u/v/w basis, FOV and aspect ratio).
+    Frustum(const Camera& camera, const Tile& tile);
+
+    // True if the sphere lies entirely outside the frustum.
+    bool excludesSphere(const Vec3f& center, float radius) const;
+
+    // True if no ray of the frustum meets the infinite plane in front of the eye,
+    // e.g. a ground plane seen only by tiles above the horizon.
+    bool excludesPlane(const Vec3f& point, const Vec3f& normal) const;
+
+private:
+    Vec3f eye;
+    Vec3f corners[4]; // Unit directions of the corner rays
+    Vec3f normals[4]; // Unit normals of the side planes, pointing inwards
+};
+
+#endif // FRUSTUM_H
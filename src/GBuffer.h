@@ -0,0 +1,53 @@
+// src/GBuffer.h
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <vector>
+#include <algorithm> // For std::fill
+#include "Vec3.h"
+#include "Object.h"
+
+// Per-pixel surface attributes captured while tracing primary rays.
+// Render modes that reuse or filter shading (temporal reprojection, denoising, ...)
+// read these instead of re-tracing the scene.
+struct GBuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<Vec3f> position;        // World-space hit point
+    std::vector<Vec3f> normal;          // Surface normal at the hit point
+    std::vector<float> depth;           // Distance from the eye to the hit point
+    std::vector<const Object*> object;  // Object that was hit (nullptr for background pixels)
+
+    // Reallocates all attribute planes for the given resolution and clears them.
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        position.assign(w * h, Vec3f(0.0f));
+        normal.assign(w * h, Vec3f(0.0f));
+        depth.assign(w * h, 0.0f);
+        object.assign(w * h, nullptr);
+    }
+
+    // Frees all attribute planes (the next resize() allocates them again).
+    void release() {
+        width = 0;
+        height = 0;
+        std::vector<Vec3f>().swap(position);
+        std::vector<Vec3f>().swap(normal);
+        std::vector<float>().swap(depth);
+        std::vector<const Object*>().swap(object);
+    }
+
+    // Bytes held by the attribute planes.
+    size_t bytes() const {
+        return position.capacity() * sizeof(Vec3f) + normal.capacity() * sizeof(Vec3f) +
+               depth.capacity() * sizeof(float) + object.capacity() * sizeof(const Object*);
+    }
+
+    // Marks every pixel as background without freeing memory.
+    void clear() {
+        std::fill(object.begin(), object.end(), static_cast<const Object*>(nullptr));
+    }
+};
+
+#endif // GBUFFER_H
@@ -0,0 +1,290 @@
+// src/Kernels.cpp
+#include "Kernels.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include <atomic>  // For std::atomic
+#include <cstdlib> // For std::getenv
+#include <cstdio>  // For fprintf
+
+namespace {
+    // True if the CPU can execute the given build.
+    bool cpuSupports(const Kernels::KernelSet* set) {
+#ifdef KERNELS_MULTI_ISA
+        __builtin_cpu_init();
+        if (set == Kernels::avx512Kernels()) {
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+                   __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq");
+        }
+        if (set == Kernels::avx2Kernels()) {
+            return __builtin_cpu_supports("avx2");
+        }
+#endif
+        return set != nullptr;
+    }
+
+    // Builds this binary contains and this CPU can run, best first.
+    std::vector<const Kernels::KernelSet*> supportedSets() {
+        std::vector<const Kernels::KernelSet*> sets;
+        const Kernels::KernelSet* all[] = { Kernels::avx512Kernels(), Kernels::avx2Kernels(), Kernels::sse2Kernels() };
+        for (const Kernels::KernelSet* set : all) {
+            if (set && cpuSupports(set)) {
+                sets.push_back(set);
+            }
+        }
+        return sets;
+    }
+
+    const Kernels::KernelSet* findSupported(const std::string& name) {
+        for (const Kernels::KernelSet* set : supportedSets()) {
+            if (name == set->name) {
+                return set;
+            }
+        }
+        return nullptr;
+    }
+
+    // The best supported build, or the one named by RAYTRACER_ISA.
+    const Kernels::KernelSet* chooseDefault() {
+        const char* requested = std::getenv("RAYTRACER_ISA");
+        if (requested && *requested) {
+            if (const Kernels::KernelSet* set = findSupported(requested)) {
+                return set;
+            }
+            fprintf(stderr, "Warning: RAYTRACER_ISA=%s is not supported here, using the best available kernels\n", requested);
+        }
+        return supportedSets().front(); // The baseline build is always supported
+    }
+
+    std::atomic<const Kernels::KernelSet*> g_forced(nullptr);
+}
+
+const Kernels::KernelSet& Kernels::active() {
+    static const KernelSet* chosen = chooseDefault(); // Thread-safe one-time initialization
+    const KernelSet* forced = g_forced.load(std::memory_order_relaxed);
+    return forced ? *forced : *chosen;
+}
+
+bool Kernels::force(const std::string& name) {
+    const KernelSet* set = findSupported(name);
+    if (set) {
+        g_forced = set;
+    }
+    return set != nullptr;
+}
+
+std::vector<std::string> Kernels::supportedNames() {
+    std::vector<std::string> names;
+    for (const KernelSet* set : supportedSets()) {
+        names.push_back(set->name);
+    }
+    return names;
+}
+
+Kernels::RenderKernel Kernels::selectRender(const KernelSet& kernels, const SceneView& scene, bool shadows, bool generic) {
+    if (generic) {
+        return kernels.render[shadows][LIGHT_BUCKETS - 1][1];
+    }
+    const int lightBucket = scene.lightCount <= MAX_FIXED_LIGHTS ? scene.lightCount : LIGHT_BUCKETS - 1;
+    return kernels.render[shadows][lightBucket][scene.planeCount > 0];
+}
+
+Kernels::PacketScene::PacketScene()
+    : supported(true), background(0.0f), memory(MemoryTracker::MEMORY_ACCELERATION) {}
+
+Kernels::PacketScene::PacketScene(const Scene& scene)
+    : supported(true), background(scene.backgroundColor), memory(MemoryTracker::MEMORY_ACCELERATION) {
+    for (size_t k = 0; k < scene.objects.size(); ++k) {
+        append(scene, static_cast<int>(k));
+    }
+    copyLights(scene);
+    updateMemoryAccount();
+}
+
+void Kernels::PacketScene::updateMemoryAccount() {
+    size_t bytes = MemoryTracker::capacityBytes(sphereObjects) + MemoryTracker::capacityBytes(planeObjects) +
+                   MemoryTracker::capacityBytes(slots);
+    const std::vector<float>* arrays[] = {
+        &sphereX, &sphereY, &sphereZ, &sphereRadius, &sphereR, &sphereG, &sphereB,
+        &planePointX, &planePointY, &planePointZ, &planeNormalX, &planeNormalY, &planeNormalZ, &planeR, &planeG, &planeB,
+        &lightX, &lightY, &lightZ, &lightR, &lightG, &lightB
+    };
+    for (const std::vector<float>* values : arrays) {
+        bytes += MemoryTracker::capacityBytes(*values);
+    }
+    memory.set(bytes);
+}
+
+void Kernels::PacketScene::append(const Scene& scene, int objectIndex) {
+    const Object* obj = scene.objects[objectIndex];
+    Slot slot = { true, 0 };
+    if (const Sphere* sphere = dynamic_cast<const Sphere*>(obj)) {
+        slot.index = static_cast<int>(sphereObjects.size());
+        sphereX.push_back(sphere->center.x);
+        sphereY.push_back(sphere->center.y);
+        sphereZ.push_back(sphere->center.z);
+        sphereRadius.push_back(sphere->radius);
+        sphereR.push_back(sphere->color.x);
+        sphereG.push_back(sphere->color.y);
+        sphereB.push_back(sphere->color.z);
+        sphereObjects.push_back(objectIndex);
+    } else if (const Plane* plane = dynamic_cast<const Plane*>(obj)) {
+        slot.sphere = false;
+        slot.index = static_cast<int>(planeObjects.size());
+        planePointX.push_back(plane->point.x);
+        planePointY.push_back(plane->point.y);
+        planePointZ.push_back(plane->point.z);
+        planeNormalX.push_back(plane->normal.x);
+        planeNormalY.push_back(plane->normal.y);
+        planeNormalZ.push_back(plane->normal.z);
+        planeR.push_back(plane->color.x);
+        planeG.push_back(plane->color.y);
+        planeB.push_back(plane->color.z);
+        planeObjects.push_back(objectIndex);
+    } else {
+        supported = false;
+        slot.index = -1;
+    }
+    slots.push_back(slot);
+}
+
+void Kernels::PacketScene::write(const Scene& scene, int objectIndex) {
+    const Slot slot = slots[objectIndex];
+    const Object* obj = scene.objects[objectIndex];
+    if (slot.sphere) {
+        const Sphere* sphere = static_cast<const Sphere*>(obj);
+        sphereX[slot.index] = sphere->center.x;
+        sphereY[slot.index] = sphere->center.y;
+        sphereZ[slot.index] = sphere->center.z;
+        sphereRadius[slot.index] = sphere->radius;
+        sphereR[slot.index] = sphere->color.x;
+        sphereG[slot.index] = sphere->color.y;
+        sphereB[slot.index] = sphere->color.z;
+    } else {
+        const Plane* plane = static_cast<const Plane*>(obj);
+        planePointX[slot.index] = plane->point.x;
+        planePointY[slot.index] = plane->point.y;
+        planePointZ[slot.index] = plane->point.z;
+        planeNormalX[slot.index] = plane->normal.x;
+        planeNormalY[slot.index] = plane->normal.y;
+        planeNormalZ[slot.index] = plane->normal.z;
+        planeR[slot.index] = plane->color.x;
+        planeG[slot.index] = plane->color.y;
+        planeB[slot.index] = plane->color.z;
+    }
+}
+
+namespace {
+    // Removes entry `index` of each array by moving the last entry into it.
+    void eraseEntry(std::vector<float>* const* arrays, int arrayCount, int index) {
+        for (int a = 0; a < arrayCount; ++a) {
+            std::vector<float>& values = *arrays[a];
+            values[index] = values.back();
+            values.pop_back();
+        }
+    }
+}
+
+void Kernels::PacketScene::erase(int objectIndex) {
+    // Drop the object's sphere or plane, moving the last one of its kind into the gap.
+    const Slot slot = slots[objectIndex];
+    std::vector<int>& owners = slot.sphere ? sphereObjects : planeObjects;
+    if (slot.sphere) {
+        std::vector<float>* arrays[] = { &sphereX, &sphereY, &sphereZ, &sphereRadius, &sphereR, &sphereG, &sphereB };
+        eraseEntry(arrays, 7, slot.index);
+    } else {
+        std::vector<float>* arrays[] = { &planePointX, &planePointY, &planePointZ, &planeNormalX, &planeNormalY,
+                                         &planeNormalZ, &planeR, &planeG, &planeB };
+        eraseEntry(arrays, 9, slot.index);
+    }
+    owners[slot.index] = owners.back();
+    owners.pop_back();
+    if (slot.index < static_cast<int>(owners.size())) {
+        slots[owners[slot.index]].index = slot.index;
+    }
+
+    // As in Scene::removeObject, the last scene object takes over the removed object's index.
+    const int last = static_cast<int>(slots.size()) - 1;
+    if (objectIndex != last) {
+        slots[objectIndex] = slots[last];
+        (slots[objectIndex].sphere ? sphereObjects : planeObjects)[slots[objectIndex].index] = objectIndex;
+    }
+    slots.pop_back();
+}
+
+void Kernels::PacketScene::copyLights(const Scene& scene) {
+    lightX.clear(); lightY.clear(); lightZ.clear();
+    lightR.clear(); lightG.clear(); lightB.clear();
+    for (const Light& light : scene.lights) {
+        lightX.push_back(light.position.x);
+        lightY.push_back(light.position.y);
+        lightZ.push_back(light.position.z);
+        lightR.push_back(light.color.x);
+        lightG.push_back(light.color.y);
+        lightB.push_back(light.color.z);
+    }
+}
+
+void Kernels::PacketScene::update(const Scene& scene, const SceneChanges& changes) {
+    for (const SceneChanges::Edit& edit : changes.edits) {
+        if (!supported) {
+            break;
+        }
+        switch (edit.type) {
+        case SceneChanges::OBJECT_CHANGED:
+            write(scene, edit.index);
+            break;
+        case SceneChanges::OBJECT_REMOVED:
+            erase(edit.index);
+            break;
+        case SceneChanges::OBJECT_ADDED:
+            append(scene, edit.index);
+            break;
+        }
+    }
+    // Unsupported scenes are not rendered from this copy; rebuilding keeps `supported` exact
+    // (e.g. once the last unsupported object is removed).
+    if (!supported) {
+        *this = PacketScene(scene);
+        return;
+    }
+    if (changes.lightsChanged) {
+        copyLights(scene);
+    }
+    background = scene.backgroundColor;
+    updateMemoryAccount();
+}
+
+Kernels::SceneView Kernels::PacketScene::view() const {
+    SceneView v;
+    v.sphereCount = static_cast<int>(sphereX.size());
+    v.sphereX = sphereX.data();
+    v.sphereY = sphereY.data();
+    v.sphereZ = sphereZ.data();
+    v.sphereRadius = sphereRadius.data();
+    v.planeCount = static_cast<int>(planePointX.size());
+    v.planePointX = planePointX.data();
+    v.planePointY = planePointY.data();
+    v.planePointZ = planePointZ.data();
+    v.planeNormalX = planeNormalX.data();
+    v.planeNormalY = planeNormalY.data();
+    v.planeNormalZ = planeNormalZ.data();
+    v.sphereR = sphereR.data();
+    v.sphereG = sphereG.data();
+    v.sphereB = sphereB.data();
+    v.planeR = planeR.data();
+    v.planeG = planeG.data();
+    v.planeB = planeB.data();
+    v.lightCount = static_cast<int>(lightX.size());
+    v.lightX = lightX.data();
+    v.lightY = lightY.data();
+    v.lightZ = lightZ.data();
+    v.lightR = lightR.data();
+    v.lightG = lightG.data();
+    v.lightB = lightB.data();
+    v.background = background;
+    v.primarySpheres = nullptr; // Every primitive is a candidate
+    v.primarySphereCount = -1;
+    v.primaryPlanes = nullptr;
+    v.primaryPlaneCount = -1;
+    return v;
+}
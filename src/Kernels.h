@@ -0,0 +1,252 @@
+// src/Kernels.h
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Vec3.h"
+#include "Object.h"
+#include "Scene.h"
+#include "SceneDiff.h"
+#include "MemoryTracker.h"
+
+// GCC and Clang on x86 can compile functions for instruction sets beyond the build's baseline.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_MULTI_ISA 1
+#endif
+
+// Hot loops of the renderer, compiled once per instruction set and picked at startup.
+//
+// The kernels work on structure-of-arrays data: rays, hits and colors are passed as
+// separate x/y/z arrays so that each kernel can process a packet of W rays with one
+// vector instruction per operation (W = 4 for SSE2, 8 for AVX2, 16 for AVX-512).
+// All builds share the source in KernelsImpl.h; see KernelsSSE2.cpp and friends.
+namespace Kernels {
+    // Flattened scene geometry and lights. Primitive indices count spheres first, then planes.
+    struct SceneView {
+        int sphereCount;
+        const float* sphereX;
+        const float* sphereY;
+        const float* sphereZ;
+        const float* sphereRadius;
+        int planeCount;
+        const float* planePointX;
+        const float* planePointY;
+        const float* planePointZ;
+        const float* planeNormalX;
+        const float* planeNormalY;
+        const float* planeNormalZ;
+        const float* sphereR; // Object colors
+        const float* sphereG;
+        const float* sphereB;
+        const float* planeR;
+        const float* planeG;
+        const float* planeB;
+        int lightCount;
+        const float* lightX;
+        const float* lightY;
+        const float* lightZ;
+        const float* lightR;
+        const float* lightG;
+        const float* lightB;
+        Vec3f background;
+
+        // Optional candidate lists for closest-hit searches, e.g. the primitives inside a tile's
+        // frustum (see Frustum.h). With primarySphereCount >= 0, closest hits only test these sphere
+        // and plane indices, in increasing order; shadow rays still test every primitive.
+        // view() sets the counts to -1 (every primitive is a candidate).
+        const int* primarySpheres;
+        int primarySphereCount;
+        const int* primaryPlanes;
+        int primaryPlaneCount;
+    };
+
+    // `count` rays; directions must be unit length.
+    struct RayArrays {
+        const float* originX;
+        const float* originY;
+        const float* originZ;
+        const float* directionX;
+        const float* directionY;
+        const float* directionZ;
+    };
+
+    // Writable ray arrays, filled by KernelSet::primaryRays.
+    struct RayBuffers {
+        float* originX;
+        float* originY;
+        float* originZ;
+        float* directionX;
+        float* directionY;
+        float* directionZ;
+    };
+
+    // Per-frame constants of a camera's primary rays (cached by Camera::updateBasis()).
+    struct CameraView {
+        Vec3f eye;
+        Vec3f u, v, w;         // Camera basis
+        float halfWidth;       // Image plane extent at distance 1 along -w
+        float halfHeight;
+        float imageWidth;      // Pixels
+        float imageHeight;
+    };
+
+    // Surface hits to be shaded. visibility[l * count + k] is 1 if light l reaches hit k.
+    struct ShadeInputs {
+        const float* pointX;
+        const float* pointY;
+        const float* pointZ;
+        const float* normalX;
+        const float* normalY;
+        const float* normalZ;
+        const float* albedoR;
+        const float* albedoG;
+        const float* albedoB;
+        const unsigned char* visibility;
+    };
+
+    // Primary hit of each ray, optionally written by the render kernels (e.g. as denoiser features):
+    // distance (FLT_MAX on a miss), surface normal (zero on a miss) and primitive index (-1 on a miss).
+    struct HitBuffers {
+        float* distance;
+        float* normalX;
+        float* normalY;
+        float* normalZ;
+        int* primitive;
+    };
+
+    // One pass of the edge-aware a-trous filter over planar images (see Denoiser.h).
+    // All planes share one row layout: row y starts at y * stride, and every row can be read
+    // from `step` floats before its first pixel to step + (kernel width - 1) floats after its
+    // last one, so taps need no bounds checks.
+    struct AtrousPass {
+        int width;
+        int height;
+        int stride;            // Floats from one row of a plane to the next
+        int step;              // Pixels between neighbouring taps
+        const float* red;      // Input color planes
+        const float* green;
+        const float* blue;
+        const float* normalX;  // Features of every pixel
+        const float* normalY;
+        const float* normalZ;
+        const float* depth;
+        const float* objectKey; // Twice the object index, negative for the background and the padding
+        float* outRed;         // Output color planes (distinct from the input)
+        float* outGreen;
+        float* outBlue;
+        float colorWeight;     // Scale of the squared color difference in the weight exponent
+        float normalWeight;    // Scale of 1 - N.N'
+        float depthWeight;     // Scale of the depth difference relative to the center depth
+    };
+
+    // Traces and shades `count` primary rays: closest hit, shadow rays and Lambert shading, or
+    // the background color on a miss (same result as Scene::trace followed by Scene::shade).
+    // If `hits` is not null, the primary hits are stored there as well.
+    typedef void (*RenderKernel)(const SceneView& scene, const RayArrays& rays, int count, float* red, float* green,
+                                 float* blue, const HitBuffers* hits);
+
+    // Light counts up to MAX_FIXED_LIGHTS get a render kernel of their own;
+    // the last bucket handles any number of lights.
+    const int MAX_FIXED_LIGHTS = 4;
+    const int LIGHT_BUCKETS = MAX_FIXED_LIGHTS + 2;
+
+    // One build of the kernels.
+    struct KernelSet {
+        const char* name; // "sse2", "avx2", "avx512" or "generic"
+        int width;        // Rays per packet
+
+        // Closest primitive along each ray: distance (FLT_MAX on a miss) and primitive index (-1 on a miss).
+        void (*closestHit)(const SceneView& scene, const RayArrays& rays, int count, float* distance, int* primitive);
+        // occluded[k] = 1 if any primitive lies along ray k closer than maxDistance[k].
+        void (*occluded)(const SceneView& scene, const RayArrays& rays, const float* maxDistance, int count,
+                         unsigned char* occluded);
+        // Lambertian color of each hit (same result as Scene::shade with the given visibility).
+        void (*shade)(const SceneView& scene, const ShadeInputs& hits, int count, float* red, float* green, float* blue);
+        // Converts colour components to 8 bits (same result as Utils::toByte).
+        void (*quantize)(const float* values, size_t count, unsigned char* out);
+        // Primary rays through the image positions (pixelX[k], pixelY[k]), with unit directions
+        // (same result as Camera::computePrimaryRay).
+        void (*primaryRays)(const CameraView& camera, const float* pixelX, const float* pixelY, int count,
+                            const RayBuffers& rays);
+        // Filters row `row` of an a-trous pass. Rows are independent, so they can run in parallel.
+        void (*atrousRow)(const AtrousPass& pass, int row);
+
+        // Render kernels specialized at compile time by [shadows][light bucket][scene has planes],
+        // so the per-ray code carries no feature checks. Use selectRender() to pick one.
+        RenderKernel render[2][LIGHT_BUCKETS][2];
+    };
+
+    // The individual builds (KernelsSSE2.cpp, KernelsAVX2.cpp, KernelsAVX512.cpp).
+    // Return nullptr if the build is not part of this binary; they do not check the CPU.
+    const KernelSet* sse2Kernels();
+    const KernelSet* avx2Kernels();
+    const KernelSet* avx512Kernels();
+
+    // The kernels used by the renderer: the best set the CPU supports, unless overridden
+    // with force() or the RAYTRACER_ISA environment variable.
+    const KernelSet& active();
+
+    // Forces a kernel set by name. Returns false if it is unknown or not supported by this CPU.
+    bool force(const std::string& name);
+
+    // Names of the kernel sets this binary contains and this CPU can run, best first.
+    std::vector<std::string> supportedNames();
+
+    // The render kernel of `kernels` matching a scene's contents.
+    // `generic` picks the instantiation that handles every scene, e.g. for comparisons.
+    RenderKernel selectRender(const KernelSet& kernels, const SceneView& scene, bool shadows, bool generic = false);
+
+    // Copy of a scene's spheres, planes and lights in the layout the kernels read.
+    // It can be kept resident and brought up to date with update() after the scene is edited.
+    class PacketScene {
+    public:
+        // Copy of an empty scene.
+        PacketScene();
+        explicit PacketScene(const Scene& scene);
+
+        // False if the scene contains objects other than spheres and planes;
+        // such scenes have to be rendered through the Object interface.
+        bool supported;
+
+        SceneView view() const;
+        // Index in Scene::objects of the object behind a primitive index.
+        int objectIndex(int primitive) const {
+            return isSphere(primitive) ? sphereObjects[primitive] : planeObjects[primitive - static_cast<int>(sphereObjects.size())];
+        }
+        bool isSphere(int primitive) const { return primitive < static_cast<int>(sphereObjects.size()); }
+
+        // Follows the edits made to `scene` since this copy was taken or last updated (see SceneDiff.h).
+        // Changed objects are rewritten in place; removed ones are filled with the last sphere or plane
+        // and added ones appended, so the cost is proportional to the edits, not to the scene.
+        // A copy of an unsupported scene is rebuilt instead.
+        void update(const Scene& scene, const SceneChanges& changes);
+
+    private:
+        // Where a scene object is stored: index into the sphere or the plane arrays.
+        struct Slot {
+            bool sphere;
+            int index;
+        };
+
+        void append(const Scene& scene, int objectIndex); // Stores a new object; clears `supported` if it can't
+        void write(const Scene& scene, int objectIndex);  // Rewrites an object's entries in place
+        void erase(int objectIndex);                      // Mirrors Scene::removeObject
+        void copyLights(const Scene& scene);
+        void updateMemoryAccount();
+
+        std::vector<float> sphereX, sphereY, sphereZ, sphereRadius, sphereR, sphereG, sphereB;
+        std::vector<float> planePointX, planePointY, planePointZ, planeNormalX, planeNormalY, planeNormalZ;
+        std::vector<float> planeR, planeG, planeB;
+        std::vector<float> lightX, lightY, lightZ, lightR, lightG, lightB;
+        std::vector<int> sphereObjects; // Scene object index of each sphere
+        std::vector<int> planeObjects;  // Scene object index of each plane
+        std::vector<Slot> slots;        // Indexed by scene object index
+        Vec3f background;
+        MemoryTracker::Account memory; // Bytes of the arrays above (acceleration data)
+    };
+}
+
+#endif // KERNELS_H
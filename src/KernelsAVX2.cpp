@@ -0,0 +1,45 @@
+// src/KernelsAVX2.cpp
+// AVX2 build of the kernels (8 lanes).
+// The target is set with a pragma around the kernel code only, instead of compiling the whole
+// file with -mavx2: inline functions shared with other files (Vec3f, the standard library)
+// are included first and keep the baseline target, so the linker can never pick an AVX2 copy
+// of them for code that runs on older CPUs.
+#include "Kernels.h"
+
+#ifdef KERNELS_MULTI_ISA
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#define SIMD_MATH_AVX 1
+#define SIMD_NAMESPACE simd_avx2
+#define KERNEL_WIDTH 8
+#define KERNEL_NAME "avx2"
+#include "KernelsImpl.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+const Kernels::KernelSet* Kernels::avx2Kernels() {
+    return &simd_avx2::KERNEL_SET;
+}
+
+#else
+
+const Kernels::KernelSet* Kernels::avx2Kernels() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,46 @@
+// src/KernelsAVX512.cpp
+// AVX-512 build of the kernels (16 lanes). See KernelsAVX2.cpp for why the target is set by pragma.
+#include "Kernels.h"
+
+#ifdef KERNELS_MULTI_ISA
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// AVX-512F includes FMA. Fused multiply-adds round differently from the scalar code, so
+// contraction is switched off to keep the result identical to the other builds.
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f,avx512vl,avx512bw,avx512dq"))), apply_to = function)
+#pragma clang fp contract(off)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vl,avx512bw,avx512dq")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define SIMD_MATH_AVX 1
+#define SIMD_MATH_AVX512 1
+#define SIMD_NAMESPACE simd_avx512
+#define KERNEL_WIDTH 16
+#define KERNEL_NAME "avx512"
+#include "KernelsImpl.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+const Kernels::KernelSet* Kernels::avx512Kernels() {
+    return &simd_avx512::KERNEL_SET;
+}
+
+#else
+
+const Kernels::KernelSet* Kernels::avx512Kernels() {
+    return nullptr;
+}
+
+#endif
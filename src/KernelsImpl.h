@@ -0,0 +1,354 @@
+// src/KernelsImpl.h
+// Kernel bodies shared by every instruction-set build (see Kernels.h).
+// This file is included once by each of KernelsSSE2.cpp, KernelsAVX2.cpp and KernelsAVX512.cpp,
+// after it has defined SIMD_NAMESPACE, KERNEL_WIDTH and KERNEL_NAME and selected the target
+// instruction set. Each inclusion is a separate build, so there is deliberately no include guard.
+
+#include "PacketKernels.h"
+
+namespace SIMD_NAMESPACE {
+
+const int W = KERNEL_WIDTH;
+typedef FloatN<W> Lanes;
+typedef Vec3xN<W> Vec3s;
+
+// Lanes [0, n) from `values`; lanes past the end of the input get `fill`.
+inline Lanes loadLanes(const float* values, int n, float fill) {
+    if (n == W) {
+        return Lanes::load(values);
+    }
+    Lanes lanes(fill);
+    for (int k = 0; k < n; ++k) {
+        lanes.lane[k] = values[k];
+    }
+    return lanes;
+}
+
+inline void loadRays(const Kernels::RayArrays& rays, int first, int n, Vec3s& origin, Vec3s& direction) {
+    origin = Vec3s(loadLanes(rays.originX + first, n, 0.0f), loadLanes(rays.originY + first, n, 0.0f),
+                   loadLanes(rays.originZ + first, n, 0.0f));
+    direction = Vec3s(loadLanes(rays.directionX + first, n, 0.0f), loadLanes(rays.directionY + first, n, 0.0f),
+                      loadLanes(rays.directionZ + first, n, 1.0f));
+}
+
+// Closest primitive along each ray of one packet. The primitive index is carried as a float
+// lane (exact for any realistic scene size) so that it is updated with the same blend as
+// the distance instead of lane by lane.
+// With HasPlanes false the scene's planes are ignored (the caller knows there are none).
+template <bool HasPlanes>
+inline void closestHitPacket(const Kernels::SceneView& scene, const Vec3s& origin, const Vec3s& direction,
+                             Lanes& best, Lanes& primitive) {
+    best = Lanes(PACKET_MISS);
+    primitive = Lanes(-1.0f);
+    const bool culled = scene.primarySphereCount >= 0;
+    const int sphereCandidates = culled ? scene.primarySphereCount : scene.sphereCount;
+    const int planeCandidates = culled ? scene.primaryPlaneCount : scene.planeCount;
+    for (int c = 0; c < sphereCandidates; ++c) {
+        const int s = culled ? scene.primarySpheres[c] : c;
+        const Lanes t = intersectSphere(origin, direction, Vec3f(scene.sphereX[s], scene.sphereY[s], scene.sphereZ[s]),
+                                        scene.sphereRadius[s]);
+        const MaskN<W> closer = t < best;
+        best = select(closer, t, best);
+        primitive = select(closer, Lanes(static_cast<float>(s)), primitive);
+    }
+    for (int c = 0; HasPlanes && c < planeCandidates; ++c) {
+        const int p = culled ? scene.primaryPlanes[c] : c;
+        const Lanes t = intersectPlane(origin, direction,
+                                       Vec3f(scene.planePointX[p], scene.planePointY[p], scene.planePointZ[p]),
+                                       Vec3f(scene.planeNormalX[p], scene.planeNormalY[p], scene.planeNormalZ[p]));
+        const MaskN<W> closer = t < best;
+        best = select(closer, t, best);
+        primitive = select(closer, Lanes(static_cast<float>(scene.sphereCount + p)), primitive);
+    }
+}
+
+void closestHit(const Kernels::SceneView& scene, const Kernels::RayArrays& rays, int count, float* distance, int* primitive) {
+    for (int first = 0; first < count; first += W) {
+        const int n = count - first < W ? count - first : W;
+        Vec3s origin, direction;
+        loadRays(rays, first, n, origin, direction);
+        Lanes best, hit;
+        closestHitPacket<true>(scene, origin, direction, best, hit);
+        for (int k = 0; k < n; ++k) {
+            distance[first + k] = best.lane[k];
+            primitive[first + k] = static_cast<int>(hit.lane[k]);
+        }
+    }
+}
+
+// Adds to `blocked` the lanes whose ray hits a primitive closer than `limit`.
+// Lanes already set are not tested again, and the loop stops once every lane is blocked.
+template <bool HasPlanes>
+inline void occludedPacket(const Kernels::SceneView& scene, const Vec3s& origin, const Vec3s& direction,
+                           const Lanes& limit, MaskN<W>& blocked) {
+    for (int s = 0; s < scene.sphereCount && !all(blocked); ++s) {
+        blocked = blocked | (intersectSphere(origin, direction, Vec3f(scene.sphereX[s], scene.sphereY[s], scene.sphereZ[s]),
+                                             scene.sphereRadius[s]) < limit);
+    }
+    for (int p = 0; HasPlanes && p < scene.planeCount && !all(blocked); ++p) {
+        blocked = blocked | (intersectPlane(origin, direction,
+                                            Vec3f(scene.planePointX[p], scene.planePointY[p], scene.planePointZ[p]),
+                                            Vec3f(scene.planeNormalX[p], scene.planeNormalY[p], scene.planeNormalZ[p])) < limit);
+    }
+}
+
+void occluded(const Kernels::SceneView& scene, const Kernels::RayArrays& rays, const float* maxDistance, int count,
+              unsigned char* result) {
+    for (int first = 0; first < count; first += W) {
+        const int n = count - first < W ? count - first : W;
+        Vec3s origin, direction;
+        loadRays(rays, first, n, origin, direction);
+        const Lanes limit = loadLanes(maxDistance + first, n, 0.0f);
+
+        // Any hit closer than the light blocks it.
+        MaskN<W> blocked(false);
+        occludedPacket<true>(scene, origin, direction, limit, blocked);
+        for (int k = 0; k < n; ++k) {
+            result[first + k] = blocked.lane[k] ? 1 : 0;
+        }
+    }
+}
+
+void shade(const Kernels::SceneView& scene, const Kernels::ShadeInputs& hits, int count, float* red, float* green, float* blue) {
+    for (int first = 0; first < count; first += W) {
+        const int n = count - first < W ? count - first : W;
+        const Vec3s point(loadLanes(hits.pointX + first, n, 0.0f), loadLanes(hits.pointY + first, n, 0.0f),
+                          loadLanes(hits.pointZ + first, n, 0.0f));
+        const Vec3s normal(loadLanes(hits.normalX + first, n, 0.0f), loadLanes(hits.normalY + first, n, 0.0f),
+                           loadLanes(hits.normalZ + first, n, 0.0f));
+        const Lanes albedoR = loadLanes(hits.albedoR + first, n, 0.0f);
+        const Lanes albedoG = loadLanes(hits.albedoG + first, n, 0.0f);
+        const Lanes albedoB = loadLanes(hits.albedoB + first, n, 0.0f);
+
+        // Same accumulation order as Scene::shade, so both produce identical colors.
+        Lanes r(0.0f), g(0.0f), b(0.0f);
+        for (int l = 0; l < scene.lightCount; ++l) {
+            Lanes visible(0.0f);
+            for (int k = 0; k < n; ++k) {
+                visible.lane[k] = hits.visibility[l * count + first + k];
+            }
+            const Lanes factor = lambert<W, PRECISE>(point, normal, Vec3f(scene.lightX[l], scene.lightY[l], scene.lightZ[l])) * visible;
+            r += albedoR * scene.lightR[l] * factor;
+            g += albedoG * scene.lightG[l] * factor;
+            b += albedoB * scene.lightB[l] * factor;
+        }
+        for (int k = 0; k < n; ++k) {
+            red[first + k] = r.lane[k];
+            green[first + k] = g.lane[k];
+            blue[first + k] = b.lane[k];
+        }
+    }
+}
+
+void quantize(const float* values, size_t count, unsigned char* out) {
+    size_t k = 0;
+    for (; k + W <= count; k += W) {
+        SIMD_NAMESPACE::quantize(Lanes::load(values + k), out + k);
+    }
+    for (; k < count; ++k) {
+        const float v = values[k];
+        out[k] = static_cast<unsigned char>(255.99f * (v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v)));
+    }
+}
+
+// Light count of a render kernel that reads it from the scene instead.
+const int ANY_LIGHTS = -1;
+
+// Full primary-ray pass for a scene whose features are known at compile time:
+// Shadows casts shadow rays, Lights is the exact light count (or ANY_LIGHTS) and HasPlanes
+// tells whether there are planes to intersect. The loops below have no checks for these,
+// and hits and misses are blended with masks instead of branches.
+// Every step repeats the scalar arithmetic of Scene::trace, Scene::isInShadow and Scene::shade.
+template <bool Shadows, int Lights, bool HasPlanes>
+void render(const Kernels::SceneView& scene, const Kernels::RayArrays& rays, int count, float* red, float* green,
+            float* blue, const Kernels::HitBuffers* hits) {
+    const int lightCount = Lights == ANY_LIGHTS ? scene.lightCount : Lights;
+    for (int first = 0; first < count; first += W) {
+        const int n = count - first < W ? count - first : W;
+        Vec3s origin, direction;
+        loadRays(rays, first, n, origin, direction);
+
+        Lanes distance, hit;
+        closestHitPacket<HasPlanes>(scene, origin, direction, distance, hit);
+        const MaskN<W> isHit = hit >= Lanes(0.0f);
+        const Vec3s point = origin + direction * distance;
+
+        // Attributes of the closest primitive, gathered once per ray. Misses keep zeros.
+        Vec3s center(Lanes(0.0f), Lanes(0.0f), Lanes(0.0f));
+        Vec3s planeNormal = center;
+        Vec3s albedo = center;
+        MaskN<W> isPlane(false);
+        for (int k = 0; k < W; ++k) {
+            const int primitive = static_cast<int>(hit.lane[k]);
+            if (HasPlanes && primitive >= scene.sphereCount) {
+                const int p = primitive - scene.sphereCount;
+                planeNormal.set(k, Vec3f(scene.planeNormalX[p], scene.planeNormalY[p], scene.planeNormalZ[p]));
+                albedo.set(k, Vec3f(scene.planeR[p], scene.planeG[p], scene.planeB[p]));
+                isPlane.set(k, true);
+            } else if (primitive >= 0) {
+                center.set(k, Vec3f(scene.sphereX[primitive], scene.sphereY[primitive], scene.sphereZ[primitive]));
+                albedo.set(k, Vec3f(scene.sphereR[primitive], scene.sphereG[primitive], scene.sphereB[primitive]));
+            }
+        }
+        const Vec3s sphereNormal = (point - center).template normalize<PRECISE>();
+        const Vec3s normal = HasPlanes ? select(isPlane, planeNormal, sphereNormal) : sphereNormal;
+        if (hits) {
+            const Vec3s zero(Lanes(0.0f), Lanes(0.0f), Lanes(0.0f));
+            const Vec3s hitNormal = select(isHit, normal, zero);
+            for (int k = 0; k < n; ++k) {
+                hits->distance[first + k] = distance.lane[k];
+                hits->normalX[first + k] = hitNormal.x.lane[k];
+                hits->normalY[first + k] = hitNormal.y.lane[k];
+                hits->normalZ[first + k] = hitNormal.z.lane[k];
+                hits->primitive[first + k] = static_cast<int>(hit.lane[k]);
+            }
+        }
+
+        Lanes r(0.0f), g(0.0f), b(0.0f);
+        for (int l = 0; l < lightCount; ++l) {
+            const Vec3f lightPosition(scene.lightX[l], scene.lightY[l], scene.lightZ[l]);
+            const Vec3s toLight = Vec3s(lightPosition) - point;
+            const Vec3s lightDir = toLight.template normalize<PRECISE>();
+            Lanes factor = max(normal.dot(lightDir), Lanes(0.0f));
+            if (Shadows) {
+                // Shadow ray as built by Scene::isInShadow (Ray normalizes its direction again).
+                // Misses start out blocked so that they do not keep the occlusion loop running.
+                MaskN<W> blocked = !isHit;
+                occludedPacket<HasPlanes>(scene, point + lightDir * Lanes(1e-4f), lightDir.template normalize<PRECISE>(),
+                                          sqrt(toLight.dot(toLight)), blocked);
+                factor = select(blocked, Lanes(0.0f), factor);
+            }
+            r += albedo.x * scene.lightR[l] * factor;
+            g += albedo.y * scene.lightG[l] * factor;
+            b += albedo.z * scene.lightB[l] * factor;
+        }
+        r = select(isHit, r, Lanes(scene.background.x));
+        g = select(isHit, g, Lanes(scene.background.y));
+        b = select(isHit, b, Lanes(scene.background.z));
+        for (int k = 0; k < n; ++k) {
+            red[first + k] = r.lane[k];
+            green[first + k] = g.lane[k];
+            blue[first + k] = b.lane[k];
+        }
+    }
+}
+
+void primaryRays(const Kernels::CameraView& camera, const float* pixelX, const float* pixelY, int count,
+                 const Kernels::RayBuffers& rays) {
+    const Vec3s u(camera.u), v(camera.v), w(camera.w);
+    for (int first = 0; first < count; first += W) {
+        const int n = count - first < W ? count - first : W;
+        const Lanes px = loadLanes(pixelX + first, n, 0.0f);
+        const Lanes py = loadLanes(pixelY + first, n, 0.0f);
+
+        // Same operations in the same order as Camera::computePrimaryRay.
+        const Lanes x = (2.0f * px / Lanes(camera.imageWidth) - Lanes(1.0f)) * Lanes(camera.halfWidth);
+        const Lanes y = (Lanes(1.0f) - 2.0f * py / Lanes(camera.imageHeight)) * Lanes(camera.halfHeight);
+        const Vec3s direction = (u * x + v * y - w).template normalize<PRECISE>();
+        if (n == W) {
+            Lanes(camera.eye.x).store(rays.originX + first);
+            Lanes(camera.eye.y).store(rays.originY + first);
+            Lanes(camera.eye.z).store(rays.originZ + first);
+            direction.x.store(rays.directionX + first);
+            direction.y.store(rays.directionY + first);
+            direction.z.store(rays.directionZ + first);
+            continue;
+        }
+        for (int k = 0; k < n; ++k) {
+            rays.originX[first + k] = camera.eye.x;
+            rays.originY[first + k] = camera.eye.y;
+            rays.originZ[first + k] = camera.eye.z;
+            rays.directionX[first + k] = direction.x.lane[k];
+            rays.directionY[first + k] = direction.y.lane[k];
+            rays.directionZ[first + k] = direction.z.lane[k];
+        }
+    }
+}
+
+// Cheap stand-in for exp(-x) with x >= 0: (1 - x/4)^4, clamped to 0 from x = 4 on (where exp
+// is below 2%). Multiplies only, no division or exponential, and falls off smoothly from 1.
+inline Lanes fallOff(const Lanes& x) {
+    const Lanes t = max(Lanes(1.0f) - x * Lanes(0.25f), Lanes(0.0f));
+    const Lanes t2 = t * t;
+    return t2 * t2;
+}
+
+void atrousRow(const Kernels::AtrousPass& pass, int y) {
+    static const float B2[3] = { 1.0f / 4.0f, 1.0f / 2.0f, 1.0f / 4.0f };
+    const int rowStart = y * pass.stride;
+    for (int x = 0; x < pass.width; x += W) {
+        // Center pixels. Lanes past the end of the row read the padding, which counts as background.
+        const int center = rowStart + x;
+        const Vec3s color(Lanes::load(pass.red + center), Lanes::load(pass.green + center), Lanes::load(pass.blue + center));
+        const Lanes key = Lanes::load(pass.objectKey + center);
+        const MaskN<W> background = key < Lanes(0.0f);
+        if (all(background)) {
+            // Background pixels keep their color (nothing to filter but the antialiased outlines).
+            color.x.store(pass.outRed + center);
+            color.y.store(pass.outGreen + center);
+            color.z.store(pass.outBlue + center);
+            continue;
+        }
+        // The normal term of the weight is normalWeight * N.(N - N') = normalBase - scaledNormal.N',
+        // which is normalWeight * (1 - N.N') for unit normals and 0 for background pixels (N = 0).
+        const Vec3s normal(Lanes::load(pass.normalX + center), Lanes::load(pass.normalY + center),
+                           Lanes::load(pass.normalZ + center));
+        const Vec3s scaledNormal = normal * Lanes(pass.normalWeight);
+        const Lanes normalBase = scaledNormal.dot(normal);
+        const Lanes depth = Lanes::load(pass.depth + center);
+        const Lanes depthScale = Lanes(pass.depthWeight) / max(depth, Lanes(1e-6f));
+
+        Vec3s sum(Lanes(0.0f), Lanes(0.0f), Lanes(0.0f));
+        Lanes weightSum(0.0f);
+        for (int dy = -1; dy <= 1; ++dy) {
+            const int ty = y + dy * pass.step;
+            if (ty < 0 || ty >= pass.height) {
+                continue;
+            }
+            const int tapRow = center + (ty - y) * pass.stride;
+            for (int dx = -1; dx <= 1; ++dx) {
+                const int tap = tapRow + dx * pass.step;
+                const Vec3s tapColor(Lanes::load(pass.red + tap), Lanes::load(pass.green + tap), Lanes::load(pass.blue + tap));
+                const Vec3s tapNormal(Lanes::load(pass.normalX + tap), Lanes::load(pass.normalY + tap),
+                                      Lanes::load(pass.normalZ + tap));
+                const Lanes tapDepth = Lanes::load(pass.depth + tap);
+                const Lanes keyDelta = Lanes::load(pass.objectKey + tap) - key;
+
+                // Edge-stopping: one exponent for color, normal and depth differences, which is 0 for
+                // the center tap, so that always has full weight. Keys of different objects (and of
+                // the background or the padding) differ by 2 or more, which alone puts the exponent
+                // past the end of the fall-off: such taps get exactly zero weight without a comparison.
+                const Vec3s colorDelta = tapColor - color;
+                const Lanes depthDelta = tapDepth - depth;
+                const Lanes exponent = colorDelta.dot(colorDelta) * Lanes(pass.colorWeight) +
+                                       (normalBase - scaledNormal.dot(tapNormal)) +
+                                       max(depthDelta, -depthDelta) * depthScale + keyDelta * keyDelta;
+                const Lanes weight = Lanes(B2[dy + 1] * B2[dx + 1]) * fallOff(exponent);
+                sum += tapColor * weight;
+                weightSum += weight;
+            }
+        }
+
+        // The center tap always has full weight, so weightSum > 0 for pixels on objects.
+        const Vec3s filtered = sum * (Lanes(1.0f) / max(weightSum, Lanes(1e-20f)));
+        select(background, color.x, filtered.x).store(pass.outRed + center);
+        select(background, color.y, filtered.y).store(pass.outGreen + center);
+        select(background, color.z, filtered.z).store(pass.outBlue + center);
+    }
+}
+
+static_assert(Kernels::LIGHT_BUCKETS == 6, "RENDER_LIGHTS lists one entry per light bucket");
+
+// Table entries for one shadow setting, in the [light bucket][has planes] order of KernelSet::render.
+#define RENDER_PLANES(shadows, lights) { &render<shadows, lights, false>, &render<shadows, lights, true> }
+#define RENDER_LIGHTS(shadows)                                                                        \
+    { RENDER_PLANES(shadows, 0), RENDER_PLANES(shadows, 1), RENDER_PLANES(shadows, 2),                \
+      RENDER_PLANES(shadows, 3), RENDER_PLANES(shadows, 4), RENDER_PLANES(shadows, ANY_LIGHTS) }
+
+const Kernels::KernelSet KERNEL_SET = { KERNEL_NAME, KERNEL_WIDTH, &closestHit, &occluded, &shade, &quantize,
+                                        &primaryRays, &atrousRow, { RENDER_LIGHTS(false), RENDER_LIGHTS(true) } };
+
+#undef RENDER_LIGHTS
+#undef RENDER_PLANES
+
+} // namespace SIMD_NAMESPACE
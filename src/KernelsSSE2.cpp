@@ -0,0 +1,16 @@
+// src/KernelsSSE2.cpp
+// Baseline build of the kernels: SSE2 on x86-64 (4 lanes), the compiler's default target elsewhere.
+#include "Kernels.h"
+
+#define SIMD_NAMESPACE simd_sse2
+#define KERNEL_WIDTH 4
+#ifdef __SSE2__
+#define KERNEL_NAME "sse2"
+#else
+#define KERNEL_NAME "generic"
+#endif
+#include "KernelsImpl.h"
+
+const Kernels::KernelSet* Kernels::sse2Kernels() {
+    return &simd_sse2::KERNEL_SET;
+}
@@ -0,0 +1,109 @@
+// src/MemoryTracker.cpp
+#include "MemoryTracker.h"
+#include <atomic> // For std::atomic
+#include <cstdio> // For snprintf
+
+const char* MemoryTracker::CATEGORY_NAMES[MEMORY_CATEGORY_COUNT] = {
+    "Scene geometry", "Lights", "Acceleration", "Framebuffers", "GL textures", "Render caches", "Image output"
+};
+
+namespace {
+    std::atomic<size_t> g_current[MemoryTracker::MEMORY_CATEGORY_COUNT];
+    std::atomic<size_t> g_peak[MemoryTracker::MEMORY_CATEGORY_COUNT];
+    std::atomic<size_t> g_total(0);
+    std::atomic<size_t> g_peakTotal(0);
+    std::atomic<size_t> g_budget(0);
+
+    // Raises `peak` to `value` if it is higher (other threads may raise it concurrently).
+    void raise(std::atomic<size_t>& peak, size_t value) {
+        size_t seen = peak.load(std::memory_order_relaxed);
+        while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void change(MemoryTracker::Category category, size_t from, size_t to) {
+        if (to >= from) {
+            raise(g_peak[category], g_current[category].fetch_add(to - from, std::memory_order_relaxed) + (to - from));
+            raise(g_peakTotal, g_total.fetch_add(to - from, std::memory_order_relaxed) + (to - from));
+        } else {
+            g_current[category].fetch_sub(from - to, std::memory_order_relaxed);
+            g_total.fetch_sub(from - to, std::memory_order_relaxed);
+        }
+    }
+
+    // Formats bytes as MiB with two decimals.
+    std::string megabytes(size_t bytes) {
+        char text[32];
+        snprintf(text, sizeof(text), "%10.2f MiB", bytes / (1024.0 * 1024.0));
+        return text;
+    }
+}
+
+size_t MemoryTracker::current(Category category) {
+    return g_current[category].load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peak(Category category) {
+    return g_peak[category].load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::total() {
+    return g_total.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peakTotal() {
+    return g_peakTotal.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::setBudget(size_t bytes) {
+    g_budget = bytes;
+}
+
+size_t MemoryTracker::budget() {
+    return g_budget.load(std::memory_order_relaxed);
+}
+
+bool MemoryTracker::fits(size_t extraBytes) {
+    const size_t limit = budget();
+    return limit == 0 || total() + extraBytes <= limit;
+}
+
+std::string MemoryTracker::report() {
+    std::string text = "Memory               current           peak\n";
+    char name[32];
+    for (int c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+        snprintf(name, sizeof(name), "  %-16s", CATEGORY_NAMES[c]);
+        text += name + megabytes(current(static_cast<Category>(c))) + " " + megabytes(peak(static_cast<Category>(c))) + "\n";
+    }
+    snprintf(name, sizeof(name), "  %-16s", "Total");
+    text += name + megabytes(total()) + " " + megabytes(peakTotal()) + "\n";
+    if (budget() > 0) {
+        snprintf(name, sizeof(name), "  %-16s", "Budget");
+        text += name + megabytes(budget()) + "\n";
+    }
+    return text;
+}
+
+MemoryTracker::Account::Account(Category category) : category(category), held(0) {}
+
+MemoryTracker::Account::Account(const Account& other) : category(other.category), held(0) {
+    set(other.held);
+}
+
+MemoryTracker::Account& MemoryTracker::Account::operator=(const Account& other) {
+    if (this != &other) {
+        set(0);
+        category = other.category;
+        set(other.held);
+    }
+    return *this;
+}
+
+MemoryTracker::Account::~Account() {
+    set(0);
+}
+
+void MemoryTracker::Account::set(size_t bytes) {
+    change(category, held, bytes);
+    held = bytes;
+}
@@ -0,0 +1,68 @@
+// src/MemoryTracker.h
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <string>
+
+// Accounting of the large allocations of the renderer, by subsystem.
+//
+// Subsystems hold an Account per buffer set they own and report its size whenever they
+// (re)allocate it; the tracker keeps current and peak bytes per category. This covers the
+// buffers that scale with the scene or the resolution (small bookkeeping is not counted).
+// A budget can be set so that the window degrades (drops caches, lowers the resolution)
+// instead of growing past it; see enforceMemoryBudget() in main.cpp.
+namespace MemoryTracker {
+    enum Category {
+        MEMORY_SCENE_GEOMETRY = 0, // Scene objects, including scenes kept by SceneCache
+        MEMORY_LIGHTS,             // Scene lights
+        MEMORY_ACCELERATION,       // Geometry copies laid out for traversal (Kernels::PacketScene)
+        MEMORY_FRAMEBUFFERS,       // Float framebuffers and their display conversions
+        MEMORY_GL_TEXTURES,        // Display texture on the GPU (estimated from its format)
+        MEMORY_RENDER_CACHES,      // Histories and G-buffers reused across frames
+        MEMORY_IMAGE_OUTPUT,       // Encoded images and output bands
+        MEMORY_CATEGORY_COUNT
+    };
+    extern const char* CATEGORY_NAMES[MEMORY_CATEGORY_COUNT];
+
+    // Bytes currently accounted in a category / the most it has held.
+    size_t current(Category category);
+    size_t peak(Category category);
+    size_t total();     // Current bytes over all categories
+    size_t peakTotal(); // Most bytes held at once over all categories
+
+    // Budget over all categories in bytes (0 = unlimited).
+    void setBudget(size_t bytes);
+    size_t budget();
+    // True if the accounted memory plus `extraBytes` fits within the budget.
+    bool fits(size_t extraBytes = 0);
+
+    // Table of current and peak bytes per category, for logs and --memory-stats.
+    std::string report();
+
+    // Bytes held by one owner in one category. Copies hold (and account) the same amount;
+    // the destructor releases it.
+    class Account {
+    public:
+        explicit Account(Category category);
+        Account(const Account& other);
+        Account& operator=(const Account& other);
+        ~Account();
+
+        // Replaces the bytes this account holds.
+        void set(size_t bytes);
+        size_t bytes() const { return held; }
+
+    private:
+        Category category;
+        size_t held;
+    };
+
+    // Bytes of a vector's allocation.
+    template <typename Vector>
+    size_t capacityBytes(const Vector& v) {
+        return v.capacity() * sizeof(typename Vector::value_type);
+    }
+}
+
+#endif // MEMORY_TRACKER_H
@@ -0,0 +1,255 @@
+// src/Net.cpp
+#include "Net.h"
+#include <cstring> // For std::strerror, std::memset
+#include <cerrno>  // For errno
+#include <cstdlib> // For std::atoi
+
+#ifndef _WIN32
+#include <sys/socket.h> // For socket, bind, listen, accept, connect, send, recv
+#include <sys/un.h>     // For sockaddr_un
+#include <netinet/in.h> // For sockaddr_in
+#include <netinet/tcp.h> // For TCP_NODELAY
+#include <arpa/inet.h>  // For inet_pton
+#include <unistd.h>     // For close, unlink
+#include <fcntl.h>      // For fcntl, O_NONBLOCK
+#endif
+
+namespace {
+    thread_local std::string t_lastError;
+
+    int fail(const std::string& what) {
+        t_lastError = what + ": " + std::strerror(errno);
+        return -1;
+    }
+
+    bool isUnixAddress(const std::string& address) {
+        return address.find('/') != std::string::npos;
+    }
+}
+
+#ifndef _WIN32
+
+namespace {
+    // Fills a sockaddr for `address`; returns the address family or -1.
+    int resolve(const std::string& address, sockaddr_un& unixAddr, sockaddr_in& tcpAddr) {
+        if (isUnixAddress(address)) {
+            if (address.size() >= sizeof(unixAddr.sun_path)) {
+                t_lastError = "socket path too long: " + address;
+                return -1;
+            }
+            std::memset(&unixAddr, 0, sizeof(unixAddr));
+            unixAddr.sun_family = AF_UNIX;
+            std::strncpy(unixAddr.sun_path, address.c_str(), sizeof(unixAddr.sun_path) - 1);
+            return AF_UNIX;
+        }
+
+        std::string host = "127.0.0.1";
+        std::string port = address;
+        std::string::size_type colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+        std::memset(&tcpAddr, 0, sizeof(tcpAddr));
+        tcpAddr.sin_family = AF_INET;
+        tcpAddr.sin_port = htons(static_cast<unsigned short>(std::atoi(port.c_str())));
+        if (inet_pton(AF_INET, host.c_str(), &tcpAddr.sin_addr) != 1) {
+            t_lastError = "invalid address: " + address;
+            return -1;
+        }
+        return AF_INET;
+    }
+
+    // Disables Nagle's algorithm: the protocols send small request lines and want low latency.
+    void setNoDelay(int fd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+}
+
+int Net::listenOn(const std::string& address) {
+    sockaddr_un unixAddr;
+    sockaddr_in tcpAddr;
+    int family = resolve(address, unixAddr, tcpAddr);
+    if (family < 0) {
+        return -1;
+    }
+
+    int fd = socket(family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return fail("socket");
+    }
+    int result;
+    if (family == AF_UNIX) {
+        unlink(unixAddr.sun_path); // Remove a stale socket file from a previous run
+        result = bind(fd, reinterpret_cast<sockaddr*>(&unixAddr), sizeof(unixAddr));
+    } else {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        result = bind(fd, reinterpret_cast<sockaddr*>(&tcpAddr), sizeof(tcpAddr));
+    }
+    if (result < 0 || listen(fd, 64) < 0) {
+        fail("bind/listen " + address);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int Net::connectTo(const std::string& address) {
+    sockaddr_un unixAddr;
+    sockaddr_in tcpAddr;
+    int family = resolve(address, unixAddr, tcpAddr);
+    if (family < 0) {
+        return -1;
+    }
+
+    int fd = socket(family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return fail("socket");
+    }
+    int result = family == AF_UNIX
+        ? connect(fd, reinterpret_cast<sockaddr*>(&unixAddr), sizeof(unixAddr))
+        : connect(fd, reinterpret_cast<sockaddr*>(&tcpAddr), sizeof(tcpAddr));
+    if (result < 0) {
+        fail("connect " + address);
+        close(fd);
+        return -1;
+    }
+    if (family == AF_INET) {
+        setNoDelay(fd);
+    }
+    return fd;
+}
+
+int Net::acceptClient(int listenFd) {
+    int fd;
+    do {
+        fd = accept(listenFd, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        return fail("accept");
+    }
+    setNoDelay(fd); // Harmless (ignored) on Unix domain sockets
+    return fd;
+}
+
+bool Net::setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        fail("fcntl");
+        return false;
+    }
+    return true;
+}
+
+bool Net::sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            fail("send");
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool Net::recvAll(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            if (received == 0) {
+                t_lastError = "connection closed";
+            } else {
+                fail("recv");
+            }
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool Net::recvLine(int fd, std::string& line) {
+    // Byte-at-a-time reads keep any binary payload that follows the line in the socket.
+    line.clear();
+    char c;
+    while (recvAll(fd, &c, 1)) {
+        if (c == '\n') {
+            return true;
+        }
+        line += c;
+    }
+    return false;
+}
+
+bool Net::recvAvailable(int fd, std::string& buffer) {
+    char chunk[65536];
+    for (;;) {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (received > 0) {
+            buffer.append(chunk, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true; // Everything that has arrived was read
+        }
+        if (received == 0) {
+            t_lastError = "connection closed";
+        } else {
+            fail("recv");
+        }
+        return false;
+    }
+}
+
+void Net::shutdownSocket(int fd) {
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void Net::closeSocket(int fd) {
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+    }
+}
+
+#else // _WIN32: the networked modes are only supported on POSIX systems.
+
+int Net::listenOn(const std::string&) { t_lastError = "sockets are not supported on this platform"; return -1; }
+int Net::connectTo(const std::string&) { t_lastError = "sockets are not supported on this platform"; return -1; }
+int Net::acceptClient(int) { return -1; }
+bool Net::sendAll(int, const void*, size_t) { return false; }
+bool Net::recvAll(int, void*, size_t) { return false; }
+bool Net::recvLine(int, std::string&) { return false; }
+bool Net::setNonBlocking(int) { return false; }
+bool Net::recvAvailable(int, std::string&) { return false; }
+void Net::shutdownSocket(int) {}
+void Net::closeSocket(int) {}
+
+#endif
+
+bool Net::sendLine(int fd, const std::string& line) {
+    std::string data = line + "\n";
+    return sendAll(fd, data.data(), data.size());
+}
+
+std::string Net::lastError() {
+    return t_lastError;
+}
@@ -0,0 +1,49 @@
+// src/Net.h
+#ifndef NET_H
+#define NET_H
+
+#include <string>
+#include <cstddef>
+
+// Thin wrappers around POSIX stream sockets used by the render service and distributed mode.
+// Addresses are either a Unix domain socket path (anything containing a '/')
+// or a TCP "host:port" / "port" pair (host defaults to 127.0.0.1).
+namespace Net {
+    // Creates a listening socket for `address`. Returns the file descriptor, or -1 (see lastError()).
+    int listenOn(const std::string& address);
+
+    // Connects to `address`. Returns the file descriptor, or -1.
+    int connectTo(const std::string& address);
+
+    // Accepts one connection on a listening socket. Returns the new descriptor, or -1
+    // (also when a non-blocking socket has no pending connection).
+    int acceptClient(int listenFd);
+
+    // Makes accept() on a listening socket return at once when no client is waiting.
+    bool setNonBlocking(int fd);
+
+    // Sends/receives exactly `size` bytes. Return false on error or if the peer hung up.
+    bool sendAll(int fd, const void* data, size_t size);
+    bool recvAll(int fd, void* data, size_t size);
+
+    // Sends `line` followed by '\n'.
+    bool sendLine(int fd, const std::string& line);
+
+    // Reads up to (and strips) the next '\n'. Returns false on error or EOF.
+    bool recvLine(int fd, std::string& line);
+
+    // Appends whatever bytes have already arrived to `buffer` without waiting for more.
+    // Returns false on error or if the peer hung up.
+    bool recvAvailable(int fd, std::string& buffer);
+
+    // Shuts down both directions without closing, waking threads blocked in accept/recv.
+    void shutdownSocket(int fd);
+
+    // Shuts down and closes a socket.
+    void closeSocket(int fd);
+
+    // Description of the last failure in this thread.
+    std::string lastError();
+}
+
+#endif // NET_H
@@ -2,10 +2,13 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
+#include <cstddef> // Required for size_t
 #include "Vec3.h" // Required for Vec3f
 #include "Ray.h"  // Required for Ray class definition
 
-// Structure to hold intersection information
+class Frustum; // Frustum.h
+
+// Surface attributes of a ray hit (filled by Object::hitAttributes)
 struct IntersectionInfo {
     Vec3f point;    // Point of intersection
     Vec3f normal;   // Normal at the intersection point
@@ -24,10 +27,23 @@ public:
     // Virtual destructor to ensure proper cleanup of derived classes
     virtual ~Object() = default;
 
-    // Pure virtual function for ray-object intersection.
-    // Derived classes must implement this.
-    // Returns true if an intersection occurs, and fills the IntersectionInfo struct.
-    virtual bool intersect(const Ray& ray, IntersectionInfo& info) const = 0;
+    // Intersection is split in two stages, so that searching for the closest hit among many
+    // objects only pays for distances, and surface attributes (point, normal and any future
+    // data such as UVs) are computed once, for the hit that is kept.
+
+    // Stage 1: distance along `ray` to the nearest intersection in front of its origin
+    // (beyond a small self-intersection epsilon). Returns false if there is none.
+    virtual bool hitDistance(const Ray& ray, float& distance) const = 0;
+
+    // Stage 2: surface attributes of the hit `distance` along `ray`, as found by hitDistance().
+    virtual void hitAttributes(const Ray& ray, float distance, IntersectionInfo& info) const = 0;
+
+    // True if the object lies entirely outside `frustum`, so that no ray inside it can hit the
+    // object (used to cull objects per screen tile). Objects without bounds are never excluded.
+    virtual bool outsideFrustum(const Frustum& frustum) const { (void)frustum; return false; }
+
+    // Bytes this object occupies, including any data it owns (for memory accounting).
+    virtual size_t memorySize() const = 0;
 };
 
 #endif // OBJECT_H
@@ -0,0 +1,73 @@
+// src/PacketKernels.h
+#ifndef PACKET_KERNELS_H
+#define PACKET_KERNELS_H
+
+#include <cfloat> // For FLT_MAX
+
+#include "SimdMath.h"
+
+// Intersection and shading math for W rays at a time, written on the SoA types of
+// SimdMath.h. Each function performs the same arithmetic as its scalar counterpart
+// (Sphere::hitDistance, Plane::hitDistance, Scene::shade, Utils::toByte), so packet and
+// scalar paths agree; lanes are independent and never branch.
+namespace SIMD_NAMESPACE {
+
+// Distance reported for rays that miss (matches the initial closest distance in Scene::trace).
+const float PACKET_MISS = FLT_MAX;
+
+// Nearest distance along each ray to the sphere, or PACKET_MISS.
+// Like Sphere::hitDistance, hits closer than 1e-4 are ignored (self-intersection guard).
+template <int W>
+inline FloatN<W> intersectSphere(const Vec3xN<W>& origin, const Vec3xN<W>& direction, const Vec3f& center, float radius) {
+    const Vec3xN<W> oc = origin - Vec3xN<W>(center);
+    const FloatN<W> a = direction.dot(direction);
+    const FloatN<W> b = 2.0f * oc.dot(direction);
+    const FloatN<W> c = oc.dot(oc) - FloatN<W>(radius * radius);
+    const FloatN<W> discriminant = b * b - 4.0f * a * c;
+
+    const FloatN<W> root = sqrt(max(discriminant, FloatN<W>(0.0f)));
+    const FloatN<W> twoA = 2.0f * a;
+    const FloatN<W> t0 = (-b - root) / twoA;
+    const FloatN<W> t1 = (-b + root) / twoA;
+    const FloatN<W> t = select(t0 > FloatN<W>(1e-4f), t0, select(t1 > FloatN<W>(1e-4f), t1, FloatN<W>(PACKET_MISS)));
+    return select(discriminant >= FloatN<W>(0.0f), t, FloatN<W>(PACKET_MISS));
+}
+
+// Distance along each ray to the plane, or PACKET_MISS (parallel rays and hits behind 1e-4 miss).
+template <int W>
+inline FloatN<W> intersectPlane(const Vec3xN<W>& origin, const Vec3xN<W>& direction, const Vec3f& point, const Vec3f& normal) {
+    const Vec3xN<W> n(normal);
+    const FloatN<W> denom = direction.dot(n);
+    const FloatN<W> t = (Vec3xN<W>(point) - origin).dot(n) / denom;
+    const MaskN<W> facing = (denom > FloatN<W>(1e-6f)) | (denom < FloatN<W>(-1e-6f));
+    return select(facing & (t > FloatN<W>(1e-4f)), t, FloatN<W>(PACKET_MISS));
+}
+
+// Lambert factor max(0, N . L) of a point light at W surface points.
+template <int W, Precision P>
+inline FloatN<W> lambert(const Vec3xN<W>& point, const Vec3xN<W>& normal, const Vec3f& lightPosition) {
+    const Vec3xN<W> toLight = (Vec3xN<W>(lightPosition) - point).template normalize<P>();
+    return max(normal.dot(toLight), FloatN<W>(0.0f));
+}
+
+// Converts colour components to 8 bits, exactly as Utils::toByte.
+template <int W>
+inline void quantize(const FloatN<W>& value, unsigned char* out) {
+    const FloatN<W> scaled = 255.99f * min(max(value, FloatN<W>(0.0f)), FloatN<W>(1.0f));
+#ifdef SIMD_MATH_VECTOR_EXT
+    // Truncating to 32-bit lanes first keeps the conversion vectorized; the values fit in a byte.
+    typedef typename MaskN<W>::Native Ints; // W 32-bit integer lanes
+    const Ints bytes = __builtin_convertvector(scaled.v, Ints);
+    for (int k = 0; k < W; ++k) {
+        out[k] = static_cast<unsigned char>(bytes[k]);
+    }
+#else
+    for (int k = 0; k < W; ++k) {
+        out[k] = static_cast<unsigned char>(scaled.lane[k]);
+    }
+#endif
+}
+
+} // namespace SIMD_NAMESPACE
+
+#endif // PACKET_KERNELS_H
@@ -0,0 +1,52 @@
+// src/Parallel.cpp
+#include "Parallel.h"
+#include <thread> // For std::thread
+#include <atomic> // For std::atomic
+#include <vector>
+
+namespace {
+    int g_threadCountOverride = 0; // 0 = use std::thread::hardware_concurrency()
+
+    // Runs worker(threadIndex) on `count` threads, using the calling thread as thread 0.
+    void runOn(int count, const std::function<void(int)>& worker) {
+        std::vector<std::thread> threads;
+        threads.reserve(count > 1 ? count - 1 : 0);
+        for (int t = 1; t < count; ++t) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+int Parallel::threadCount() {
+    if (g_threadCountOverride > 0) {
+        return g_threadCountOverride;
+    }
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+void Parallel::setThreadCount(int count) {
+    g_threadCountOverride = count > 0 ? count : 0;
+}
+
+void Parallel::run(const std::function<void(int)>& worker) {
+    runOn(threadCount(), worker);
+}
+
+void Parallel::forEach(int count, const std::function<void(int)>& body) {
+    if (count <= 0) {
+        return;
+    }
+    // Never start more threads than there are work items.
+    int threads = threadCount() < count ? threadCount() : count;
+    std::atomic<int> next(0);
+    runOn(threads, [&](int) {
+        for (int i = next++; i < count; i = next++) {
+            body(i);
+        }
+    });
+}
@@ -0,0 +1,22 @@
+// src/Parallel.h
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+// Minimal helpers for spreading work over all CPU cores.
+namespace Parallel {
+    // Number of threads used by run() and forEach() (defaults to the hardware concurrency).
+    int threadCount();
+
+    // Overrides the thread count; 0 restores the hardware default.
+    void setThreadCount(int count);
+
+    // Runs worker(threadIndex) on threadCount() threads (the caller is thread 0) and waits for all.
+    void run(const std::function<void(int)>& worker);
+
+    // Calls body(i) for every i in [0, count), handing out indices dynamically across threads.
+    void forEach(int count, const std::function<void(int)>& body);
+}
+
+#endif // PARALLEL_H
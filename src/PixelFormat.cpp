@@ -0,0 +1,171 @@
+// src/PixelFormat.cpp
+#include "PixelFormat.h"
+#include <cmath>   // For std::ldexp
+#include <cstring> // For std::memcpy
+#include <algorithm> // For std::max, std::min
+
+const char* PIXEL_FORMAT_NAMES[PIXEL_FORMAT_COUNT] = {
+    "RGB32F (12 B/px)",
+    "RGB16F (6 B/px)",
+    "RGB9E5 (4 B/px)"
+};
+
+size_t PixelPacking::bytesPerPixel(PixelFormat format) {
+    switch (format) {
+    case PIXEL_RGB16F: return 3 * sizeof(uint16_t);
+    case PIXEL_RGB9E5: return sizeof(uint32_t);
+    default:           return sizeof(Vec3f);
+    }
+}
+
+uint16_t PixelPacking::floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7fffffffu;
+
+    if (magnitude >= 0x7f800000u) {
+        return static_cast<uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u)); // Inf / NaN
+    }
+    if (magnitude >= 0x47800000u) {
+        return static_cast<uint16_t>(sign | 0x7c00u); // >= 65536: too large even after rounding
+    }
+    if (magnitude < 0x38800000u) {
+        // Below the smallest normal half (2^-14): subnormal half in units of 2^-24.
+        if (magnitude < 0x33000000u) {
+            return static_cast<uint16_t>(sign); // Rounds to zero
+        }
+        const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        const int shift = 126 - static_cast<int>(magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Normal range: rebias the exponent and round the dropped 13 mantissa bits.
+    // A carry out of the mantissa correctly bumps the exponent (up to infinity).
+    uint32_t half = (magnitude >> 13) - ((127u - 15u) << 10);
+    const uint32_t remainder = magnitude & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float PixelPacking::halfToFloat(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1fu;
+    const uint32_t mantissa = half & 0x3ffu;
+    if (exponent == 0) {
+        float value = std::ldexp(static_cast<float>(mantissa), -24); // Zero or subnormal
+        return sign ? -value : value;
+    }
+    uint32_t bits = exponent == 31
+        ? sign | 0x7f800000u | (mantissa << 13)                  // Inf / NaN
+        : sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+namespace {
+    const int RGB9E5_MANTISSA_BITS = 9;
+    const int RGB9E5_EXPONENT_BIAS = 15;
+    const float RGB9E5_MAX_VALUE = 65408.0f; // (511 / 512) * 2^16
+
+    // 2^power for a power within the normal float range, built from its bits.
+    float powerOfTwo(int power) {
+        uint32_t bits = static_cast<uint32_t>(power + 127) << 23;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    float clampRGB9E5(float value) {
+        // The comparison order also maps NaN to 0.
+        return value > 0.0f ? std::min(value, RGB9E5_MAX_VALUE) : 0.0f;
+    }
+}
+
+uint32_t PixelPacking::packRGB9E5(const Vec3f& color) {
+    const float r = clampRGB9E5(color.x);
+    const float g = clampRGB9E5(color.y);
+    const float b = clampRGB9E5(color.z);
+    const float maxChannel = std::max(r, std::max(g, b));
+
+    // Shared exponent from the brightest channel: max(-bias - 1, floor(log2(max))) + 1 + bias.
+    // floor(log2(max)) is read straight from the float's exponent bits (0 and denormals clamp).
+    uint32_t maxBits;
+    std::memcpy(&maxBits, &maxChannel, sizeof(maxBits));
+    int exponent = std::max(-RGB9E5_EXPONENT_BIAS - 1, static_cast<int>(maxBits >> 23) - 127) + 1 + RGB9E5_EXPONENT_BIAS;
+    float scale = powerOfTwo(RGB9E5_MANTISSA_BITS + RGB9E5_EXPONENT_BIAS - exponent);
+
+    // Rounding the brightest channel up may overflow its 9 bits: use the next exponent instead.
+    if (static_cast<uint32_t>(maxChannel * scale + 0.5f) == (1u << RGB9E5_MANTISSA_BITS)) {
+        ++exponent;
+        scale *= 0.5f;
+    }
+
+    const uint32_t rm = static_cast<uint32_t>(r * scale + 0.5f);
+    const uint32_t gm = static_cast<uint32_t>(g * scale + 0.5f);
+    const uint32_t bm = static_cast<uint32_t>(b * scale + 0.5f);
+    return rm | (gm << 9) | (bm << 18) | (static_cast<uint32_t>(exponent) << 27);
+}
+
+Vec3f PixelPacking::unpackRGB9E5(uint32_t packed) {
+    const int exponent = static_cast<int>(packed >> 27);
+    const float scale = powerOfTwo(exponent - RGB9E5_EXPONENT_BIAS - RGB9E5_MANTISSA_BITS);
+    return Vec3f(static_cast<float>(packed & 0x1ffu) * scale,
+                 static_cast<float>((packed >> 9) & 0x1ffu) * scale,
+                 static_cast<float>((packed >> 18) & 0x1ffu) * scale);
+}
+
+void PixelPacking::pack(PixelFormat format, const Vec3f* src, size_t count, void* dst) {
+    switch (format) {
+    case PIXEL_RGB16F: {
+        uint16_t* out = static_cast<uint16_t*>(dst);
+        for (size_t k = 0; k < count; ++k) {
+            out[3 * k + 0] = floatToHalf(src[k].x);
+            out[3 * k + 1] = floatToHalf(src[k].y);
+            out[3 * k + 2] = floatToHalf(src[k].z);
+        }
+        break;
+    }
+    case PIXEL_RGB9E5: {
+        uint32_t* out = static_cast<uint32_t*>(dst);
+        for (size_t k = 0; k < count; ++k) {
+            out[k] = packRGB9E5(src[k]);
+        }
+        break;
+    }
+    default:
+        std::memcpy(dst, src, count * sizeof(Vec3f));
+        break;
+    }
+}
+
+void PixelPacking::unpack(PixelFormat format, const void* src, size_t count, Vec3f* dst) {
+    switch (format) {
+    case PIXEL_RGB16F: {
+        const uint16_t* in = static_cast<const uint16_t*>(src);
+        for (size_t k = 0; k < count; ++k) {
+            dst[k] = Vec3f(halfToFloat(in[3 * k + 0]), halfToFloat(in[3 * k + 1]), halfToFloat(in[3 * k + 2]));
+        }
+        break;
+    }
+    case PIXEL_RGB9E5: {
+        const uint32_t* in = static_cast<const uint32_t*>(src);
+        for (size_t k = 0; k < count; ++k) {
+            dst[k] = unpackRGB9E5(in[k]);
+        }
+        break;
+    }
+    default:
+        std::memcpy(dst, src, count * sizeof(Vec3f));
+        break;
+    }
+}
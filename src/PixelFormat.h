@@ -0,0 +1,44 @@
+// src/PixelFormat.h
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Vec3.h"
+
+// Storage formats for RGB pixels.
+// Rendering always computes in float; these formats only decide how pixels are stored
+// and moved around, trading precision for memory bandwidth:
+//   RGB32F  12 bytes  exact; used where samples are accumulated
+//   RGB16F   6 bytes  half floats: 11-bit mantissa per channel, range up to 65504
+//   RGB9E5   4 bytes  9-bit mantissas sharing one 5-bit exponent (GL_RGB9_E5); no negatives,
+//                     precision relative to the brightest channel. Plenty for LDR display.
+enum PixelFormat {
+    PIXEL_RGB32F,
+    PIXEL_RGB16F,
+    PIXEL_RGB9E5,
+    PIXEL_FORMAT_COUNT
+};
+
+extern const char* PIXEL_FORMAT_NAMES[PIXEL_FORMAT_COUNT];
+
+namespace PixelPacking {
+    // Bytes used per pixel in `format`.
+    size_t bytesPerPixel(PixelFormat format);
+
+    // IEEE 754 binary16 conversion with round-to-nearest-even (overflow becomes infinity).
+    uint16_t floatToHalf(float value);
+    float halfToFloat(uint16_t half);
+
+    // Shared-exponent encoding as specified by EXT_texture_shared_exponent
+    // (red in bits 0-8, green 9-17, blue 18-26, exponent 27-31). Negative values become 0.
+    uint32_t packRGB9E5(const Vec3f& color);
+    Vec3f unpackRGB9E5(uint32_t packed);
+
+    // Converts `count` pixels between float RGB and `format`. dst/src hold count * bytesPerPixel(format) bytes.
+    void pack(PixelFormat format, const Vec3f* src, size_t count, void* dst);
+    void unpack(PixelFormat format, const void* src, size_t count, Vec3f* dst);
+}
+
+#endif // PIXEL_FORMAT_H
@@ -1,5 +1,6 @@
 // src/Plane.cpp
 #include "Plane.h"
+#include "Frustum.h"
 #include <limits> // For std::numeric_limits
 #include <cmath>  // For std::fabs
 
@@ -7,7 +8,7 @@
 // because it is explicitly defaulted in the header (Plane.h),
 // and the compiler will generate its definition automatically.
 
-// Implements the ray-plane intersection test.
+// Implements the ray-plane distance test.
 // A ray is defined as R(t) = O + tD, where O is origin, D is direction.
 // A plane is defined as (P - A) . N = 0, where P is any point on the plane, A is a known point on the plane, N is the normal.
 // Substituting R(t) for P: (O + tD - A) . N = 0
@@ -15,7 +16,7 @@
 // t = ((A - O) . N) / (D . N)
 // If D . N is zero, the ray is parallel to the plane (no intersection or ray is on the plane).
 // If t < 0, the intersection is behind the ray origin.
-bool Plane::intersect(const Ray& ray, IntersectionInfo& info) const {
+bool Plane::hitDistance(const Ray& ray, float& distance) const {
     float denom = ray.direction.dot(normal);
 
     // Check if the ray is parallel to the plane (or nearly parallel)
@@ -30,11 +31,20 @@ bool Plane::intersect(const Ray& ray, IntersectionInfo& info) const {
     // Check if the intersection point is in front of the ray origin
     // Use a small epsilon to avoid self-intersection issues when the ray origin is on the plane
     if (t > 1e-4f) {
-        info.distance = t;
-        info.point = ray.origin + ray.direction * t;
-        info.normal = normal; // The normal of the plane is constant
+        distance = t;
         return true;
     }
 
     return false; // Intersection is behind the ray origin or too close
 }
+
+// Computes the hit point for a distance found by hitDistance().
+void Plane::hitAttributes(const Ray& ray, float distance, IntersectionInfo& info) const {
+    info.distance = distance;
+    info.point = ray.origin + ray.direction * distance;
+    info.normal = normal; // The normal of the plane is constant
+}
+
+bool Plane::outsideFrustum(const Frustum& frustum) const {
+    return frustum.excludesPlane(point, normal);
+}
@@ -21,9 +21,16 @@ public:
     // in the header if its definition is out-of-line (in the .cpp file).
     virtual ~Plane() = default;
 
-    // Implements the ray-plane intersection test.
-    // Returns true if an intersection occurs, and fills the IntersectionInfo struct.
-    bool intersect(const Ray& ray, IntersectionInfo& info) const override;
+    // Ray-plane intersection distance; rays parallel to the plane miss.
+    bool hitDistance(const Ray& ray, float& distance) const override;
+
+    // Hit point; the normal is the plane's own.
+    void hitAttributes(const Ray& ray, float distance, IntersectionInfo& info) const override;
+
+    // Planes are unbounded, but a frustum can still lie entirely on their back side.
+    bool outsideFrustum(const Frustum& frustum) const override;
+
+    size_t memorySize() const override { return sizeof(Plane); }
 };
 
 #endif // PLANE_H
@@ -0,0 +1,155 @@
+// src/ProgressiveRender.cpp
+#include "ProgressiveRender.h"
+#include "Checkpoint.h"
+#include "Renderer.h"
+#include "Parallel.h"
+#include "MemoryTracker.h"
+#include "StreamingOutput.h"
+#include <algorithm> // For std::min, std::min_element
+#include <atomic>    // For std::atomic
+#include <chrono>    // For checkpoint intervals
+#include <csignal>   // For std::signal
+#include <cstdio>    // For printf
+#include <memory>    // For std::unique_ptr
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // Set by the signal handler; tiles that have not started yet are skipped once it is set.
+    std::atomic<bool> g_stopRequested(false);
+
+    extern "C" void requestStop(int) {
+        g_stopRequested = true;
+    }
+
+    // Installs requestStop() for SIGINT and SIGTERM while it exists.
+    struct StopSignals {
+        void (*previousInterrupt)(int);
+        void (*previousTerminate)(int);
+
+        StopSignals() {
+            g_stopRequested = false;
+            previousInterrupt = std::signal(SIGINT, requestStop);
+            previousTerminate = std::signal(SIGTERM, requestStop);
+        }
+        ~StopSignals() {
+            std::signal(SIGINT, previousInterrupt);
+            std::signal(SIGTERM, previousTerminate);
+        }
+    };
+}
+
+int ProgressiveRender::render(const Scene& scene, const Camera& camera, const Options& options, std::vector<Vec3f>& image) {
+    const int width = camera.imageWidth;
+    const int height = camera.imageHeight;
+
+    RenderCheckpoint state;
+    state.scene = options.scene;
+    state.width = width;
+    state.height = height;
+    state.samples = options.samples > 0 ? options.samples : 1;
+    state.shadows = options.shadows;
+    state.eye = camera.eyePosition;
+    state.lookAt = camera.lookAt;
+    state.up = camera.upVector;
+    state.fov = camera.fov;
+    state.fingerprint = StreamingOutput::fingerprint(scene, camera, state.samples);
+    state.reset();
+
+    std::string error;
+    RenderCheckpoint saved;
+    if (options.resume && !options.checkpointPath.empty()) {
+        if (!saved.load(options.checkpointPath, error)) {
+            fprintf(stderr, "Error: %s.\n", error.c_str());
+            return -1;
+        }
+        if (!saved.sameSettings(state)) {
+            fprintf(stderr, "Error: %s was written for a different scene, camera or sample count.\n",
+                    options.checkpointPath.c_str());
+            return -1;
+        }
+        state = std::move(saved);
+    }
+    MemoryTracker::Account memory(MemoryTracker::MEMORY_RENDER_CACHES);
+    memory.set(MemoryTracker::capacityBytes(state.accumulation) + MemoryTracker::capacityBytes(state.sampleCounts));
+
+    const int tilesX = (width + options.tileSize - 1) / options.tileSize;
+    const int tilesY = (height + options.tileSize - 1) / options.tileSize;
+    const int firstPass = static_cast<int>(*std::min_element(state.sampleCounts.begin(), state.sampleCounts.end()));
+    printf("%s %dx%d at %d samples per pixel from pass %d\n", firstPass > 0 ? "Resuming" : "Rendering", width, height,
+           state.samples, firstPass + 1);
+
+    Renderer renderer(&scene, &camera);
+    renderer.samplesPerPixel = 1;
+    renderer.shadows = options.shadows;
+    std::unique_ptr<CheckpointWriter> writer(options.checkpointPath.empty() ? nullptr
+                                                                            : new CheckpointWriter(options.checkpointPath));
+    StopSignals signals;
+    Clock::time_point lastCheckpoint = Clock::now();
+    for (int pass = firstPass; pass < state.samples && !g_stopRequested; ++pass) {
+        renderer.firstSample = pass;
+        Parallel::forEach(tilesX * tilesY, [&](int index) {
+            Tile tile;
+            tile.x0 = (index % tilesX) * options.tileSize;
+            tile.y0 = (index / tilesX) * options.tileSize;
+            tile.x1 = std::min(tile.x0 + options.tileSize, width);
+            tile.y1 = std::min(tile.y0 + options.tileSize, height);
+            // Only pixels this pass has not reached yet take the sample (after a resume, tiles
+            // rendered before the stop already have it).
+            bool behind = false;
+            for (int j = tile.y0; j < tile.y1 && !behind; ++j) {
+                for (int i = tile.x0; i < tile.x1 && !behind; ++i) {
+                    behind = state.sampleCounts[j * width + i] == static_cast<uint32_t>(pass);
+                }
+            }
+            if (g_stopRequested || !behind) {
+                return;
+            }
+            std::vector<Vec3f> samples(tile.pixelCount());
+            renderer.renderTile(tile, samples.data(), tile.width());
+            for (int j = tile.y0; j < tile.y1; ++j) {
+                for (int i = tile.x0; i < tile.x1; ++i) {
+                    const int k = j * width + i;
+                    if (state.sampleCounts[k] == static_cast<uint32_t>(pass)) {
+                        state.accumulation[k] += samples[(j - tile.y0) * tile.width() + i - tile.x0];
+                        ++state.sampleCounts[k];
+                    }
+                }
+            }
+        });
+
+        if (writer && !g_stopRequested && pass + 1 < state.samples &&
+            std::chrono::duration<double>(Clock::now() - lastCheckpoint).count() >= options.checkpointSeconds) {
+            if (writer->submit(state)) {
+                lastCheckpoint = Clock::now();
+            }
+        }
+        printf("Pass %d/%d\n", pass + 1, state.samples);
+    }
+
+    // After a stop the state may end part-way through a pass, which the counts record.
+    const bool stopped = g_stopRequested;
+    if (writer) {
+        bool ok = writer->finish();
+        if (stopped) {
+            ok = state.save(options.checkpointPath, error);
+            if (!ok) {
+                fprintf(stderr, "Error: %s.\n", error.c_str());
+            } else {
+                printf("Stopped; checkpoint saved to %s (resume with --resume)\n", options.checkpointPath.c_str());
+            }
+        }
+        if (!ok) {
+            return -1;
+        }
+    }
+    if (stopped) {
+        return 1;
+    }
+
+    image.resize(state.accumulation.size());
+    for (size_t k = 0; k < image.size(); ++k) {
+        image[k] = state.accumulation[k] / static_cast<float>(state.sampleCounts[k]);
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+// src/ProgressiveRender.h
+#ifndef PROGRESSIVE_RENDER_H
+#define PROGRESSIVE_RENDER_H
+
+#include <string>
+#include <vector>
+
+#include "Vec3.h"
+#include "Scene.h"
+#include "Camera.h"
+
+// Long offline renders that survive being stopped.
+// The image is rendered in passes of one sample per pixel (sample p in pass p, see
+// Renderer::firstSample: pass 0 traces the pixel centers, later passes jitter), each added
+// to a per-pixel sum. The sums, per-pixel sample counts and frame settings are checkpointed
+// (Checkpoint.h) every `checkpointSeconds` on a background thread, and once more when the
+// render is stopped by SIGINT or SIGTERM. A resumed render skips the pixels each pass already
+// covered; since every sample is added to its pixel in the same order, the result is
+// bit-identical to an uninterrupted render.
+namespace ProgressiveRender {
+    struct Options {
+        std::string scene;              // Scene name recorded in the checkpoint
+        int samples = 16;               // Samples per pixel of the finished image
+        bool shadows = true;
+        std::string checkpointPath;     // Empty = no checkpoints
+        double checkpointSeconds = 60.0;
+        bool resume = false;            // Continue from the render saved in checkpointPath
+        int tileSize = 32;
+    };
+
+    // Renders `camera`'s image into `image` (the average of each pixel's samples).
+    // Returns 0 when finished, 1 if stopped by a signal (after the final checkpoint was written),
+    // or -1 if the checkpoint does not match the frame or cannot be read or written.
+    int render(const Scene& scene, const Camera& camera, const Options& options, std::vector<Vec3f>& image);
+}
+
+#endif // PROGRESSIVE_RENDER_H
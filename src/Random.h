@@ -0,0 +1,28 @@
+// src/Random.h
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Stateless random numbers for sampling.
+// Values are derived by hashing (pixel, sample, dimension) indices, so a sample always
+// gets the same random numbers no matter which thread or in which order it is rendered.
+namespace Random {
+    // Integer hash with good avalanche behaviour ("lowbias32").
+    inline uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Uniform float in [0, 1) for the given indices.
+    inline float uniform(uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t h = hash(a ^ hash(b ^ hash(c)));
+        return (h >> 8) * (1.0f / 16777216.0f); // 24 random bits
+    }
+}
+
+#endif // RANDOM_H
@@ -0,0 +1,444 @@
+// src/RenderService.cpp
+#include "RenderService.h"
+#include "Renderer.h"
+#include "Utils.h"
+#include "Net.h"
+#include "MemoryTracker.h"
+#include <algorithm> // For std::min
+#include <sstream>  // For std::istringstream
+#include <fstream>  // For std::ofstream
+#include <map>
+#include <thread>   // For std::thread
+#include <chrono>   // For std::chrono::steady_clock
+#include <cstdio>   // For fprintf
+#include <cstdlib>  // For std::strtol, std::strtof
+
+namespace {
+    // Back-off of the accept loop after a failed accept (e.g. out of file descriptors, EMFILE):
+    // the pending connection stays queued, so retrying at once would spin at full CPU.
+    const int ACCEPT_RETRY_MIN_MS = 10;
+    const int ACCEPT_RETRY_MAX_MS = 1000;
+    const int ACCEPT_ERROR_REPORT_SEC = 10; // A failure that persists is logged again this often
+
+    // Parses "x,y,z" into a vector.
+    bool parseVec3(const std::string& text, Vec3f& out) {
+        char comma1 = 0, comma2 = 0;
+        std::istringstream input(text);
+        return static_cast<bool>(input >> out.x >> comma1 >> out.y >> comma2 >> out.z) && comma1 == ',' && comma2 == ',';
+    }
+
+    // Parses an integer within [minValue, maxValue].
+    bool parseInt(const std::string& text, int minValue, int maxValue, int& out) {
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != '\0' || value < minValue || value > maxValue) {
+            return false;
+        }
+        out = static_cast<int>(value);
+        return true;
+    }
+}
+
+const int RenderJob::MAX_SIZE;
+
+bool RenderJob::parse(const std::string& text, std::string& error, int maxSize) {
+    std::istringstream tokens(text);
+    std::string token;
+    while (tokens >> token) {
+        std::string::size_type equals = token.find('=');
+        if (equals == std::string::npos) {
+            error = "expected key=value, got '" + token + "'";
+            return false;
+        }
+        std::string key = token.substr(0, equals);
+        std::string value = token.substr(equals + 1);
+
+        bool ok = true;
+        if (key == "id") {
+            id = value;
+        } else if (key == "scene") {
+            scene = value;
+        } else if (key == "width") {
+            ok = parseInt(value, 1, maxSize, width);
+        } else if (key == "height") {
+            ok = parseInt(value, 1, maxSize, height);
+        } else if (key == "samples") {
+            ok = parseInt(value, 1, 4096, samples);
+        } else if (key == "priority") {
+            ok = parseInt(value, -1000, 1000, priority);
+        } else if (key == "eye") {
+            ok = hasEye = parseVec3(value, eye);
+        } else if (key == "lookat") {
+            ok = hasLookAt = parseVec3(value, lookAt);
+        } else if (key == "fov") {
+            fov = std::strtof(value.c_str(), nullptr);
+            ok = hasFov = fov > 0.0f && fov < 180.0f;
+        } else {
+            error = "unknown key '" + key + "'";
+            return false;
+        }
+        if (!ok) {
+            error = "invalid value for '" + key + "': " + value;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string RenderJob::toString() const {
+    std::ostringstream text;
+    text.precision(9); // Round-trips floats exactly
+    text << "id=" << id << " scene=" << scene << " width=" << width << " height=" << height
+         << " samples=" << samples << " priority=" << priority;
+    if (hasEye) {
+        text << " eye=" << eye.x << "," << eye.y << "," << eye.z;
+    }
+    if (hasLookAt) {
+        text << " lookat=" << lookAt.x << "," << lookAt.y << "," << lookAt.z;
+    }
+    if (hasFov) {
+        text << " fov=" << fov;
+    }
+    return text.str();
+}
+
+Camera RenderJob::makeCamera(const SceneCamera& sceneCamera) const {
+    return Camera(hasEye ? eye : sceneCamera.eye,
+                  hasLookAt ? lookAt : sceneCamera.lookAt,
+                  Vec3f(0.0f, 1.0f, 0.0f),
+                  hasFov ? fov : sceneCamera.fov,
+                  width, height);
+}
+
+// A connected client. Replies from the render thread and the client's own thread
+// are serialized by writeMutex; the socket is closed once no queued job refers to it.
+struct RenderServer::Connection {
+    int fd;
+    std::mutex writeMutex;
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { Net::closeSocket(fd); }
+
+    bool reply(const std::string& line, const std::string& payload = std::string()) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return Net::sendLine(fd, line) && (payload.empty() || Net::sendAll(fd, payload.data(), payload.size()));
+    }
+};
+
+RenderServer::RenderServer(const std::string& address)
+    : address(address), listenFd(-1), nextSequence(0), renderedJobs(0), stopping(false), activeClients(0) {}
+
+int RenderServer::run() {
+    listenFd = Net::listenOn(address);
+    if (listenFd < 0) {
+        fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+        return -1;
+    }
+    fprintf(stdout, "Render service listening on %s\n", address.c_str());
+
+    std::thread renderThread(&RenderServer::renderLoop, this);
+
+    // Every client gets a thread that reads its commands.
+    int retryMs = 0;              // Current back-off, 0 while accept works
+    long failures = 0;            // Failed accepts since the last success
+    std::chrono::steady_clock::time_point lastReport;
+    while (!stopping) {
+        int fd = Net::acceptClient(listenFd);
+        if (fd < 0) {
+            if (stopping) {
+                break; // Woken up by SHUTDOWN
+            }
+            retryMs = retryMs > 0 ? std::min(retryMs * 2, ACCEPT_RETRY_MAX_MS) : ACCEPT_RETRY_MIN_MS;
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (failures++ == 0 || now - lastReport >= std::chrono::seconds(ACCEPT_ERROR_REPORT_SEC)) {
+                fprintf(stderr, "Warning: %s (%ld failed accepts), retrying in %d ms\n", Net::lastError().c_str(), failures,
+                        retryMs);
+                lastReport = now;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(retryMs));
+            continue;
+        }
+        if (failures > 0) {
+            fprintf(stderr, "Accepting connections again after %ld failed accepts\n", failures);
+            failures = 0;
+            retryMs = 0;
+        }
+        std::shared_ptr<Connection> connection(new Connection(fd));
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            // Forget connections that are gone before remembering the new one.
+            std::vector<std::weak_ptr<Connection> > live;
+            for (size_t c = 0; c < connections.size(); ++c) {
+                if (!connections[c].expired()) {
+                    live.push_back(connections[c]);
+                }
+            }
+            live.push_back(connection);
+            connections.swap(live);
+            ++activeClients;
+        }
+        std::thread(&RenderServer::handleClient, this, connection).detach();
+    }
+
+    queueChanged.notify_all();
+    renderThread.join();
+
+    // Wake up the client threads blocked in recv and wait for them to finish.
+    {
+        std::unique_lock<std::mutex> lock(clientsMutex);
+        for (size_t c = 0; c < connections.size(); ++c) {
+            std::shared_ptr<Connection> connection = connections[c].lock();
+            if (connection) {
+                Net::shutdownSocket(connection->fd);
+            }
+        }
+        clientsDone.wait(lock, [this] { return activeClients == 0; });
+    }
+    Net::closeSocket(listenFd);
+    fprintf(stdout, "Render service stopped after %lu jobs\n", renderedJobs);
+    return 0;
+}
+
+void RenderServer::handleClient(std::shared_ptr<Connection> connection) {
+    std::string line;
+    while (!stopping && Net::recvLine(connection->fd, line)) {
+        std::istringstream input(line);
+        std::string command;
+        input >> command;
+
+        if (command == "RENDER") {
+            std::string spec;
+            std::getline(input, spec);
+            QueuedJob queued;
+            std::string error;
+            if (!queued.job.parse(spec, error)) {
+                connection->reply("ERROR " + (queued.job.id.empty() ? std::string("-") : queued.job.id) + " " + error);
+                continue;
+            }
+            queued.connection = connection;
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queued.sequence = nextSequence++;
+            if (queued.job.id.empty()) {
+                queued.job.id = "job" + std::to_string(queued.sequence);
+            }
+            queue.push_back(queued);
+            queueChanged.notify_one();
+        } else if (command == "STATS") {
+            size_t queued;
+            unsigned long rendered;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queued = queue.size();
+                rendered = renderedJobs;
+            }
+            connection->reply("STATS queued=" + std::to_string(queued) +
+                              " rendered=" + std::to_string(rendered) +
+                              " cacheHits=" + std::to_string(cache.hits()) +
+                              " cacheMisses=" + std::to_string(cache.misses()) +
+                              " resident=" + std::to_string(cache.residentScenes()));
+        } else if (command == "SHUTDOWN") {
+            connection->reply("BYE");
+            stopping = true;
+            queueChanged.notify_all();
+            Net::shutdownSocket(listenFd); // Wakes up the accept loop
+        } else if (!command.empty()) {
+            connection->reply("ERROR - unknown command '" + command + "'");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    --activeClients;
+    clientsDone.notify_all();
+}
+
+// Picks the next job: highest priority first, then jobs that reuse the previous job's
+// scene (batching), then arrival order. Blocks until a job is available or the server stops.
+bool RenderServer::popJob(QueuedJob& next) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queueChanged.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (stopping) {
+        return false;
+    }
+
+    size_t best = 0;
+    for (size_t k = 1; k < queue.size(); ++k) {
+        const QueuedJob& a = queue[k];
+        const QueuedJob& b = queue[best];
+        if (a.job.priority != b.job.priority) {
+            if (a.job.priority > b.job.priority) {
+                best = k;
+            }
+            continue;
+        }
+        bool aBatches = a.job.scene == lastScene;
+        bool bBatches = b.job.scene == lastScene;
+        if (aBatches != bBatches) {
+            if (aBatches) {
+                best = k;
+            }
+            continue;
+        }
+        if (a.sequence < b.sequence) {
+            best = k;
+        }
+    }
+    next = queue[best];
+    queue.erase(queue.begin() + best);
+    lastScene = next.job.scene;
+    return true;
+}
+
+void RenderServer::renderLoop() {
+    QueuedJob queued;
+    while (popJob(queued)) {
+        renderJob(queued);
+        queued = QueuedJob(); // Release the connection reference
+    }
+}
+
+void RenderServer::renderJob(const QueuedJob& queued) {
+    const RenderJob& job = queued.job;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    unsigned long missesBefore = cache.misses();
+    SceneCamera sceneCamera;
+    std::string error;
+    std::shared_ptr<const Kernels::PacketScene> packetScene;
+    std::shared_ptr<const Scene> scene = cache.acquire(job.scene, sceneCamera, packetScene, error);
+    if (!scene) {
+        queued.connection->reply("ERROR " + job.id + " " + error);
+        return;
+    }
+    bool cacheHit = cache.misses() == missesBefore;
+
+    Camera camera = job.makeCamera(sceneCamera);
+    Renderer renderer(scene.get(), &camera, *packetScene);
+    renderer.samplesPerPixel = job.samples;
+    std::vector<Vec3f> framebuffer(static_cast<size_t>(job.width) * job.height);
+    MemoryTracker::Account framebufferMemory(MemoryTracker::MEMORY_FRAMEBUFFERS);
+    framebufferMemory.set(MemoryTracker::capacityBytes(framebuffer));
+    renderer.renderFrame(framebuffer);
+    std::string image = Utils::encodePPM(job.width, job.height, framebuffer.data());
+    MemoryTracker::Account imageMemory(MemoryTracker::MEMORY_IMAGE_OUTPUT);
+    imageMemory.set(image.capacity());
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        ++renderedJobs;
+    }
+    fprintf(stdout, "Rendered %s: %s %dx%d, %d spp in %.1f ms (scene %s)\n", job.id.c_str(), job.scene.c_str(),
+            job.width, job.height, job.samples, elapsedMs, cacheHit ? "resident" : "loaded");
+
+    std::ostringstream header;
+    header << "IMAGE " << job.id << " " << job.width << " " << job.height << " " << image.size() << " " << elapsedMs;
+    queued.connection->reply(header.str(), image);
+}
+
+int runRenderClient(const std::string& address, const std::vector<std::string>& specs) {
+    int fd = Net::connectTo(address);
+    if (fd < 0) {
+        fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+        return -1;
+    }
+
+    // Send every job up front so the server can prioritize and batch them.
+    // Raw commands are sent once all images have arrived, so their replies cannot interleave.
+    std::map<std::string, std::string> outputs; // job id -> output file
+    std::vector<std::string> commands;
+    int pending = 0;
+    for (size_t k = 0; k < specs.size(); ++k) {
+        if (specs[k] == "STATS" || specs[k] == "SHUTDOWN") {
+            commands.push_back(specs[k]);
+            continue;
+        }
+
+        // Split off the client-side out=<file> key and make sure the job has an id.
+        std::istringstream tokens(specs[k]);
+        std::string token, request, id, output;
+        while (tokens >> token) {
+            if (token.compare(0, 4, "out=") == 0) {
+                output = token.substr(4);
+                continue;
+            }
+            if (token.compare(0, 3, "id=") == 0) {
+                id = token.substr(3);
+            }
+            request += " " + token;
+        }
+        if (id.empty()) {
+            id = "job" + std::to_string(k);
+            request += " id=" + id;
+        }
+        outputs[id] = output.empty() ? id + ".ppm" : output;
+        if (!Net::sendLine(fd, "RENDER" + request)) {
+            fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+            Net::closeSocket(fd);
+            return -1;
+        }
+        ++pending;
+    }
+
+    // Collect the results in the order the server finishes them.
+    int failures = 0;
+    bool connected = true;
+    while (pending > 0) {
+        std::string line;
+        if (!Net::recvLine(fd, line)) {
+            fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+            failures += pending;
+            connected = false;
+            break;
+        }
+        --pending;
+        std::istringstream reply(line);
+        std::string kind, id;
+        reply >> kind >> id;
+        if (kind != "IMAGE") {
+            fprintf(stderr, "%s\n", line.c_str());
+            ++failures;
+            continue;
+        }
+
+        int width = 0, height = 0;
+        size_t bytes = 0;
+        double elapsedMs = 0.0;
+        reply >> width >> height >> bytes >> elapsedMs;
+        std::string image(bytes, '\0');
+        if (!Net::recvAll(fd, &image[0], bytes)) {
+            fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+            failures += pending + 1;
+            connected = false;
+            break;
+        }
+        std::ofstream file(outputs[id].c_str(), std::ios::out | std::ios::binary);
+        file.write(image.data(), image.size());
+        file.close();
+        if (!file) {
+            fprintf(stderr, "Error: could not write %s for job %s\n", outputs[id].c_str(), id.c_str());
+            ++failures;
+            continue;
+        }
+        fprintf(stdout, "Job %s: %dx%d rendered in %.1f ms -> %s\n", id.c_str(), width, height, elapsedMs, outputs[id].c_str());
+    }
+
+    // The commands still go out after failed jobs; only a lost connection skips them.
+    for (size_t c = 0; c < commands.size(); ++c) {
+        if (!connected) {
+            fprintf(stderr, "Skipped %s: the connection to the server was lost\n", commands[c].c_str());
+            continue;
+        }
+        std::string reply;
+        if (!Net::sendLine(fd, commands[c]) || !Net::recvLine(fd, reply)) {
+            fprintf(stderr, "Error: %s\n", Net::lastError().c_str());
+            ++failures;
+            connected = false;
+            continue;
+        }
+        fprintf(stdout, "%s\n", reply.c_str());
+    }
+
+    Net::closeSocket(fd);
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,106 @@
+// src/RenderService.h
+#ifndef RENDER_SERVICE_H
+#define RENDER_SERVICE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "Vec3.h"
+#include "Camera.h"
+#include "SceneCache.h"
+
+// One image requested from the render service.
+// Jobs are written as space separated key=value pairs, e.g.
+//   id=a scene=scenes/demo.scene width=800 height=600 samples=4 priority=1 eye=0,2,-6 lookat=0,0,0 fov=60
+// Every key is optional; camera values default to the scene's camera line.
+struct RenderJob {
+    // Largest width or height parse() accepts by default: jobs rendered in memory hold the whole
+    // image. Callers that stream the image to disk pass a larger limit (see StreamingOutput.h).
+    static const int MAX_SIZE = 16384;
+
+    std::string id;
+    std::string scene = "default";
+    int width = 640;
+    int height = 480;
+    int samples = 1;
+    int priority = 0;       // Higher priorities are rendered first
+    bool hasEye = false;
+    bool hasLookAt = false;
+    bool hasFov = false;
+    Vec3f eye;
+    Vec3f lookAt;
+    float fov = 75.0f;
+
+    // Parses a job description; returns false and fills `error` on invalid input.
+    // Width and height may be up to `maxSize` pixels.
+    bool parse(const std::string& text, std::string& error, int maxSize = MAX_SIZE);
+
+    // Writes the job back as a description that parse() accepts.
+    std::string toString() const;
+
+    // Builds the job's camera, falling back to the scene's stored camera for unset values.
+    Camera makeCamera(const SceneCamera& sceneCamera) const;
+};
+
+// Long-running render daemon.
+// Clients connect over a Unix domain socket or localhost TCP (see Net.h) and send
+// line-based commands:
+//   RENDER <job>   queue a job; the reply is streamed back when it is finished:
+//                  "IMAGE <id> <width> <height> <bytes> <ms>\n" followed by a binary PPM,
+//                  or "ERROR <id> <message>\n"
+//   STATS          "STATS queued=<n> rendered=<n> cacheHits=<n> cacheMisses=<n> resident=<n>"
+//   SHUTDOWN       stop the server after the job being rendered
+// Queued jobs from all clients are rendered one at a time on all cores, highest priority first;
+// within a priority, jobs sharing the previous job's scene are batched ahead of the others.
+class RenderServer {
+public:
+    explicit RenderServer(const std::string& address);
+
+    // Listens and serves clients until SHUTDOWN. Returns the process exit code.
+    int run();
+
+private:
+    struct Connection;
+    struct QueuedJob {
+        RenderJob job;
+        std::shared_ptr<Connection> connection;
+        unsigned long sequence; // Arrival order, for FIFO within a priority
+    };
+
+    std::string address;
+    int listenFd;
+    SceneCache cache;
+
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+    std::vector<QueuedJob> queue;
+    unsigned long nextSequence;
+    unsigned long renderedJobs;
+    std::string lastScene;
+    std::atomic<bool> stopping;
+
+    // Client reader threads are detached; shutdown wakes them through their sockets
+    // and waits until activeClients drops to zero.
+    std::mutex clientsMutex;
+    std::condition_variable clientsDone;
+    std::vector<std::weak_ptr<Connection> > connections;
+    int activeClients;
+
+    void handleClient(std::shared_ptr<Connection> connection);
+    void renderLoop();
+    bool popJob(QueuedJob& next);
+    void renderJob(const QueuedJob& queued);
+};
+
+// Sends jobs to a running server and saves the returned images.
+// Each spec is a job description; an extra out=<file> key names the output file
+// (default "<id>.ppm"). The raw commands STATS and SHUTDOWN are forwarded as-is
+// after all images have been received, also when jobs failed (they are reported as
+// skipped if the connection was lost). Returns -1 if any job, output file or command failed.
+int runRenderClient(const std::string& address, const std::vector<std::string>& specs);
+
+#endif // RENDER_SERVICE_H
@@ -0,0 +1,302 @@
+// src/Renderer.cpp
+#include "Renderer.h"
+#include "Frustum.h"
+#include "Parallel.h"
+#include "Random.h"
+#include <algorithm> // For std::min
+#include <chrono>    // For the benchmark
+#include <cstdio>    // For printf
+
+Renderer::Renderer(const Scene* scene, const Camera* camera)
+    : scene(scene), camera(camera), samplesPerPixel(1), firstSample(0), shadows(true), frustumCulling(true), genericKernel(false),
+      features(nullptr), shadowCache(nullptr),
+      snapshot(*scene), packetScene(&snapshot), tileCount(0), tileObjects(0), tileCandidates(0) {}
+
+Renderer::Renderer(const Scene* scene, const Camera* camera, const Kernels::PacketScene& packetScene)
+    : scene(scene), camera(camera), samplesPerPixel(1), firstSample(0), shadows(true), frustumCulling(true), genericKernel(false),
+      features(nullptr), shadowCache(nullptr),
+      packetScene(&packetScene), tileCount(0), tileObjects(0), tileCandidates(0) {}
+
+namespace {
+    // Renders a tile with a render kernel of the active SIMD kernels. Produces the same
+    // pixels as the per-pixel path: the rays and all arithmetic are identical.
+    void renderTilePackets(const Renderer& renderer, Kernels::RenderKernel render, const Kernels::PacketScene& packetScene,
+                           const Kernels::SceneView& sceneView, const Tile& tile, Vec3f* out, int stride) {
+        const int samples = std::max(renderer.samplesPerPixel, 1);
+
+        // Primary rays of the whole tile, `samples` consecutive rays per pixel.
+        RayBatch batch;
+        renderer.camera->generateRays(tile, samples, batch, renderer.firstSample);
+        const Kernels::RayArrays rays = { batch.originX.data(), batch.originY.data(), batch.originZ.data(),
+                                          batch.directionX.data(), batch.directionY.data(), batch.directionZ.data() };
+        std::vector<float> red(batch.size()), green(batch.size()), blue(batch.size());
+
+        // Primary hits are only kept when the caller records denoiser features, or for the shadow
+        // cache (the kernel then casts no shadow rays: see below).
+        const bool cachedShadows = renderer.shadows && renderer.shadowCache;
+        std::vector<float> distance, normalX, normalY, normalZ;
+        std::vector<int> primitive;
+        Kernels::HitBuffers hits = { nullptr, nullptr, nullptr, nullptr, nullptr };
+        if (renderer.features || cachedShadows) {
+            for (std::vector<float>* v : { &distance, &normalX, &normalY, &normalZ }) {
+                v->resize(batch.size());
+            }
+            primitive.resize(batch.size());
+            hits.distance = distance.data();
+            hits.normalX = normalX.data();
+            hits.normalY = normalY.data();
+            hits.normalZ = normalZ.data();
+            hits.primitive = primitive.data();
+        }
+        render(sceneView, rays, batch.size(), red.data(), green.data(), blue.data(), hits.distance ? &hits : nullptr);
+
+        if (cachedShadows) {
+            // Shadow stage through the cache: the visibility of every hit, answered by the cache where
+            // it can and traced otherwise, then Lambert shading with it (as the render kernel would).
+            const int count = batch.size();
+            std::vector<float> pointX(count), pointY(count), pointZ(count), albedoR(count), albedoG(count), albedoB(count);
+            for (int k = 0; k < count; ++k) {
+                const int p = primitive[k];
+                if (p < 0) {
+                    continue;
+                }
+                const Vec3f point = Vec3f(rays.originX[k], rays.originY[k], rays.originZ[k]) +
+                                    Vec3f(rays.directionX[k], rays.directionY[k], rays.directionZ[k]) * distance[k];
+                pointX[k] = point.x;
+                pointY[k] = point.y;
+                pointZ[k] = point.z;
+                const bool plane = p >= sceneView.sphereCount;
+                albedoR[k] = plane ? sceneView.planeR[p - sceneView.sphereCount] : sceneView.sphereR[p];
+                albedoG[k] = plane ? sceneView.planeG[p - sceneView.sphereCount] : sceneView.sphereG[p];
+                albedoB[k] = plane ? sceneView.planeB[p - sceneView.sphereCount] : sceneView.sphereB[p];
+            }
+            const ShadowCache::TileHits tileHits = { tile, renderer.camera->imageWidth, samples, count,
+                                                     pointX.data(), pointY.data(), pointZ.data(),
+                                                     normalX.data(), normalY.data(), normalZ.data(), primitive.data() };
+            std::vector<unsigned char> visibility(static_cast<size_t>(count) * sceneView.lightCount);
+            renderer.shadowCache->resolve(sceneView, tileHits, visibility.data());
+            const Kernels::ShadeInputs inputs = { pointX.data(), pointY.data(), pointZ.data(), normalX.data(), normalY.data(),
+                                                  normalZ.data(), albedoR.data(), albedoG.data(), albedoB.data(),
+                                                  visibility.data() };
+            Kernels::active().shade(sceneView, inputs, count, red.data(), green.data(), blue.data());
+            for (int k = 0; k < count; ++k) {
+                if (primitive[k] < 0) {
+                    red[k] = sceneView.background.x;
+                    green[k] = sceneView.background.y;
+                    blue[k] = sceneView.background.z;
+                }
+            }
+        }
+
+        // Average the samples of each pixel.
+        int k = 0;
+        for (int j = 0; j < tile.height(); ++j) {
+            Vec3f* pixels = out + j * stride;
+            for (int i = 0; i < tile.width(); ++i) {
+                if (renderer.features) {
+                    // Features of the pixel's first sample, as recorded by the per-pixel path.
+                    const int object = primitive[k] < 0 ? -1 : packetScene.objectIndex(primitive[k]);
+                    renderer.features->set(tile.x0 + i, tile.y0 + j, Vec3f(normalX[k], normalY[k], normalZ[k]), distance[k],
+                                           object);
+                }
+                Vec3f sum(0.0f);
+                for (int s = 0; s < samples; ++s, ++k) {
+                    sum += Vec3f(red[k], green[k], blue[k]);
+                }
+                pixels[i] = samples == 1 ? sum : sum / static_cast<float>(samples);
+            }
+        }
+    }
+}
+
+Vec3f Renderer::shadeRay(const Ray& ray, IntersectionInfo& info, Object*& hitObject,
+                          const std::vector<int>* candidates, int& objectIndex) const {
+    // Trace the primary ray into the scene (as Scene::trace, keeping the object's index);
+    // shade the hit or fall back to the background.
+    float distance;
+    objectIndex = scene->closestHit(ray, distance, candidates);
+    if (objectIndex < 0) {
+        hitObject = nullptr;
+        return scene->backgroundColor;
+    }
+    hitObject = scene->objects[objectIndex];
+    hitObject->hitAttributes(ray, distance, info);
+    return shadows ? scene->shade(info, hitObject) : scene->shade(info, hitObject, nullptr);
+}
+
+Vec3f Renderer::renderPixel(int i, int j, IntersectionInfo& info, Object*& hitObject) const {
+    // Compute the primary ray that originates from the camera's eye position
+    // and passes through the center of the current pixel on the image plane.
+    int objectIndex;
+    return shadeRay(camera->computePrimaryRay(i, j), info, hitObject, nullptr, objectIndex);
+}
+
+Vec3f Renderer::renderPixel(int i, int j) const {
+    return renderPixel(i, j, nullptr);
+}
+
+Vec3f Renderer::renderPixel(int i, int j, const std::vector<int>* candidates) const {
+    IntersectionInfo info;
+    Object* hitObject = nullptr;
+    int objectIndex;
+    // Unsigned arithmetic: streamed images can have more pixels than an int holds (the index wraps).
+    const uint32_t pixelIndex = static_cast<uint32_t>(j) * static_cast<uint32_t>(camera->imageWidth) + static_cast<uint32_t>(i);
+    if (samplesPerPixel <= 1 && firstSample == 0) {
+        Vec3f color = shadeRay(camera->computePrimaryRay(i, j), info, hitObject, candidates, objectIndex);
+        if (features) {
+            features->set(i, j, hitObject ? info.normal : Vec3f(0.0f), hitObject ? info.distance : 0.0f, objectIndex);
+        }
+        return color;
+    }
+
+    // Supersampling: average rays through random positions inside the pixel.
+    const int samples = std::max(samplesPerPixel, 1);
+    Vec3f sum(0.0f);
+    for (int s = firstSample; s < firstSample + samples; ++s) {
+        float px = i + Random::uniform(pixelIndex, s, 0);
+        float py = j + Random::uniform(pixelIndex, s, 1);
+        sum += shadeRay(camera->computePrimaryRay(px, py), info, hitObject, candidates, objectIndex);
+        if (s == firstSample && features) {
+            features->set(i, j, hitObject ? info.normal : Vec3f(0.0f), hitObject ? info.distance : 0.0f, objectIndex);
+        }
+    }
+    return samples == 1 ? sum : sum / static_cast<float>(samples);
+}
+
+void Renderer::renderTile(const Tile& tile, Vec3f* out, int stride) const {
+    // Objects are culled once against the tile's frustum, before any of its rays are traced.
+    // A culled object cannot be the closest hit of any of the tile's primary rays, so the
+    // candidate lists (kept in increasing index order) give exactly the same pixels.
+    const Frustum frustum(*camera, tile);
+
+    // Scenes made only of spheres and planes go through a SIMD render kernel
+    // specialized for their light count, planes and shadow setting.
+    if (packetScene->supported) {
+        Kernels::SceneView sceneView = packetScene->view();
+        std::vector<int> spheres, planes;
+        if (frustumCulling) {
+            for (int s = 0; s < sceneView.sphereCount; ++s) {
+                if (!frustum.excludesSphere(Vec3f(sceneView.sphereX[s], sceneView.sphereY[s], sceneView.sphereZ[s]),
+                                            sceneView.sphereRadius[s])) {
+                    spheres.push_back(s);
+                }
+            }
+            for (int p = 0; p < sceneView.planeCount; ++p) {
+                if (!frustum.excludesPlane(Vec3f(sceneView.planePointX[p], sceneView.planePointY[p], sceneView.planePointZ[p]),
+                                           Vec3f(sceneView.planeNormalX[p], sceneView.planeNormalY[p], sceneView.planeNormalZ[p]))) {
+                    planes.push_back(p);
+                }
+            }
+            sceneView.primarySpheres = spheres.data();
+            sceneView.primarySphereCount = static_cast<int>(spheres.size());
+            sceneView.primaryPlanes = planes.data();
+            sceneView.primaryPlaneCount = static_cast<int>(planes.size());
+        }
+        const int objects = sceneView.sphereCount + sceneView.planeCount;
+        ++tileCount;
+        tileObjects += objects;
+        tileCandidates += frustumCulling ? static_cast<int>(spheres.size() + planes.size()) : objects;
+        // The kernel is still selected by the whole scene: shadow rays need every plane.
+        // With a shadow cache the kernel only finds the hits; the shadow stage follows in renderTilePackets.
+        renderTilePackets(*this, Kernels::selectRender(Kernels::active(), sceneView, shadows && !shadowCache, genericKernel),
+                          *packetScene,
+                          sceneView, tile, out, stride);
+        return;
+    }
+
+    std::vector<int> candidates;
+    if (frustumCulling) {
+        for (size_t k = 0; k < scene->objects.size(); ++k) {
+            if (!scene->objects[k]->outsideFrustum(frustum)) {
+                candidates.push_back(static_cast<int>(k));
+            }
+        }
+    }
+    ++tileCount;
+    tileObjects += static_cast<long long>(scene->objects.size());
+    tileCandidates += static_cast<long long>(frustumCulling ? candidates.size() : scene->objects.size());
+
+    for (int j = tile.y0; j < tile.y1; ++j) {
+        Vec3f* row = out + (j - tile.y0) * stride;
+        for (int i = tile.x0; i < tile.x1; ++i) {
+            row[i - tile.x0] = renderPixel(i, j, frustumCulling ? &candidates : nullptr);
+        }
+    }
+}
+
+void Renderer::renderFrame(std::vector<Vec3f>& framebuffer, int tileSize) const {
+    const int width = camera->imageWidth;
+    const int height = camera->imageHeight;
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+
+    Parallel::forEach(tilesX * tilesY, [&](int index) {
+        Tile tile;
+        tile.x0 = (index % tilesX) * tileSize;
+        tile.y0 = (index / tilesX) * tileSize;
+        tile.x1 = std::min(tile.x0 + tileSize, width);
+        tile.y1 = std::min(tile.y0 + tileSize, height);
+        renderTile(tile, &framebuffer[tile.y0 * width + tile.x0], width);
+    });
+}
+
+Renderer::CullingStats Renderer::cullingStats() const {
+    CullingStats stats;
+    stats.tiles = tileCount.load();
+    stats.objects = tileObjects.load();
+    stats.candidates = tileCandidates.load();
+    return stats;
+}
+
+int runRenderKernelBenchmark(const Scene& scene, const Camera& camera, int frames) {
+    typedef std::chrono::steady_clock Clock;
+    const int tileSize = 32; // As renderFrame
+    const int width = camera.imageWidth;
+    const int height = camera.imageHeight;
+    const Kernels::PacketScene packetScene(scene);
+    if (!packetScene.supported) {
+        fprintf(stderr, "Error: the scene has objects the SIMD kernels do not render\n");
+        return -1;
+    }
+    const Kernels::SceneView sceneView = packetScene.view();
+    Renderer renderer(&scene, &camera, packetScene);
+    printf("Render kernels: %dx%d, %d frames, one thread, %s kernels, %d lights, %d spheres, %d planes\n", width,
+           height, frames, Kernels::active().name, sceneView.lightCount, sceneView.sphereCount, sceneView.planeCount);
+
+    // Renders `frames` images tile by tile into `image` and returns the milliseconds per frame.
+    auto measure = [&](std::vector<Vec3f>& image) {
+        image.assign(static_cast<size_t>(width) * height, Vec3f(0.0f));
+        Clock::time_point start = Clock::now();
+        for (int f = 0; f < frames; ++f) {
+            for (int y = 0; y < height; y += tileSize) {
+                for (int x = 0; x < width; x += tileSize) {
+                    Tile tile = { x, y, std::min(x + tileSize, width), std::min(y + tileSize, height) };
+                    renderer.renderTile(tile, &image[static_cast<size_t>(y) * width + x], width);
+                }
+            }
+        }
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+    };
+
+    long long mismatches = 0;
+    std::vector<Vec3f> specialized, generic;
+    for (int shadows = 1; shadows >= 0; --shadows) {
+        renderer.shadows = shadows != 0;
+        renderer.genericKernel = false;
+        const double specializedMs = measure(specialized);
+        renderer.genericKernel = true;
+        const double genericMs = measure(generic);
+        printf("  shadows %-3s  specialized %8.2f ms  generic %8.2f ms  (%.2fx)\n", shadows ? "on" : "off",
+               specializedMs, genericMs, genericMs / specializedMs);
+        for (size_t k = 0; k < specialized.size(); ++k) {
+            mismatches += specialized[k].x != generic[k].x || specialized[k].y != generic[k].y ||
+                          specialized[k].z != generic[k].z;
+        }
+    }
+    if (mismatches > 0) {
+        fprintf(stderr, "Error: %lld pixels of the specialized and generic kernels differ\n", mismatches);
+        return -1;
+    }
+    printf("Specialized and generic kernels render the same pixels\n");
+    return 0;
+}
@@ -0,0 +1,102 @@
+// src/Renderer.h
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <atomic>
+#include <vector>
+
+#include "Vec3.h"
+#include "Object.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Tile.h"
+#include "Kernels.h"
+#include "Denoiser.h"
+#include "ShadowCache.h"
+
+// Turns a scene and a camera into pixels.
+// The renderer holds no image state of its own: callers pass the memory the pixels
+// are written to, so the same code serves the interactive window, headless output
+// and partial (tiled) updates.
+class Renderer {
+public:
+    const Scene* scene;   // Scene being rendered (not owned)
+    const Camera* camera; // Camera generating the primary rays (not owned)
+    int samplesPerPixel;  // Jittered primary rays averaged per pixel (1 = pixel center only)
+    // Number of the first of those samples, which selects their jitter (Random::uniform). Passes of
+    // a progressive render use consecutive ranges; anything but sample 0 alone is jittered.
+    int firstSample;
+    bool shadows;         // Cast shadow rays (false = every light reaches every surface)
+    bool frustumCulling;  // renderTile() tests primary rays only against the objects inside the tile's frustum
+    // renderTile() uses the render kernel that handles every scene instead of the one specialized for
+    // this scene's light count and planes (Kernels::selectRender). Same pixels; for comparisons.
+    bool genericKernel;
+    // If set, renderTile() and renderPixel(i, j) also record the primary hit of each pixel's first
+    // sample here (sized to the camera resolution), for Denoiser. Not owned.
+    DenoiseFeatures* features;
+    // If set (and shadows are on), renderTile() resolves shadow visibility through this cache
+    // instead of casting every shadow ray (see ShadowCache.h). The caller brackets the tiles of
+    // each frame with its beginFrame() and endFrame(). Only scenes the SIMD kernels support use
+    // it; the per-pixel path casts every shadow ray. Not owned.
+    ShadowCache* shadowCache;
+
+    // Objects the primary rays of the tiles rendered so far were tested against, summed over
+    // the tiles, without and with frustum culling.
+    struct CullingStats {
+        long long tiles;
+        long long objects;
+        long long candidates;
+
+        // Fraction of the object tests that culling removed (0 if nothing was rendered).
+        double culledFraction() const { return objects > 0 ? 1.0 - static_cast<double>(candidates) / objects : 0.0; }
+    };
+
+    // Takes a snapshot of the scene for the SIMD kernels: create a renderer per frame,
+    // after the scene has been edited.
+    Renderer(const Scene* scene, const Camera* camera);
+
+    // Renders from a resident copy the caller keeps up to date with PacketScene::update(),
+    // e.g. across scene reloads, instead of taking a snapshot (`packetScene` is not owned).
+    Renderer(const Scene* scene, const Camera* camera, const Kernels::PacketScene& packetScene);
+
+    // Traces the primary ray through pixel (i, j) and returns its shaded color.
+    // info/hitObject receive the primary hit (hitObject == nullptr for background pixels).
+    Vec3f renderPixel(int i, int j, IntersectionInfo& info, Object*& hitObject) const;
+
+    // Returns the color of pixel (i, j), averaging samplesPerPixel jittered rays.
+    Vec3f renderPixel(int i, int j) const;
+
+    // Renders every pixel of `tile`. Row r of the tile is written to out + r * stride.
+    // Shadow rays always test every object; only primary rays are culled.
+    void renderTile(const Tile& tile, Vec3f* out, int stride) const;
+
+    // Renders the whole image into `framebuffer` (camera resolution), spreading tiles over all cores.
+    void renderFrame(std::vector<Vec3f>& framebuffer, int tileSize = 32) const;
+
+    // Culling statistics of the renderTile()/renderFrame() calls so far (safe to call while tiles render).
+    CullingStats cullingStats() const;
+
+private:
+    // Color of a primary ray; `candidates` restricts the objects it is tested against (see Scene::trace).
+    // objectIndex receives the index of the hit object in Scene::objects (-1 on a miss).
+    Vec3f shadeRay(const Ray& ray, IntersectionInfo& info, Object*& hitObject, const std::vector<int>* candidates,
+                   int& objectIndex) const;
+    Vec3f renderPixel(int i, int j, const std::vector<int>* candidates) const;
+
+    Kernels::PacketScene snapshot;           // Copy taken by the first constructor
+    const Kernels::PacketScene* packetScene; // Spheres, planes and lights laid out for the SIMD kernels
+    mutable std::atomic<long long> tileCount;      // CullingStats::tiles, updated by concurrent tiles
+    mutable std::atomic<long long> tileObjects;    // CullingStats::objects
+    mutable std::atomic<long long> tileCandidates; // CullingStats::candidates
+
+    // packetScene may point into this object
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+};
+
+// Measures the SIMD render kernel specialized for `scene` against the generic one, with and
+// without shadows, over `frames` images of `camera` on one thread, and prints the results.
+// Returns 0, or -1 if the images differ or the kernels do not support the scene.
+int runRenderKernelBenchmark(const Scene& scene, const Camera& camera, int frames);
+
+#endif // RENDERER_H
@@ -2,6 +2,7 @@
 #include "Scene.h"    // Include the header for the Scene class
 #include <cmath>      // Required for std::sqrt (though not directly used in Scene.cpp, it's good practice for math ops)
 #include <limits>     // Required for std::numeric_limits
+#include <algorithm>  // Required for std::max
 
 // Destructor: Iterates through the objects vector and deletes each dynamically allocated object.
 // This is crucial to prevent memory leaks since objects are added as raw pointers.
@@ -14,41 +15,69 @@ Scene::~Scene() {
 // Adds an object to the scene (takes ownership of the pointer).
 void Scene::addObject(Object* obj) {
     objects.push_back(obj);
+    objectBytes += obj->memorySize();
+    updateMemoryAccounts();
+}
+
+// Deletes an object, filling its slot with the last object (constant time, one index changes).
+void Scene::removeObject(int index) {
+    objectBytes -= objects[index]->memorySize();
+    delete objects[index];
+    objects[index] = objects.back();
+    objects.pop_back();
+    updateMemoryAccounts();
 }
 
 // Adds a light to the scene.
 void Scene::addLight(const Light& light) {
     lights.push_back(light);
+    updateMemoryAccounts();
 }
 
-// Traces a ray into the scene to find the closest intersection.
-// Iterates through all objects and finds the one closest to the ray origin.
-bool Scene::trace(const Ray& ray, IntersectionInfo& info, Object*& hitObject) const {
+// Geometry is the objects plus the pointer array; lights are stored by value.
+void Scene::updateMemoryAccounts() {
+    geometryMemory.set(objectBytes + MemoryTracker::capacityBytes(objects));
+    lightMemory.set(MemoryTracker::capacityBytes(lights));
+}
+
+// Finds the closest object along a ray using only the distance test of each object.
+int Scene::closestHit(const Ray& ray, float& distance, const std::vector<int>* candidates) const {
     // Initialize minDist to the maximum possible float value.
     float minDist = std::numeric_limits<float>::max();
-    hitObject = nullptr; // No object hit initially
-
-    IntersectionInfo currentInfo; // Temporary struct to store intersection info for the current object
+    int closest = -1; // No object hit initially
 
-    // Loop over all objects in the scene to check for intersections.
-    for (Object* obj : objects) {
-        if (obj->intersect(ray, currentInfo)) { // If the ray intersects the current object...
-            // Check if this intersection is closer than any previously found intersection.
-            if (currentInfo.distance < minDist) {
-                minDist = currentInfo.distance; // Update the minimum distance
-                info = currentInfo;             // Store the detailed information of this closest intersection
-                hitObject = obj;                // Store the pointer to the object that was hit
-            }
+    // Loop over all objects in the scene (or the candidates, in increasing index order so that
+    // ties resolve the same way), keeping the nearest intersection.
+    float currentDist;
+    const size_t count = candidates ? candidates->size() : objects.size();
+    for (size_t c = 0; c < count; ++c) {
+        const int k = candidates ? (*candidates)[c] : static_cast<int>(c);
+        if (objects[k]->hitDistance(ray, currentDist) && currentDist < minDist) {
+            minDist = currentDist;
+            closest = k;
         }
     }
+    distance = minDist;
+    return closest;
+}
 
-    // Return true if an object was hit (i.e., hitObject is no longer nullptr).
-    return hitObject != nullptr;
+// Traces a ray into the scene to find the closest intersection.
+// Surface attributes are computed only for the object that was hit.
+bool Scene::trace(const Ray& ray, IntersectionInfo& info, Object*& hitObject, const std::vector<int>* candidates) const {
+    float distance;
+    const int closest = closestHit(ray, distance, candidates);
+    if (closest < 0) {
+        hitObject = nullptr;
+        return false;
+    }
+    hitObject = objects[closest];
+    hitObject->hitAttributes(ray, distance, info);
+    return true;
 }
 
 // Checks if a point is in shadow from a specific light source.
 // This is done by casting a shadow ray from the intersection point towards the light.
-bool Scene::isInShadow(const Vec3f& point, const Light& light) const {
+bool Scene::isInShadow(const Vec3f& point, const Light& light, long long* tests) const {
     // Calculate the direction from the intersection point to the light source.
     Vec3f lightDir = (light.position - point).normalize();
 
@@ -60,16 +89,66 @@ bool Scene::isInShadow(const Vec3f& point, const Light& light) const {
     // Calculate the actual distance from the intersection point to the light source.
     float distanceToLight = (light.position - point).length();
 
-    // Iterate through all objects in the scene to check if any object blocks the shadow ray.
-    IntersectionInfo shadowInfo;
-    for (Object* obj : objects) {
-        if (obj->intersect(shadowRay, shadowInfo)) {
-            // If the shadow ray intersects an object AND that object is closer than the light source,
-            // then the point is in shadow.
-            if (shadowInfo.distance < distanceToLight) {
-                return true; // Point is in shadow
+    // The point is in shadow if any object blocks the shadow ray before it reaches the light.
+    return occluded(shadowRay, distanceToLight, tests);
+}
+
+// Checks whether any object intersects the ray closer than maxDistance.
+// Only distances are needed here, so no hit attributes are computed.
+// The test count is derived from where the loop stopped, so counting costs nothing per object.
+bool Scene::occluded(const Ray& ray, float maxDistance, long long* tests) const {
+    float distance;
+    for (size_t k = 0; k < objects.size(); ++k) {
+        if (objects[k]->hitDistance(ray, distance) && distance < maxDistance) {
+            if (tests) {
+                *tests += static_cast<long long>(k) + 1;
             }
+            return true; // Stop at the first blocker
+        }
+    }
+    if (tests) {
+        *tests += static_cast<long long>(objects.size());
+    }
+    return false;
+}
+
+// Computes the color of a surface hit by summing diffuse contributions from all unshadowed lights.
+Vec3f Scene::shade(const IntersectionInfo& info, const Object* hitObject) const {
+    Vec3f finalColor = Vec3f(0.0f); // Start with black (no light contribution yet)
+
+    // Iterate through each light source in the scene to calculate its contribution.
+    for (const auto& light : lights) {
+        // Check if the intersection point is in shadow relative to the current light.
+        if (!isInShadow(info.point, light)) {
+            // If not in shadow, calculate the light direction vector
+            // from the hit point to the light source.
+            Vec3f lightDir = (light.position - info.point).normalize();
+
+            // Calculate the diffuse component using Lambert's cosine law:
+            // max(0, N . L), where N is the surface normal and L is the light direction.
+            // This ensures that light only affects surfaces facing it.
+            float diffuseFactor = std::max(0.0f, info.normal.dot(lightDir));
+
+            // Add the contribution of this light to the final color.
+            // The object's color is multiplied by the light's color (intensity)
+            // and the diffuse factor.
+            finalColor += hitObject->color * light.color * diffuseFactor;
+        }
+    }
+    return finalColor;
+}
+
+// Computes the diffuse color of a surface hit using precomputed per-light visibility.
+Vec3f Scene::shade(const IntersectionInfo& info, const Object* hitObject, const float* visibility) const {
+    Vec3f finalColor = Vec3f(0.0f);
+    for (size_t l = 0; l < lights.size(); ++l) {
+        const float visible = visibility ? visibility[l] : 1.0f;
+        if (visible <= 0.0f) {
+            continue; // Fully shadowed: skip the direction computation
         }
+        Vec3f lightDir = (lights[l].position - info.point).normalize();
+        float diffuseFactor = std::max(0.0f, info.normal.dot(lightDir));
+        finalColor += hitObject->color * lights[l].color * (diffuseFactor * visible);
     }
-    return false; // Point is not in shadow
+    return finalColor;
 }
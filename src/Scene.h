@@ -9,6 +9,7 @@
 #include "Light.h"
 #include "Ray.h"
 #include "Vec3.h"
+#include "MemoryTracker.h"
 
 // Represents the 3D scene, containing objects and lights.
 // Manages finding intersections and basic shading.
@@ -19,7 +20,9 @@ public:
     Vec3f backgroundColor;        // Color for rays that hit nothing
 
     // Constructor
-    Scene(const Vec3f& bgColor = Vec3f(0.2f, 0.2f, 0.2f)) : backgroundColor(bgColor) {}
+    Scene(const Vec3f& bgColor = Vec3f(0.2f, 0.2f, 0.2f))
+        : backgroundColor(bgColor), objectBytes(0),
+          geometryMemory(MemoryTracker::MEMORY_SCENE_GEOMETRY), lightMemory(MemoryTracker::MEMORY_LIGHTS) {}
 
     // Destructor: Cleans up dynamically allocated objects
     ~Scene();
@@ -27,16 +30,48 @@ public:
     // Adds an object to the scene (takes ownership of the pointer)
     void addObject(Object* obj);
 
+    // Deletes objects[index]. The last object moves into its slot, so no other index changes.
+    void removeObject(int index);
+
     // Adds a light to the scene
     void addLight(const Light& light);
 
+    // Reports the scene's memory to MemoryTracker. The add/remove methods do this themselves;
+    // call it after editing `lights` directly.
+    void updateMemoryAccounts();
+
+    // Closest object along a ray: returns its index in `objects` and its distance,
+    // or -1 if nothing is hit. Only the objects' distance tests run.
+    // If `candidates` is given, only those object indices are tested (e.g. after frustum culling).
+    int closestHit(const Ray& ray, float& distance, const std::vector<int>* candidates = nullptr) const;
+
     // Traces a ray into the scene to find the closest intersection.
     // Returns true if an intersection is found, and fills the info struct.
-    bool trace(const Ray& ray, IntersectionInfo& info, Object*& hitObject) const;
+    // `candidates` restricts the objects tested as in closestHit().
+    bool trace(const Ray& ray, IntersectionInfo& info, Object*& hitObject,
+               const std::vector<int>* candidates = nullptr) const;
+
+    // True if any object lies along the ray closer than maxDistance (distance tests only).
+    // If `tests` is given, the number of objects tested is added to it (for CostHeatmap).
+    bool occluded(const Ray& ray, float maxDistance, long long* tests = nullptr) const;
 
     // Checks if a point is in shadow from a specific light source.
     // Returns true if the point is in shadow.
-    bool isInShadow(const Vec3f& point, const Light& light) const;
+    // `tests` counts intersection tests as in occluded().
+    bool isInShadow(const Vec3f& point, const Light& light, long long* tests = nullptr) const;
+
+    // Computes the Lambertian color of a surface hit, summing the contribution
+    // of every light that is not shadowed at the hit point.
+    Vec3f shade(const IntersectionInfo& info, const Object* hitObject) const;
+
+    // Same as shade(), but with the shadow term supplied by the caller:
+    // visibility[l] in [0, 1] scales the contribution of lights[l]; nullptr means every light is visible.
+    Vec3f shade(const IntersectionInfo& info, const Object* hitObject, const float* visibility) const;
+
+private:
+    size_t objectBytes;                     // Sum of the objects' memorySize()
+    MemoryTracker::Account geometryMemory;  // Objects and the pointer array
+    MemoryTracker::Account lightMemory;
 };
 
 #endif // SCENE_H
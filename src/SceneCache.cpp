@@ -0,0 +1,81 @@
+// src/SceneCache.cpp
+#include "SceneCache.h"
+#include <sys/stat.h> // For stat (file modification time)
+
+namespace {
+    // Modification time of `path`, or 0 for the built-in scene / missing files.
+    std::time_t modificationTime(const std::string& path) {
+        struct stat info;
+        if (path == SceneLoader::DEFAULT_SCENE || stat(path.c_str(), &info) != 0) {
+            return 0;
+        }
+        return info.st_mtime;
+    }
+}
+
+SceneCache::SceneCache(size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1), useCounter(0), hitCount(0), missCount(0) {}
+
+std::shared_ptr<const Scene> SceneCache::acquire(const std::string& path, SceneCamera& camera, std::string& error) {
+    std::shared_ptr<const Kernels::PacketScene> packetScene;
+    return acquire(path, camera, packetScene, error);
+}
+
+std::shared_ptr<const Scene> SceneCache::acquire(const std::string& path, SceneCamera& camera,
+                                                 std::shared_ptr<const Kernels::PacketScene>& packetScene, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::time_t modified = modificationTime(path);
+
+    std::map<std::string, Entry>::iterator found = entries.find(path);
+    if (found != entries.end() && found->second.modified == modified) {
+        ++hitCount;
+        found->second.lastUse = ++useCounter;
+        camera = found->second.camera;
+        packetScene = found->second.packetScene;
+        return found->second.scene;
+    }
+
+    // Miss (or the file changed on disk): parse it again.
+    ++missCount;
+    std::shared_ptr<Scene> scene(new Scene());
+    SceneCamera loadedCamera;
+    if (!SceneLoader::load(path, *scene, loadedCamera, error)) {
+        return std::shared_ptr<const Scene>();
+    }
+
+    // Make room by evicting the least recently used scene.
+    if (found == entries.end() && entries.size() >= capacity) {
+        std::map<std::string, Entry>::iterator oldest = entries.begin();
+        for (std::map<std::string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        entries.erase(oldest);
+    }
+
+    Entry& entry = entries[path];
+    entry.scene = scene;
+    entry.packetScene = std::make_shared<Kernels::PacketScene>(*scene);
+    entry.camera = loadedCamera;
+    entry.modified = modified;
+    entry.lastUse = ++useCounter;
+    camera = loadedCamera;
+    packetScene = entry.packetScene;
+    return entry.scene;
+}
+
+unsigned long SceneCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+unsigned long SceneCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
+
+size_t SceneCache::residentScenes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,54 @@
+// src/SceneCache.h
+#ifndef SCENE_CACHE_H
+#define SCENE_CACHE_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ctime>
+
+#include "Scene.h"
+#include "SceneLoader.h"
+#include "Kernels.h"
+
+// Keeps parsed scenes resident between render jobs, together with the SIMD kernels' copy of
+// each (Kernels::PacketScene), so a job starts rendering without copying the scene.
+// Scenes are keyed by their file path and reloaded only if the file's modification time
+// changed. The least recently used scene is evicted once `capacity` scenes are resident;
+// jobs still rendering an evicted scene keep it alive through their shared_ptr.
+class SceneCache {
+public:
+    explicit SceneCache(size_t capacity = 8);
+
+    // Returns the scene for `path` (loading it on a miss) and its stored camera.
+    // Returns nullptr and fills `error` if the scene cannot be loaded.
+    std::shared_ptr<const Scene> acquire(const std::string& path, SceneCamera& camera, std::string& error);
+
+    // Same, also returning the kernels' copy of the scene, for Renderer(scene, camera, *packetScene).
+    std::shared_ptr<const Scene> acquire(const std::string& path, SceneCamera& camera,
+                                         std::shared_ptr<const Kernels::PacketScene>& packetScene, std::string& error);
+
+    // Number of acquire() calls served from memory / from disk.
+    unsigned long hits() const;
+    unsigned long misses() const;
+    size_t residentScenes() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<const Scene> scene;
+        std::shared_ptr<const Kernels::PacketScene> packetScene;
+        SceneCamera camera;
+        std::time_t modified;    // File modification time when loaded
+        unsigned long lastUse;   // For LRU eviction
+    };
+
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::map<std::string, Entry> entries;
+    unsigned long useCounter;
+    unsigned long hitCount;
+    unsigned long missCount;
+};
+
+#endif // SCENE_CACHE_H
@@ -0,0 +1,359 @@
+// src/SceneDiff.cpp
+#include "SceneDiff.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Kernels.h"
+#include "Random.h"
+#include <algorithm>     // For std::sort, std::remove
+#include <cstring>       // For std::memcmp, std::memcpy, std::memset
+#include <deque>
+#include <functional>    // For std::greater
+#include <typeindex>     // For std::type_index
+#include <typeinfo>      // For typeid
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>       // For uint32_t
+#include <cstdio>        // For printf
+#include <utility>       // For std::swap
+
+namespace {
+    // Type, geometry and color of an object, so identical objects can be found by comparing
+    // or hashing bytes. Objects of types it does not know get type 0 and never match.
+    struct Key {
+        char type;
+        float values[9];
+
+        bool operator==(const Key& other) const { return std::memcmp(this, &other, sizeof(Key)) == 0; }
+    };
+
+    // Hash of a key's bytes (FNV-1a over 32-bit words).
+    uint32_t hashKey(const Key& key) {
+        uint32_t words[sizeof(Key) / 4];
+        std::memcpy(words, &key, sizeof(words));
+        uint32_t hash = 2166136261u;
+        for (uint32_t word : words) {
+            hash = (hash ^ word) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    void put(float* values, const Vec3f& v) {
+        values[0] = v.x;
+        values[1] = v.y;
+        values[2] = v.z;
+    }
+
+    Key makeKey(const Object* obj) {
+        Key key;
+        std::memset(&key, 0, sizeof(Key)); // Padding bytes take part in comparisons
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(obj)) {
+            key.type = 'S';
+            put(key.values, sphere->center);
+            key.values[3] = sphere->radius;
+            put(key.values + 4, obj->color);
+        } else if (const Plane* plane = dynamic_cast<const Plane*>(obj)) {
+            key.type = 'P';
+            put(key.values, plane->point);
+            put(key.values + 3, plane->normal);
+            put(key.values + 6, obj->color);
+        }
+        return key;
+    }
+
+    // Copies the geometry and color of `source` into `target`, an object of the same type.
+    // Returns false if the type is not one it knows.
+    bool assign(Object* target, const Object* source) {
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(source)) {
+            *static_cast<Sphere*>(target) = *sphere;
+            return true;
+        }
+        if (const Plane* plane = dynamic_cast<const Plane*>(source)) {
+            *static_cast<Plane*>(target) = *plane;
+            return true;
+        }
+        return false;
+    }
+
+    bool sameLights(const std::vector<Light>& a, const std::vector<Light>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t k = 0; k < a.size(); ++k) {
+            if (std::memcmp(&a[k].position, &b[k].position, sizeof(Vec3f)) != 0 ||
+                std::memcmp(&a[k].color, &b[k].color, sizeof(Vec3f)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int SceneChanges::count(EditType type) const {
+    int n = 0;
+    for (const Edit& edit : edits) {
+        n += edit.type == type;
+    }
+    return n;
+}
+
+SceneChanges SceneDiff::apply(Scene& resident, Scene& loaded) {
+    SceneChanges changes;
+    std::vector<bool> residentKept(resident.objects.size(), false);
+    std::vector<bool> loadedPlaced(loaded.objects.size(), false);
+
+    // 1. Objects that did not change at all. Most reloads edit a few lines in place or append,
+    //    so objects are first compared with the one at the same position; only those left over
+    //    (shifted by insertions or deletions higher up in the file) are looked up by hash.
+    std::vector<Key> residentKeys(resident.objects.size()), loadedKeys(loaded.objects.size());
+    for (size_t k = 0; k < resident.objects.size(); ++k) {
+        residentKeys[k] = makeKey(resident.objects[k]);
+    }
+    for (size_t k = 0; k < loaded.objects.size(); ++k) {
+        loadedKeys[k] = makeKey(loaded.objects[k]);
+        if (k < residentKeys.size() && loadedKeys[k].type != 0 && loadedKeys[k] == residentKeys[k]) {
+            residentKept[k] = loadedPlaced[k] = true;
+        }
+    }
+    // Open-addressing table of the leftover resident objects (power-of-two size, linear probing).
+    size_t tableSize = 16;
+    while (tableSize < 2 * resident.objects.size()) {
+        tableSize *= 2;
+    }
+    std::vector<int> table(tableSize, -1);
+    size_t leftover = 0;
+    for (size_t k = 0; k < resident.objects.size(); ++k) {
+        if (!residentKept[k] && residentKeys[k].type != 0) {
+            size_t slot = hashKey(residentKeys[k]) & (tableSize - 1);
+            while (table[slot] >= 0) {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            table[slot] = static_cast<int>(k);
+            ++leftover;
+        }
+    }
+    for (size_t k = 0; k < loaded.objects.size() && leftover > 0; ++k) {
+        if (loadedPlaced[k] || loadedKeys[k].type == 0) {
+            continue;
+        }
+        for (size_t slot = hashKey(loadedKeys[k]) & (tableSize - 1); table[slot] >= 0; slot = (slot + 1) & (tableSize - 1)) {
+            const int candidate = table[slot];
+            if (!residentKept[candidate] && residentKeys[candidate] == loadedKeys[k]) {
+                residentKept[candidate] = loadedPlaced[k] = true;
+                --leftover;
+                break;
+            }
+        }
+    }
+
+    // 2. Moved, resized or recolored objects: pair the rest by type, in file order, and update in place.
+    //    Their edits are recorded after the removals below, which may move them to other indices.
+    std::vector<bool> residentChanged(resident.objects.size(), false);
+    std::unordered_map<std::type_index, std::deque<int> > spare;
+    for (size_t k = 0; k < resident.objects.size(); ++k) {
+        if (!residentKept[k]) {
+            spare[std::type_index(typeid(*resident.objects[k]))].push_back(static_cast<int>(k));
+        }
+    }
+    for (size_t k = 0; k < loaded.objects.size(); ++k) {
+        if (loadedPlaced[k]) {
+            continue;
+        }
+        std::deque<int>& candidates = spare[std::type_index(typeid(*loaded.objects[k]))];
+        if (!candidates.empty() && assign(resident.objects[candidates.front()], loaded.objects[k])) {
+            residentKept[candidates.front()] = true;
+            residentChanged[candidates.front()] = true;
+            loadedPlaced[k] = true;
+            candidates.pop_front();
+        }
+    }
+
+    // 3. Removed objects, highest index first: Scene::removeObject moves the last object
+    //    into the freed slot, and that object is never one still waiting to be removed.
+    std::vector<int> removed;
+    for (size_t k = 0; k < resident.objects.size(); ++k) {
+        if (!residentKept[k]) {
+            removed.push_back(static_cast<int>(k));
+        }
+    }
+    std::sort(removed.begin(), removed.end(), std::greater<int>());
+    std::unordered_set<const Object*> changed;
+    for (size_t k = 0; k < resident.objects.size(); ++k) {
+        if (residentChanged[k]) {
+            changed.insert(resident.objects[k]);
+        }
+    }
+    for (int index : removed) {
+        resident.removeObject(index);
+        SceneChanges::Edit edit = { SceneChanges::OBJECT_REMOVED, index };
+        changes.edits.push_back(edit);
+    }
+    // The changed objects at the indices the removals left them at.
+    for (size_t k = 0; k < resident.objects.size() && !changed.empty(); ++k) {
+        if (changed.count(resident.objects[k]) != 0) {
+            SceneChanges::Edit edit = { SceneChanges::OBJECT_CHANGED, static_cast<int>(k) };
+            changes.edits.push_back(edit);
+        }
+    }
+
+    // 4. Added objects change owner.
+    for (size_t k = 0; k < loaded.objects.size(); ++k) {
+        if (!loadedPlaced[k]) {
+            resident.addObject(loaded.objects[k]);
+            loaded.objects[k] = nullptr;
+            SceneChanges::Edit edit = { SceneChanges::OBJECT_ADDED, static_cast<int>(resident.objects.size()) - 1 };
+            changes.edits.push_back(edit);
+        }
+    }
+    loaded.objects.erase(std::remove(loaded.objects.begin(), loaded.objects.end(), static_cast<Object*>(nullptr)),
+                         loaded.objects.end());
+
+    if (!sameLights(resident.lights, loaded.lights)) {
+        resident.lights = loaded.lights;
+        changes.lightsChanged = true;
+    }
+    resident.updateMemoryAccounts();
+    if (std::memcmp(&resident.backgroundColor, &loaded.backgroundColor, sizeof(Vec3f)) != 0) {
+        resident.backgroundColor = loaded.backgroundColor;
+        changes.backgroundChanged = true;
+    }
+    return changes;
+}
+
+namespace {
+    // Random object for the check. Coordinates are small integers, so that identical objects
+    // (matched by hash) occur as well as near misses.
+    Object* randomObject(uint32_t seed, uint32_t index) {
+        auto value = [&](uint32_t component) { return static_cast<float>(static_cast<int>(Random::uniform(seed, index, component) * 4.0f)); };
+        const Vec3f color(value(3) * 0.25f, value(4) * 0.25f, 0.5f);
+        if (Random::uniform(seed, index, 5) < 0.7f) {
+            return new Sphere(Vec3f(value(0), value(1), value(2)), 0.5f + value(6) * 0.25f, color);
+        }
+        return new Plane(Vec3f(value(0), value(1), value(2)), Vec3f(0.0f, value(6) < 2.0f ? 1.0f : -1.0f, 0.0f), color);
+    }
+
+    Object* copyObject(const Object* obj) {
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(obj)) {
+            return new Sphere(*sphere);
+        }
+        return new Plane(*static_cast<const Plane*>(obj));
+    }
+
+    // Objects of a scene as sorted keys, to compare scenes regardless of object order.
+    std::vector<Key> sortedKeys(const Scene& scene) {
+        std::vector<Key> keys;
+        for (const Object* obj : scene.objects) {
+            keys.push_back(makeKey(obj));
+        }
+        std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) { return std::memcmp(&a, &b, sizeof(Key)) < 0; });
+        return keys;
+    }
+
+    // A packet copy's primitives as keys per scene object index (type 0 for objects it lacks).
+    // Returns false if an object index is out of range or appears twice.
+    bool packetKeys(const Kernels::PacketScene& packets, size_t objectCount, std::vector<Key>& keys) {
+        const Kernels::SceneView view = packets.view();
+        Key empty;
+        std::memset(&empty, 0, sizeof(Key));
+        keys.assign(objectCount, empty);
+        for (int p = 0; p < view.sphereCount + view.planeCount; ++p) {
+            const int index = packets.objectIndex(p);
+            if (index < 0 || static_cast<size_t>(index) >= objectCount || keys[index].type != 0) {
+                return false;
+            }
+            Key& key = keys[index];
+            if (p < view.sphereCount) {
+                key.type = 'S';
+                put(key.values, Vec3f(view.sphereX[p], view.sphereY[p], view.sphereZ[p]));
+                key.values[3] = view.sphereRadius[p];
+                put(key.values + 4, Vec3f(view.sphereR[p], view.sphereG[p], view.sphereB[p]));
+            } else {
+                const int q = p - view.sphereCount;
+                key.type = 'P';
+                put(key.values, Vec3f(view.planePointX[q], view.planePointY[q], view.planePointZ[q]));
+                put(key.values + 3, Vec3f(view.planeNormalX[q], view.planeNormalY[q], view.planeNormalZ[q]));
+                put(key.values + 6, Vec3f(view.planeR[q], view.planeG[q], view.planeB[q]));
+            }
+        }
+        return true;
+    }
+
+    // True if `updated` holds the same primitives for the same object indices, and the same
+    // lights and background, as `fresh`.
+    bool samePackets(const Kernels::PacketScene& updated, const Kernels::PacketScene& fresh, size_t objectCount) {
+        std::vector<Key> a, b;
+        if (!packetKeys(updated, objectCount, a) || !packetKeys(fresh, objectCount, b) || !(a == b)) {
+            return false;
+        }
+        const Kernels::SceneView u = updated.view(), f = fresh.view();
+        if (u.lightCount != f.lightCount || std::memcmp(&u.background, &f.background, sizeof(Vec3f)) != 0) {
+            return false;
+        }
+        for (int l = 0; l < u.lightCount; ++l) {
+            if (u.lightX[l] != f.lightX[l] || u.lightY[l] != f.lightY[l] || u.lightZ[l] != f.lightZ[l] ||
+                u.lightR[l] != f.lightR[l] || u.lightG[l] != f.lightG[l] || u.lightB[l] != f.lightB[l]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int runSceneDiffCheck(int iterations) {
+    const int RELOADS = 8;
+    int failures = 0;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        const uint32_t seed = static_cast<uint32_t>(iteration) * RELOADS;
+        Scene resident;
+        const int initial = static_cast<int>(Random::uniform(seed, 0, 0) * 12.0f);
+        for (int k = 0; k < initial; ++k) {
+            resident.addObject(randomObject(seed, 1000 + k));
+        }
+        resident.addLight(Light(Vec3f(0.0f, 5.0f, 0.0f), Vec3f(1.0f)));
+        Kernels::PacketScene packets(resident);
+
+        for (int reload = 0; reload < RELOADS && failures == 0; ++reload) {
+            // The new version of the file: the current objects, edited at random, in a new order.
+            const uint32_t step = seed + static_cast<uint32_t>(reload);
+            Scene loaded(resident.backgroundColor);
+            uint32_t draw = 0;
+            for (const Object* obj : resident.objects) {
+                const float choice = Random::uniform(step, 2, draw++);
+                if (choice < 0.15f) {
+                    continue; // Removed
+                }
+                loaded.addObject(choice < 0.35f ? randomObject(step, 2000 + draw) : copyObject(obj)); // Edited or kept
+            }
+            const int added = static_cast<int>(Random::uniform(step, 3, 0) * 4.0f);
+            for (int k = 0; k < added; ++k) {
+                loaded.addObject(randomObject(step, 3000 + k));
+            }
+            for (size_t k = loaded.objects.size(); k > 1; --k) {
+                std::swap(loaded.objects[k - 1], loaded.objects[static_cast<size_t>(Random::uniform(step, 4, k) * k)]);
+            }
+            loaded.lights = resident.lights;
+            if (Random::uniform(step, 5, 0) < 0.25f) {
+                loaded.lights[0].position = loaded.lights[0].position + Vec3f(1.0f, 0.0f, 0.0f);
+            }
+            if (Random::uniform(step, 5, 1) < 0.25f) {
+                loaded.backgroundColor = loaded.backgroundColor * 0.5f;
+            }
+            const std::vector<Key> expected = sortedKeys(loaded);
+
+            const SceneChanges changes = SceneDiff::apply(resident, loaded);
+            packets.update(resident, changes);
+            const bool sceneMatches = sortedKeys(resident) == expected;
+            const bool packetsMatch = samePackets(packets, Kernels::PacketScene(resident), resident.objects.size());
+            if (!sceneMatches || !packetsMatch) {
+                printf("Scene diff check: iteration %d, reload %d: %s does not match (+%d -%d ~%d objects)\n", iteration,
+                       reload, sceneMatches ? "packet copy" : "scene", changes.count(SceneChanges::OBJECT_ADDED),
+                       changes.count(SceneChanges::OBJECT_REMOVED), changes.count(SceneChanges::OBJECT_CHANGED));
+                ++failures;
+            }
+        }
+        if (failures > 0) {
+            break;
+        }
+    }
+    printf("Scene diff check: %s after %d scenes of %d reloads\n", failures == 0 ? "passed" : "FAILED", iterations, RELOADS);
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,54 @@
+// src/SceneDiff.h
+#ifndef SCENE_DIFF_H
+#define SCENE_DIFF_H
+
+#include <vector>
+
+#include "Scene.h"
+
+// Edits made to a resident scene, in the order they are to be replayed, so that data derived
+// from the scene (Kernels::PacketScene, render histories) can follow them one by one
+// instead of being rebuilt. Each index refers to the scene as the edits before it left it.
+struct SceneChanges {
+    enum EditType {
+        OBJECT_CHANGED, // objects[index] was moved, resized or recolored in place
+        OBJECT_REMOVED, // objects[index] was deleted and the last object moved into its slot (Scene::removeObject)
+        OBJECT_ADDED    // A new object was appended at objects[index]
+    };
+    struct Edit {
+        EditType type;
+        int index;
+    };
+
+    std::vector<Edit> edits;
+    bool lightsChanged = false;     // Scene::lights was replaced
+    bool backgroundChanged = false; // Scene::backgroundColor changed
+
+    // Number of edits of the given type.
+    int count(EditType type) const;
+    bool empty() const { return edits.empty() && !lightsChanged && !backgroundChanged; }
+};
+
+// Brings a resident scene in line with a newly loaded version of it, touching only what differs.
+namespace SceneDiff {
+    // Compares `resident` against `loaded` and edits `resident` to match:
+    //  - objects present in both (same type, geometry and color) are left alone;
+    //  - remaining objects of the same type are paired in file order and updated in place,
+    //    so pointers to them (e.g. the GUI selection) stay valid;
+    //  - leftover resident objects are removed and leftover loaded objects are moved over
+    //    (`loaded` gives up their ownership).
+    // Lights and the background are replaced if they differ. Returns the edits made: the removals
+    // (highest index first), then the changed objects at the indices the removals left them at,
+    // then the additions.
+    // Object order in `resident` may differ from the file afterwards; rendering does not depend on it.
+    SceneChanges apply(Scene& resident, Scene& loaded);
+}
+
+// Checks SceneDiff::apply and Kernels::PacketScene::update on random scenes: each of `iterations`
+// scenes is reloaded from several randomly edited versions (objects moved, recolored, removed,
+// added, retyped and reordered), and after every reload the scene must match the loaded version
+// and the updated packet copy a fresh PacketScene of it. Prints the result; returns 0, or -1 if
+// any reload did not match.
+int runSceneDiffCheck(int iterations);
+
+#endif // SCENE_DIFF_H
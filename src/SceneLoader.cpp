@@ -0,0 +1,101 @@
+// src/SceneLoader.cpp
+#include "SceneLoader.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Light.h"
+#include <fstream> // For std::ifstream
+#include <sstream> // For std::istringstream
+
+const char* SceneLoader::DEFAULT_SCENE = "default";
+
+void SceneLoader::buildDefaultScene(Scene& scene) {
+    scene.backgroundColor = Vec3f(0.1f, 0.1f, 0.2f); // Slightly bluish background
+
+    // Add objects to the scene
+    scene.addObject(new Sphere(Vec3f(0.0f, 0.5f, 0.0f), 1.0f, Vec3f(1.0f, 0.0f, 0.0f))); // Red sphere (sits on plane)
+    scene.addObject(new Sphere(Vec3f(1.8f, 0.0f, -1.5f), 0.6f, Vec3f(0.0f, 1.0f, 0.0f))); // Green sphere (raised to be above plane)
+    scene.addObject(new Sphere(Vec3f(-1.5f, 1.0f, 0.8f), 0.7f, Vec3f(0.0f, 0.0f, 1.0f))); // Blue sphere (already above plane)
+    scene.addObject(new Plane(Vec3f(0.0f, -1.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f), Vec3f(0.8f, 0.8f, 0.8f))); // Ground Plane
+    scene.addObject(new Sphere(Vec3f(-2.0f, 0.0f, -0.5f), 0.4f, Vec3f(1.0f, 1.0f, 0.0f))); // Yellow sphere (raised to be above plane)
+
+    // Add light sources to the scene
+    scene.addLight(Light(Vec3f(6.0f, 6.0f, 6.0f), Vec3f(1.0f, 1.0f, 1.0f)));
+    scene.addLight(Light(Vec3f(-6.0f, 4.0f, 3.0f), Vec3f(0.5f, 0.8f, 1.0f)));
+}
+
+bool SceneLoader::parse(const std::string& text, Scene& scene, SceneCamera& camera, std::string& error) {
+    std::istringstream input(text);
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        // Strip comments and skip blank lines
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+
+        Vec3f a, b, c;
+        float f = 0.0f;
+        bool ok = true;
+        if (keyword == "background") {
+            ok = static_cast<bool>(fields >> a.x >> a.y >> a.z);
+            scene.backgroundColor = a;
+        } else if (keyword == "camera") {
+            ok = static_cast<bool>(fields >> a.x >> a.y >> a.z >> b.x >> b.y >> b.z >> f);
+            camera.eye = a;
+            camera.lookAt = b;
+            camera.fov = f;
+        } else if (keyword == "sphere") {
+            ok = static_cast<bool>(fields >> a.x >> a.y >> a.z >> f >> c.x >> c.y >> c.z) && f > 0.0f;
+            if (ok) {
+                scene.addObject(new Sphere(a, f, c));
+            }
+        } else if (keyword == "plane") {
+            ok = static_cast<bool>(fields >> a.x >> a.y >> a.z >> b.x >> b.y >> b.z >> c.x >> c.y >> c.z) && b.lengthSquared() > 0.0f;
+            if (ok) {
+                scene.addObject(new Plane(a, b, c));
+            }
+        } else if (keyword == "light") {
+            ok = static_cast<bool>(fields >> a.x >> a.y >> a.z >> c.x >> c.y >> c.z);
+            if (ok) {
+                scene.addLight(Light(a, c));
+            }
+        } else {
+            error = "line " + std::to_string(lineNumber) + ": unknown keyword '" + keyword + "'";
+            return false;
+        }
+
+        if (!ok) {
+            error = "line " + std::to_string(lineNumber) + ": malformed '" + keyword + "' entry";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SceneLoader::load(const std::string& path, Scene& scene, SceneCamera& camera, std::string& error) {
+    if (path == DEFAULT_SCENE) {
+        buildDefaultScene(scene);
+        return true;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "could not open scene file " + path;
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!parse(contents.str(), scene, camera, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
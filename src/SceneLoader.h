@@ -0,0 +1,41 @@
+// src/SceneLoader.h
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include <string>
+
+#include "Vec3.h"
+#include "Scene.h"
+
+// Camera placement stored alongside a scene description.
+struct SceneCamera {
+    Vec3f eye = Vec3f(0.0f, 0.0f, -6.0f); // Matches the interactive orbit camera's start position
+    Vec3f lookAt = Vec3f(0.0f);
+    float fov = 75.0f;
+};
+
+// Reads scenes from a simple line-based text format:
+//
+//   # comment
+//   background r g b
+//   camera     ex ey ez  lx ly lz  fov
+//   sphere     cx cy cz  radius    r g b
+//   plane      px py pz  nx ny nz  r g b
+//   light      px py pz  r g b
+//
+// The reference "default" (see DEFAULT_SCENE) names the built-in demo scene.
+namespace SceneLoader {
+    extern const char* DEFAULT_SCENE;
+
+    // Parses `text` into `scene` (and `camera`, if a camera line is present).
+    // Returns false and describes the problem in `error` on malformed input.
+    bool parse(const std::string& text, Scene& scene, SceneCamera& camera, std::string& error);
+
+    // Loads the scene file at `path` ("default" loads the built-in demo scene).
+    bool load(const std::string& path, Scene& scene, SceneCamera& camera, std::string& error);
+
+    // Adds the built-in demo scene (four spheres on a ground plane, two lights).
+    void buildDefaultScene(Scene& scene);
+}
+
+#endif // SCENE_LOADER_H
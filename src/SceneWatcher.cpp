@@ -0,0 +1,75 @@
+// src/SceneWatcher.cpp
+#include "SceneWatcher.h"
+#include <sys/stat.h> // For stat (fallback)
+#include <cstdio>     // For fprintf
+
+#ifdef __linux__
+#include <sys/inotify.h> // For inotify_init1, inotify_add_watch
+#include <unistd.h>      // For read, close
+#include <cstring>       // For std::strcmp
+#endif
+
+namespace {
+    // Modification time of `path`, or 0 if it does not exist.
+    std::time_t modificationTime(const std::string& path) {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+    }
+}
+
+SceneWatcher::SceneWatcher(const std::string& path)
+    : filePath(path), inotifyFd(-1), lastModified(modificationTime(path)) {
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+
+#ifdef __linux__
+    // Watch the directory rather than the file: saving via rename replaces the file's inode.
+    // IN_CREATE is left out on purpose, as the new file is still empty at that point.
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    if (inotifyFd < 0) {
+        fprintf(stderr, "Warning: inotify unavailable for %s, polling its modification time\n", directory.c_str());
+    }
+#else
+    (void)directory;
+#endif
+}
+
+SceneWatcher::~SceneWatcher() {
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+#endif
+}
+
+bool SceneWatcher::changed() {
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        // Drain every pending event; any of them naming our file counts.
+        bool written = false;
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                if (event->len > 0 && std::strcmp(event->name, fileName.c_str()) == 0) {
+                    written = true;
+                }
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return written;
+    }
+#endif
+    std::time_t modified = modificationTime(filePath);
+    if (modified != lastModified) {
+        lastModified = modified;
+        return modified != 0; // A file that is being replaced may briefly not exist
+    }
+    return false;
+}
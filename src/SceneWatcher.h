@@ -0,0 +1,35 @@
+// src/SceneWatcher.h
+#ifndef SCENE_WATCHER_H
+#define SCENE_WATCHER_H
+
+#include <string>
+#include <ctime>
+
+// Reports when a scene file has been written, so the interactive window can reload it.
+//
+// On Linux the file's directory is watched with inotify, which also catches editors that
+// save by writing a new file and renaming it over the old one; changed() then costs one
+// non-blocking read per frame. Elsewhere it falls back to comparing the file's
+// modification time on every call.
+class SceneWatcher {
+public:
+    explicit SceneWatcher(const std::string& path);
+    ~SceneWatcher();
+
+    // True once after each time the file was written (several writes in between count as one).
+    // Never blocks.
+    bool changed();
+
+    const std::string& path() const { return filePath; }
+
+private:
+    std::string filePath;
+    std::string fileName;     // Name within its directory, to filter the directory's events
+    int inotifyFd;            // -1 when polling modification times instead
+    std::time_t lastModified; // Fallback: modification time at the last check
+
+    SceneWatcher(const SceneWatcher&) = delete;
+    SceneWatcher& operator=(const SceneWatcher&) = delete;
+};
+
+#endif // SCENE_WATCHER_H
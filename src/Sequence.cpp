@@ -0,0 +1,190 @@
+// src/Sequence.cpp
+#include "Sequence.h"
+#include "BoundedQueue.h"
+#include "Renderer.h"
+#include "Denoiser.h"
+#include "MemoryTracker.h"
+#include "Utils.h"
+#include <atomic>  // For std::atomic
+#include <chrono>  // For stage timings
+#include <cstdio>  // For FILE, fwrite, printf
+#include <memory>  // For std::unique_ptr
+#include <thread>  // For std::thread
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // A frame buffer circulating between the trace and post stages, with the denoiser
+    // features recorded for it.
+    struct TracedFrame {
+        int frame = 0;
+        std::vector<Vec3f> pixels;
+        Denoiser denoiser;
+        MemoryTracker::Account memory{ MemoryTracker::MEMORY_FRAMEBUFFERS };
+        double traceMs = 0.0;
+        double waitMs = 0.0; // Time the tracer waited for this buffer to come back
+        ShadowCache::Stats shadowCache = ShadowCache::Stats(); // Of this frame, with Options::shadowCache
+    };
+
+    // A finished image on its way to the disk.
+    struct EncodedFrame {
+        int frame = 0;
+        std::string ppm;
+        MemoryTracker::Account memory{ MemoryTracker::MEMORY_IMAGE_OUTPUT };
+        double traceMs = 0.0;
+        double waitMs = 0.0;
+        double postMs = 0.0;
+        ShadowCache::Stats shadowCache = ShadowCache::Stats();
+    };
+}
+
+std::string Sequence::framePath(const std::string& prefix, int frame) {
+    char number[16];
+    snprintf(number, sizeof(number), "_%04d.ppm", frame);
+    return prefix + number;
+}
+
+int Sequence::render(const Scene& scene, Camera& camera, const CameraPath& path, const Options& options) {
+    const int width = camera.imageWidth;
+    const int height = camera.imageHeight;
+    const int frameCount = options.lastFrame - options.firstFrame + 1;
+    if (frameCount <= 0) {
+        fprintf(stderr, "Error: empty frame range %d-%d.\n", options.firstFrame, options.lastFrame);
+        return -1;
+    }
+    const int depth = options.depth > 0 ? options.depth : 1;
+
+    // The buffers are allocated once and recycled through `freeFrames`.
+    std::vector<std::unique_ptr<TracedFrame>> buffers;
+    BoundedQueue<TracedFrame*> freeFrames(depth);
+    BoundedQueue<TracedFrame*> tracedFrames(depth);
+    BoundedQueue<EncodedFrame*> encodedFrames(depth);
+    for (int b = 0; b < depth; ++b) {
+        buffers.emplace_back(new TracedFrame());
+        buffers.back()->pixels.resize(static_cast<size_t>(width) * height);
+        buffers.back()->memory.set(MemoryTracker::capacityBytes(buffers.back()->pixels));
+        freeFrames.push(buffers.back().get());
+    }
+    std::atomic<bool> failed(false);
+    SharedFrameExport* frameExport = options.frameExport; // Dropped after a publish error (post stage only)
+
+    // Post stage: denoise, encode, and hand the buffer back to the tracer before the disk sees it.
+    std::thread post([&]() {
+        TracedFrame* traced = nullptr;
+        while (tracedFrames.pop(traced)) {
+            const Clock::time_point start = Clock::now();
+            if (options.denoise) {
+                traced->denoiser.filter(traced->pixels);
+            }
+            if (frameExport && !frameExport->publish(traced->pixels.data(), width, height)) {
+                // The frames are still written; only the export stops, as in the window.
+                fprintf(stderr, "Warning: Could not publish frame %d: %s. Shared-memory export disabled.\n",
+                        traced->frame, frameExport->error().c_str());
+                frameExport = nullptr;
+            }
+            EncodedFrame* encoded = new EncodedFrame();
+            encoded->frame = traced->frame;
+            encoded->ppm = Utils::encodePPM(width, height, traced->pixels.data());
+            encoded->memory.set(encoded->ppm.capacity());
+            encoded->traceMs = traced->traceMs;
+            encoded->waitMs = traced->waitMs;
+            encoded->shadowCache = traced->shadowCache;
+            freeFrames.push(traced);
+            encoded->postMs = millisecondsSince(start);
+            if (!encodedFrames.push(encoded)) {
+                delete encoded;
+            }
+        }
+        encodedFrames.close();
+    });
+
+    // Write stage: the only thread touching the disk, and the only one printing per-frame lines.
+    int finished = 0;
+    double totalTraceMs = 0.0, totalWaitMs = 0.0, totalPostMs = 0.0, totalWriteMs = 0.0;
+    long long cacheLookups = 0, cacheHits = 0, cacheRaysSaved = 0;
+    std::thread write([&]() {
+        EncodedFrame* encoded = nullptr;
+        while (encodedFrames.pop(encoded)) {
+            const Clock::time_point start = Clock::now();
+            const std::string file = framePath(options.prefix, encoded->frame);
+            FILE* out = fopen(file.c_str(), "wb");
+            bool ok = out && fwrite(encoded->ppm.data(), 1, encoded->ppm.size(), out) == encoded->ppm.size();
+            ok = out && fclose(out) == 0 && ok;
+            const double writeMs = millisecondsSince(start);
+            if (!ok) {
+                fprintf(stderr, "Error: Could not write %s.\n", file.c_str());
+                failed = true;
+            } else {
+                printf("Frame %4d  trace %8.1f ms  waited %6.1f ms  post %6.1f ms  write %6.1f ms  %s",
+                       encoded->frame, encoded->traceMs, encoded->waitMs, encoded->postMs, writeMs, file.c_str());
+                if (options.shadowCache) {
+                    printf("  shadow cache %5.1f%% (%lld rays saved)", 100.0 * encoded->shadowCache.hitRate(),
+                           encoded->shadowCache.raysSaved());
+                }
+                printf("\n");
+            }
+            ++finished;
+            totalTraceMs += encoded->traceMs;
+            totalWaitMs += encoded->waitMs;
+            totalPostMs += encoded->postMs;
+            totalWriteMs += writeMs;
+            cacheLookups += encoded->shadowCache.lookups;
+            cacheHits += encoded->shadowCache.hits;
+            cacheRaysSaved += encoded->shadowCache.raysSaved();
+            delete encoded;
+        }
+    });
+
+    // Trace stage, on the calling thread. The packet scene is built once for all frames.
+    const Clock::time_point sequenceStart = Clock::now();
+    const Kernels::PacketScene packetScene(scene);
+    for (int frame = options.firstFrame; frame <= options.lastFrame && !failed; ++frame) {
+        const Clock::time_point waitStart = Clock::now();
+        TracedFrame* traced = nullptr;
+        if (!freeFrames.pop(traced)) {
+            break;
+        }
+        traced->frame = frame;
+        traced->waitMs = millisecondsSince(waitStart);
+
+        const Clock::time_point traceStart = Clock::now();
+        path.at(frame).apply(camera);
+        Renderer renderer(&scene, &camera, packetScene);
+        renderer.samplesPerPixel = options.samplesPerPixel;
+        if (options.denoise) {
+            renderer.features = traced->denoiser.prepare(width, height);
+        }
+        if (options.shadowCache) {
+            renderer.shadowCache = options.shadowCache;
+            options.shadowCache->beginFrame(scene);
+        }
+        renderer.renderFrame(traced->pixels);
+        if (options.shadowCache) {
+            options.shadowCache->endFrame();
+            traced->shadowCache = options.shadowCache->stats;
+        }
+        traced->traceMs = millisecondsSince(traceStart);
+        tracedFrames.push(traced);
+    }
+    tracedFrames.close();
+    post.join();
+    write.join();
+    freeFrames.close();
+
+    const double totalMs = millisecondsSince(sequenceStart);
+    const int frames = finished > 0 ? finished : 1;
+    printf("Sequence: %d frames in %.1f ms (%.2f frames/s); per frame: trace %.1f ms, tracer waited %.1f ms, "
+           "post %.1f ms, write %.1f ms\n",
+           finished, totalMs, finished * 1000.0 / totalMs, totalTraceMs / frames, totalWaitMs / frames,
+           totalPostMs / frames, totalWriteMs / frames);
+    if (options.shadowCache) {
+        printf("Shadow cache: %.1f%% hit rate, %lld of %lld shadow rays saved\n",
+               cacheLookups > 0 ? 100.0 * cacheHits / cacheLookups : 0.0, cacheRaysSaved, cacheLookups);
+    }
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,46 @@
+// src/Sequence.h
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <string>
+
+#include "Scene.h"
+#include "Camera.h"
+#include "CameraPath.h"
+#include "SharedFrameExport.h"
+#include "ShadowCache.h"
+
+// Headless rendering of animations: one image per frame of a camera path.
+//
+// Frames move through a three-stage pipeline, each stage on its own thread:
+//   trace  (calling thread, all cores)  places the camera and renders the frame
+//   post   (one thread)                 denoises and encodes the frame as a binary PPM (and
+//                                       publishes it to shared memory, if requested)
+//   write  (one thread)                 writes the encoded file to disk
+// so frame N+1 is traced while frame N is post-processed and written. The stages are
+// connected by bounded queues (BoundedQueue.h): `depth` frame buffers circulate between
+// trace and post, and at most `depth` encoded images wait for the disk. The tracer only
+// waits when every buffer is still in flight, i.e. when post-processing or the disk falls
+// `depth` frames behind; that wait is reported per frame.
+namespace Sequence {
+    struct Options {
+        std::string prefix = "frame"; // Frame f is written to <prefix>_<ffff>.ppm
+        int firstFrame = 0;
+        int lastFrame = 0;            // Inclusive
+        int samplesPerPixel = 1;
+        bool denoise = false;         // Filter every frame with Denoiser
+        int depth = 3;                // Frames in flight per queue
+        SharedFrameExport* frameExport = nullptr; // Also publish every frame here (post stage; not owned; dropped on error)
+        ShadowCache* shadowCache = nullptr;       // Reuse shadow rays across frames through this cache (not owned)
+    };
+
+    // File name of frame `frame`, e.g. "orbit_0042.ppm".
+    std::string framePath(const std::string& prefix, int frame);
+
+    // Renders options.firstFrame..lastFrame of `path` with `camera` (moved to each frame's pose;
+    // its image size sets the frame size) and prints per-frame timings and a summary.
+    // Returns 0, or -1 if a frame could not be written.
+    int render(const Scene& scene, Camera& camera, const CameraPath& path, const Options& options);
+}
+
+#endif // SEQUENCE_H
@@ -0,0 +1,515 @@
+// src/ShadowCache.cpp
+#include "ShadowCache.h"
+#include "Random.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include <algorithm>  // For std::sort, std::set_symmetric_difference, std::min, std::max
+#include <cmath>      // For std::floor, std::fabs
+#include <cstring>    // For std::memcmp, std::memset
+#include <functional> // For std::less
+#include <iterator>   // For std::back_inserter
+
+namespace {
+    // Per-light state of a cell, one byte: the kind in the low two bits and the number of
+    // agreeing shadow rays traced from the cell (saturating at 63) in the upper six.
+    const unsigned char STATE_UNKNOWN = 0;  // No ray traced yet
+    const unsigned char STATE_VISIBLE = 1;  // Every ray reached the light
+    const unsigned char STATE_OCCLUDED = 2; // Every ray was blocked
+    const unsigned char STATE_MIXED = 3;    // Rays disagreed: shadow boundary, always traced
+    const int MAX_COUNT = 63;
+
+    // Cell coordinates take 19 bits per axis (offset to be non-negative) and the normal 6 bits;
+    // the top bit marks a used key, so that 0 can stand for an empty slot.
+    const int COORD_BITS = 19;
+    const int64_t COORD_OFFSET = int64_t(1) << (COORD_BITS - 1);
+    const uint64_t COORD_MASK = (uint64_t(1) << COORD_BITS) - 1;
+    const int NORMAL_BINS = 8; // Per axis of the octahedral map: 64 directions
+    const uint64_t KEY_USED = uint64_t(1) << 63;
+
+    // How resolve() answered a hit-light pair.
+    const unsigned char ANSWER_TRACED = 0;   // Shadow ray cast
+    const unsigned char ANSWER_CACHED = 1;   // Taken from the cache
+    const unsigned char ANSWER_VERIFIED = 2; // Known to the cache, but traced to check it
+
+    const size_t INITIAL_SLOTS = 4096; // Power of two
+
+    // Octahedral bin of a unit normal (the sphere of directions unfolded onto a square).
+    int normalBin(const Vec3f& n) {
+        float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (sum <= 0.0f) {
+            return 0;
+        }
+        float u = n.x / sum;
+        float v = n.y / sum;
+        if (n.z < 0.0f) {
+            float foldedU = (1.0f - std::fabs(v)) * (u < 0.0f ? -1.0f : 1.0f);
+            float foldedV = (1.0f - std::fabs(u)) * (v < 0.0f ? -1.0f : 1.0f);
+            u = foldedU;
+            v = foldedV;
+        }
+        int bu = std::min(static_cast<int>((u * 0.5f + 0.5f) * NORMAL_BINS), NORMAL_BINS - 1);
+        int bv = std::min(static_cast<int>((v * 0.5f + 0.5f) * NORMAL_BINS), NORMAL_BINS - 1);
+        return std::max(bv, 0) * NORMAL_BINS + std::max(bu, 0);
+    }
+
+    // Merges `count` rays with the same result into a cell's state for one light.
+    unsigned char mergeState(unsigned char state, bool visible, int count) {
+        const unsigned char kind = visible ? STATE_VISIBLE : STATE_OCCLUDED;
+        switch (state & 3) {
+        case STATE_UNKNOWN:
+            return static_cast<unsigned char>(kind | std::min(count, MAX_COUNT) << 2);
+        case STATE_MIXED:
+            return state;
+        default:
+            if ((state & 3) != kind) {
+                return STATE_MIXED;
+            }
+            return static_cast<unsigned char>(kind | std::min((state >> 2) + count, MAX_COUNT) << 2);
+        }
+    }
+
+    // True if the segment a-b passes within `distance` of `point`.
+    bool segmentNear(const Vec3f& a, const Vec3f& b, const Vec3f& point, float distance) {
+        Vec3f ab = b - a;
+        float lengthSquared = ab.lengthSquared();
+        float t = lengthSquared > 0.0f ? (point - a).dot(ab) / lengthSquared : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        return (a + ab * t - point).lengthSquared() <= distance * distance;
+    }
+}
+
+bool ShadowCache::Shape::operator<(const Shape& other) const {
+    if (type != other.type) {
+        return type < other.type;
+    }
+    int order = std::memcmp(values, other.values, sizeof(values));
+    if (order != 0) {
+        return order < 0;
+    }
+    return std::less<const Object*>()(object, other.object);
+}
+
+ShadowCache::ShadowCache()
+    : cellSize(0.05f), minSamples(4), verifyFraction(1.0f / 32.0f), refineShadowEdges(true), stats(),
+      lightCount(0), tableCellSize(0.0f), cells(0), frame(0), counts(), memory(MemoryTracker::MEMORY_RENDER_CACHES) {}
+
+void ShadowCache::invalidate() {
+    std::fill(states.begin(), states.end(), STATE_UNKNOWN);
+}
+
+void ShadowCache::release() {
+    std::vector<uint64_t>().swap(keys);
+    std::vector<unsigned char>().swap(states);
+    std::vector<Sample>().swap(pending);
+    std::vector<Shape>().swap(shapes);
+    std::vector<Vec3f>().swap(lightPositions);
+    lightCount = 0;
+    cells = 0;
+    memory.set(0);
+}
+
+uint64_t ShadowCache::cellKey(const Vec3f& point, const Vec3f& normal) const {
+    const float scale = 1.0f / tableCellSize;
+    const float limit = static_cast<float>(COORD_OFFSET);
+    float gx = std::floor(point.x * scale);
+    float gy = std::floor(point.y * scale);
+    float gz = std::floor(point.z * scale);
+    // Written so that NaN coordinates fail as well.
+    if (!(std::fabs(gx) < limit && std::fabs(gy) < limit && std::fabs(gz) < limit)) {
+        return 0; // Outside the grid: traced every frame
+    }
+    uint64_t ix = static_cast<uint64_t>(static_cast<int64_t>(gx) + COORD_OFFSET) & COORD_MASK;
+    uint64_t iy = static_cast<uint64_t>(static_cast<int64_t>(gy) + COORD_OFFSET) & COORD_MASK;
+    uint64_t iz = static_cast<uint64_t>(static_cast<int64_t>(gz) + COORD_OFFSET) & COORD_MASK;
+    return KEY_USED | ix << (6 + 2 * COORD_BITS) | iy << (6 + COORD_BITS) | iz << 6 | static_cast<uint64_t>(normalBin(normal));
+}
+
+Vec3f ShadowCache::cellCenter(uint64_t key) const {
+    auto coordinate = [&](int shift) {
+        int64_t cell = static_cast<int64_t>((key >> shift) & COORD_MASK) - COORD_OFFSET;
+        return (static_cast<float>(cell) + 0.5f) * tableCellSize;
+    };
+    return Vec3f(coordinate(6 + 2 * COORD_BITS), coordinate(6 + COORD_BITS), coordinate(6));
+}
+
+long long ShadowCache::find(uint64_t key) const {
+    const size_t mask = keys.size() - 1;
+    for (size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;; slot = (slot + 1) & mask) {
+        if (keys[slot] == key) {
+            return static_cast<long long>(slot);
+        }
+        if (keys[slot] == 0) {
+            return -1;
+        }
+    }
+}
+
+long long ShadowCache::insert(uint64_t key) {
+    if (static_cast<size_t>(cells + 1) * 2 > keys.size()) {
+        grow(); // Keep the table at most half full, so probe sequences stay short
+    }
+    const size_t mask = keys.size() - 1;
+    size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (keys[slot] != key) {
+        if (keys[slot] == 0) {
+            keys[slot] = key;
+            ++cells;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return static_cast<long long>(slot);
+}
+
+void ShadowCache::clearTable(int lights) {
+    lightCount = lights;
+    keys.assign(INITIAL_SLOTS, 0);
+    states.assign(INITIAL_SLOTS * lights, STATE_UNKNOWN);
+    std::vector<uint64_t>(keys).swap(keys); // Shrink after a larger table
+    std::vector<unsigned char>(states).swap(states);
+    cells = 0;
+}
+
+void ShadowCache::grow() {
+    std::vector<uint64_t> oldKeys;
+    std::vector<unsigned char> oldStates;
+    oldKeys.swap(keys);
+    oldStates.swap(states);
+    keys.assign(oldKeys.size() * 2, 0);
+    states.assign(keys.size() * lightCount, STATE_UNKNOWN);
+    cells = 0;
+    for (size_t slot = 0; slot < oldKeys.size(); ++slot) {
+        if (oldKeys[slot] != 0) {
+            long long moved = insert(oldKeys[slot]);
+            std::copy(oldStates.begin() + slot * lightCount, oldStates.begin() + (slot + 1) * lightCount,
+                      states.begin() + moved * lightCount);
+        }
+    }
+}
+
+void ShadowCache::invalidateNear(const Shape& shape) {
+    // A cell's rays start anywhere inside it, so the test is widened by half its diagonal.
+    const float margin = tableCellSize * 0.8660254f;
+    for (size_t slot = 0; slot < keys.size(); ++slot) {
+        if (keys[slot] == 0) {
+            continue;
+        }
+        const Vec3f center = cellCenter(keys[slot]);
+        for (int l = 0; l < lightCount; ++l) {
+            unsigned char& state = states[slot * lightCount + l];
+            if (state == STATE_UNKNOWN) {
+                continue;
+            }
+            bool near = true; // Unknown types: anything may have changed
+            if (shape.type == 'S') {
+                Vec3f sphereCenter(shape.values[0], shape.values[1], shape.values[2]);
+                near = segmentNear(center, lightPositions[l], sphereCenter, shape.values[3] + margin);
+            } else if (shape.type == 'P') {
+                Vec3f point(shape.values[0], shape.values[1], shape.values[2]);
+                Vec3f normal(shape.values[3], shape.values[4], shape.values[5]);
+                float cellSide = (center - point).dot(normal);
+                float lightSide = (lightPositions[l] - point).dot(normal);
+                near = cellSide * lightSide <= 0.0f || std::fabs(cellSide) <= margin;
+            }
+            if (near) {
+                state = STATE_UNKNOWN;
+                ++counts.invalidated;
+            }
+        }
+    }
+}
+
+void ShadowCache::followEdits(const Scene& scene) {
+    std::vector<Shape> current;
+    current.reserve(scene.objects.size());
+    for (const Object* obj : scene.objects) {
+        Shape shape;
+        std::memset(&shape, 0, sizeof(Shape)); // Padding bytes take part in comparisons
+        shape.type = 'U';
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(obj)) {
+            shape.type = 'S';
+            shape.values[0] = sphere->center.x;
+            shape.values[1] = sphere->center.y;
+            shape.values[2] = sphere->center.z;
+            shape.values[3] = sphere->radius;
+        } else if (const Plane* plane = dynamic_cast<const Plane*>(obj)) {
+            shape.type = 'P';
+            shape.values[0] = plane->point.x;
+            shape.values[1] = plane->point.y;
+            shape.values[2] = plane->point.z;
+            shape.values[3] = plane->normal.x;
+            shape.values[4] = plane->normal.y;
+            shape.values[5] = plane->normal.z;
+        } else {
+            shape.object = obj;
+        }
+        current.push_back(shape);
+    }
+    std::sort(current.begin(), current.end());
+
+    std::vector<Vec3f> positions;
+    for (const Light& light : scene.lights) {
+        positions.push_back(light.position);
+    }
+
+    if (keys.empty() || static_cast<int>(positions.size()) != lightCount || cellSize != tableCellSize) {
+        // First frame, released cache, lights added or removed, or a new grid: start over.
+        tableCellSize = cellSize;
+        clearTable(static_cast<int>(positions.size()));
+    } else {
+        // Moved lights lose every cell's visibility towards them.
+        for (int l = 0; l < lightCount; ++l) {
+            if (std::memcmp(&positions[l], &lightPositions[l], sizeof(Vec3f)) == 0) {
+                continue;
+            }
+            for (size_t slot = 0; slot < keys.size(); ++slot) {
+                unsigned char& state = states[slot * lightCount + l];
+                counts.invalidated += state != STATE_UNKNOWN ? 1 : 0;
+                state = STATE_UNKNOWN;
+            }
+        }
+
+        // Objects that appeared or disappeared (a changed object does both) affect the rays
+        // towards the current lights that pass near their old or new shape.
+        lightPositions = positions;
+        std::vector<Shape> changed;
+        std::set_symmetric_difference(shapes.begin(), shapes.end(), current.begin(), current.end(),
+                                      std::back_inserter(changed));
+        for (const Shape& shape : changed) {
+            invalidateNear(shape);
+        }
+    }
+    lightPositions.swap(positions);
+    shapes.swap(current);
+}
+
+void ShadowCache::updateMemoryAccount() {
+    memory.set(MemoryTracker::capacityBytes(keys) + MemoryTracker::capacityBytes(states) +
+               MemoryTracker::capacityBytes(pending) + MemoryTracker::capacityBytes(shapes) +
+               MemoryTracker::capacityBytes(lightPositions));
+}
+
+// Adds a traced shadow ray result to a tile's samples, extending the light's previous run if it matches.
+void ShadowCache::record(std::vector<Sample>& samples, std::vector<int>& lastSample, uint64_t key, int light, bool visible) {
+    int last = lastSample[light];
+    if (last >= 0 && samples[last].key == key && samples[last].visible == visible) {
+        ++samples[last].count;
+        return;
+    }
+    Sample sample = { key, light, 1, visible };
+    lastSample[light] = static_cast<int>(samples.size());
+    samples.push_back(sample);
+}
+
+void ShadowCache::beginFrame(const Scene& scene) {
+    counts = Stats();
+    followEdits(scene);
+    ++frame;
+}
+
+void ShadowCache::trace(const Kernels::SceneView& scene, const TileHits& hits, const std::vector<int>& entries,
+                        unsigned char* visibility) const {
+    if (entries.empty()) {
+        return;
+    }
+    // Shadow rays as built by Scene::isInShadow.
+    const size_t n = entries.size();
+    std::vector<float> originX(n), originY(n), originZ(n), directionX(n), directionY(n), directionZ(n), distance(n);
+    for (size_t e = 0; e < n; ++e) {
+        const int k = entries[e] % hits.count;
+        const Vec3f point(hits.pointX[k], hits.pointY[k], hits.pointZ[k]);
+        const Vec3f& light = lightPositions[entries[e] / hits.count];
+        const Vec3f lightDir = (light - point).normalize();
+        const Ray ray(point + lightDir * 1e-4f, lightDir);
+        originX[e] = ray.origin.x;
+        originY[e] = ray.origin.y;
+        originZ[e] = ray.origin.z;
+        directionX[e] = ray.direction.x;
+        directionY[e] = ray.direction.y;
+        directionZ[e] = ray.direction.z;
+        distance[e] = (light - point).length();
+    }
+    const Kernels::RayArrays rays = { originX.data(), originY.data(), originZ.data(),
+                                      directionX.data(), directionY.data(), directionZ.data() };
+    std::vector<unsigned char> occluded(n);
+    Kernels::active().occluded(scene, rays, distance.data(), static_cast<int>(n), occluded.data());
+    for (size_t e = 0; e < n; ++e) {
+        visibility[entries[e]] = occluded[e] ? 0 : 1;
+    }
+}
+
+void ShadowCache::resolve(const Kernels::SceneView& scene, const TileHits& hits, unsigned char* visibility) {
+    const int count = hits.count;
+    const int columns = hits.tile.width();
+    std::vector<uint64_t> hitKeys(count, 0);
+    std::vector<unsigned char> answers(static_cast<size_t>(count) * lightCount, ANSWER_TRACED);
+    std::vector<int> entries; // light * count + hit, to be traced
+    Stats tileCounts = Stats();
+    uint64_t lastKey = 0; // Neighbouring hits mostly share a cell: its slot is looked up once
+    long long lastSlot = -1;
+
+    // 1. Cache lookups; what the cache cannot answer is traced in one batch.
+    for (int k = 0; k < count; ++k) {
+        if (hits.primitive[k] < 0) {
+            for (int l = 0; l < lightCount; ++l) {
+                visibility[l * count + k] = 0;
+            }
+            continue;
+        }
+        tileCounts.lookups += lightCount;
+        const Vec3f point(hits.pointX[k], hits.pointY[k], hits.pointZ[k]);
+        const uint64_t key = cellKey(point, Vec3f(hits.normalX[k], hits.normalY[k], hits.normalZ[k]));
+        if (key != lastKey) {
+            lastKey = key;
+            lastSlot = key ? find(key) : -1;
+        }
+        const long long slot = lastSlot;
+        hitKeys[k] = key;
+        const int pixel = k / hits.samples;
+        const uint32_t imageIndex = static_cast<uint32_t>(hits.tile.y0 + pixel / columns) * static_cast<uint32_t>(hits.imageWidth) +
+                                    static_cast<uint32_t>(hits.tile.x0 + pixel % columns);
+        const bool verify = slot >= 0 &&
+            Random::uniform(imageIndex, frame, 0x5C + static_cast<uint32_t>(k % hits.samples)) < verifyFraction;
+        for (int l = 0; l < lightCount; ++l) {
+            const unsigned char state = slot >= 0 ? states[slot * lightCount + l] : STATE_UNKNOWN;
+            const unsigned char kind = state & 3;
+            const bool trusted = (kind == STATE_VISIBLE || kind == STATE_OCCLUDED) && (state >> 2) >= minSamples;
+            const int entry = l * count + k;
+            if (trusted) {
+                visibility[entry] = kind == STATE_VISIBLE ? 1 : 0;
+                answers[entry] = verify ? ANSWER_VERIFIED : ANSWER_CACHED;
+            }
+            if (!trusted || verify) {
+                entries.push_back(entry);
+            }
+        }
+    }
+    std::vector<unsigned char> expected(entries.size());
+    for (size_t e = 0; e < entries.size(); ++e) {
+        expected[e] = visibility[entries[e]];
+    }
+    trace(scene, hits, entries, visibility);
+    std::vector<int> flipped; // Verified entries the cache had wrong
+    for (size_t e = 0; e < entries.size(); ++e) {
+        if (answers[entries[e]] == ANSWER_VERIFIED && visibility[entries[e]] != expected[e]) {
+            ++tileCounts.mismatches;
+            flipped.push_back(entries[e]);
+        }
+    }
+    tileCounts.shadowRays += static_cast<long long>(entries.size());
+
+    // 2. Cached visibility that differs from a neighbouring pixel's on the same primitive lies on
+    // a shadow edge in the image, where a cell may straddle the boundary: it is traced instead,
+    // and a disagreement turns the cell into a traced one for later frames. Neighbours are those
+    // of the same sample in the tile. A traced value that turns out different (here or in the
+    // verification above) is followed to its cached neighbours in turn, so that a region the
+    // cache got wrong is traced up to its boundary.
+    std::vector<int> edges;
+    if (refineShadowEdges) {
+        const int rows = hits.tile.height();
+        const int stride = columns * hits.samples;
+        auto neighboursOf = [&](int k, int neighbours[4]) {
+            const int pixel = k / hits.samples;
+            const int i = pixel % columns;
+            const int j = pixel / columns;
+            neighbours[0] = i > 0 ? k - hits.samples : -1;
+            neighbours[1] = i + 1 < columns ? k + hits.samples : -1;
+            neighbours[2] = j > 0 ? k - stride : -1;
+            neighbours[3] = j + 1 < rows ? k + stride : -1;
+        };
+        // Adds the cached neighbours of a wrongly cached entry that share its old value to `batch`.
+        auto followFlip = [&](int entry, std::vector<int>& batch) {
+            const int l = entry / count;
+            const int k = entry % count;
+            int neighbours[4];
+            neighboursOf(k, neighbours);
+            for (int neighbour : neighbours) {
+                const int other = l * count + neighbour;
+                if (neighbour >= 0 && answers[other] == ANSWER_CACHED && hits.primitive[neighbour] == hits.primitive[k] &&
+                    visibility[other] != visibility[entry]) {
+                    answers[other] = ANSWER_TRACED;
+                    batch.push_back(other);
+                }
+            }
+        };
+        std::vector<int> batch;
+        for (int l = 0; l < lightCount; ++l) {
+            for (int k = 0; k < count; ++k) {
+                const int entry = l * count + k;
+                if (answers[entry] != ANSWER_CACHED) {
+                    continue;
+                }
+                int neighbours[4];
+                neighboursOf(k, neighbours);
+                for (int neighbour : neighbours) {
+                    if (neighbour >= 0 && hits.primitive[neighbour] == hits.primitive[k] &&
+                        visibility[l * count + neighbour] != visibility[entry]) {
+                        batch.push_back(entry);
+                        break;
+                    }
+                }
+            }
+        }
+        for (int entry : batch) {
+            answers[entry] = ANSWER_TRACED;
+        }
+        for (int entry : flipped) {
+            followFlip(entry, batch);
+        }
+        while (!batch.empty()) {
+            expected.resize(batch.size());
+            for (size_t e = 0; e < batch.size(); ++e) {
+                expected[e] = visibility[batch[e]];
+            }
+            trace(scene, hits, batch, visibility);
+            std::vector<int> next;
+            for (size_t e = 0; e < batch.size(); ++e) {
+                if (visibility[batch[e]] != expected[e]) {
+                    ++tileCounts.mismatches;
+                    followFlip(batch[e], next);
+                }
+            }
+            edges.insert(edges.end(), batch.begin(), batch.end());
+            batch.swap(next);
+        }
+        tileCounts.shadowRays += static_cast<long long>(edges.size());
+        tileCounts.refined = static_cast<long long>(edges.size());
+    }
+    tileCounts.hits = tileCounts.lookups - tileCounts.shadowRays;
+
+    // 3. Everything traced, in hit order per light, becomes samples for the cache.
+    entries.insert(entries.end(), edges.begin(), edges.end());
+    std::sort(entries.begin(), entries.end());
+    std::vector<Sample> samples;
+    std::vector<int> lastSample(lightCount, -1);
+    for (int entry : entries) {
+        const uint64_t key = hitKeys[entry % count];
+        if (key) {
+            record(samples, lastSample, key, entry / count, visibility[entry] != 0);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(pendingLock);
+    pending.insert(pending.end(), samples.begin(), samples.end());
+    counts.lookups += tileCounts.lookups;
+    counts.hits += tileCounts.hits;
+    counts.shadowRays += tileCounts.shadowRays;
+    counts.refined += tileCounts.refined;
+    counts.mismatches += tileCounts.mismatches;
+}
+
+void ShadowCache::merge() {
+    for (const Sample& sample : pending) {
+        long long slot = insert(sample.key);
+        unsigned char& state = states[slot * lightCount + sample.light];
+        state = mergeState(state, sample.visible, sample.count);
+    }
+    pending.clear();
+}
+
+void ShadowCache::endFrame() {
+    merge();
+    counts.cells = cells;
+    stats = counts;
+    updateMemoryAccount();
+}
@@ -0,0 +1,154 @@
+// src/ShadowCache.h
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Vec3.h"
+#include "Scene.h"
+#include "Tile.h"
+#include "Kernels.h"
+#include "MemoryTracker.h"
+
+// Shadow visibility cached in world space for the renderer's shadow stage (Renderer::shadowCache),
+// so that frames which only move the camera (orbiting, zooming) reuse the shadow rays of earlier
+// frames and cost mostly primary rays.
+//
+// Surface points are binned into cells of a hashed voxel grid, keyed by the point quantized to
+// `cellSize` and the normal quantized to one of 64 directions (so both sides of a thin object, or
+// two surfaces meeting in one voxel, get cells of their own). Each cell stores, per light, whether
+// the shadow rays traced from it so far all reached the light, were all blocked, or disagreed.
+// A hit takes a light's visibility from its cell once `minSamples` agreeing rays were traced
+// there; cells on shadow boundaries (disagreeing rays) are always traced. A small, random
+// fraction of cached answers is traced anyway, so that a boundary crossing a cell whose samples
+// happened to fall on one side is found and the cell turned into a traced one; for the same
+// reason, cached visibility that differs from a neighbouring pixel's in the same tile is traced
+// as well. The rays the cache cannot answer go through the active SIMD kernels in one batch.
+//
+// The cache follows scene edits by itself: every beginFrame() compares the scene's geometry and
+// lights with those of the previous frame. A light that moved loses its visibility in all cells;
+// an object that was added, removed or changed loses the visibility of the cells whose rays to
+// a light pass near its old or new shape. Color edits do not change visibility and keep the cache.
+// Objects other than spheres and planes cannot be compared; any change to them clears the cache.
+//
+// A frame is beginFrame(), the renderer's tiles (resolve(), concurrently), then endFrame(). The
+// table is only read while tiles render; what they trace is merged in at merge() or endFrame(),
+// so the cache contents do not depend on the order the tiles finish in.
+class ShadowCache {
+public:
+    float cellSize;        // Edge length of the voxels in world units
+    int minSamples;        // Agreeing shadow rays needed before a cell's visibility is reused
+    float verifyFraction;  // Fraction of cached lookups traced anyway to detect missed boundaries
+    bool refineShadowEdges; // Trace cached lookups that disagree with a neighbouring pixel
+
+    // Counts of the frame since beginFrame() (complete after endFrame()).
+    struct Stats {
+        long long lookups;     // Hit-light pairs that needed a visibility (= shadow rays without the cache)
+        long long hits;        // ... answered from the cache
+        long long shadowRays;  // Shadow rays actually cast (misses, boundary cells, verification, edges)
+        long long refined;     // Cached lookups traced anyway on shadow edges in the image
+        long long mismatches;  // Verification and edge rays that disagreed with the cache (cell now traced)
+        long long invalidated; // Cell-light entries reset by scene edits since the previous frame
+        int cells;             // Cells in the cache
+
+        // Fraction of lookups answered from the cache (0 before the first frame).
+        double hitRate() const { return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0; }
+        // Shadow rays the cache saved compared to tracing every lookup.
+        long long raysSaved() const { return lookups - shadowRays; }
+    };
+    Stats stats;
+
+    // Primary hits of one tile, as the renderer's shadow stage passes them to resolve():
+    // `samples` consecutive hits per pixel, pixels row by row.
+    struct TileHits {
+        Tile tile;
+        int imageWidth;        // Of the whole image (pixels are verified at random, by image position)
+        int samples;
+        int count;             // tile.pixelCount() * samples
+        const float* pointX;
+        const float* pointY;
+        const float* pointZ;
+        const float* normalX;
+        const float* normalY;
+        const float* normalZ;
+        const int* primitive;  // Closest primitive (see Kernels::SceneView), -1 on a miss
+    };
+
+    ShadowCache();
+
+    // Starts a frame of `scene`: follows its edits since the previous frame and resets the stats.
+    void beginFrame(const Scene& scene);
+
+    // Visibility of the tile's hits: visibility[l * count + k] = 1 if light l reaches hit k
+    // (0 for misses), from the cache where it can answer and traced with the active kernels
+    // otherwise. `scene` is the view the tile is rendered with. Safe to call for several tiles
+    // at once between beginFrame() and endFrame().
+    void resolve(const Kernels::SceneView& scene, const TileHits& hits, unsigned char* visibility);
+
+    // Adds the rays traced since the last merge to the cache, so that the rest of the frame can
+    // use them. Only while no tile is being resolved.
+    void merge();
+
+    // Ends the frame: merges what its tiles traced and completes the stats.
+    void endFrame();
+
+    // Forgets every cached visibility (the cells are kept).
+    void invalidate();
+
+    // Frees the cache, e.g. when it is switched off or to stay within the memory budget.
+    // The next frame starts over with an empty cache.
+    void release();
+
+private:
+    // A traced shadow ray result, collected per tile while rendering and merged into the table
+    // afterwards. Consecutive equal results of a tile are merged into one entry with a count.
+    struct Sample {
+        uint64_t key;
+        int light;
+        int count;
+        bool visible;
+    };
+
+    // Geometry of an object, as compared between frames to find edits.
+    struct Shape {
+        char type;        // 'S' sphere, 'P' plane, 'U' unknown type
+        float values[6];  // Sphere: center, radius; plane: point, normal; unknown: unused
+        const Object* object; // Set for unknown types only, which are told apart by address
+
+        bool operator<(const Shape& other) const; // Byte order, for finding differences between frames
+    };
+
+    std::vector<uint64_t> keys;          // Open-addressing hash table of cells (0 = empty slot)
+    std::vector<unsigned char> states;   // lightCount entries per slot, see ShadowCache.cpp
+    int lightCount;                      // Lights the table is laid out for
+    float tableCellSize;                 // cellSize the keys were computed with
+    int cells;                           // Used slots
+    std::vector<Shape> shapes;           // Sorted geometry of the previous frame
+    std::vector<Vec3f> lightPositions;   // Light positions of the current frame (compared with the next)
+    uint32_t frame;                      // Frame counter, selects the verified lookups
+    std::mutex pendingLock;              // Guards the members below while tiles resolve
+    std::vector<Sample> pending;         // Traced results of the frame's tiles, not merged yet
+    Stats counts;                        // Counts of the tiles resolved so far
+    MemoryTracker::Account memory;       // Bytes of the buffers above (render caches)
+
+    uint64_t cellKey(const Vec3f& point, const Vec3f& normal) const; // 0 if outside the grid
+    Vec3f cellCenter(uint64_t key) const;
+    long long find(uint64_t key) const;      // Slot of a cell, or -1
+    long long insert(uint64_t key);          // Slot of a cell, added if missing
+    void clearTable(int lights);             // Empties the table and lays it out for `lights`
+    void grow();
+    void followEdits(const Scene& scene);    // Invalidates what changed since the previous frame
+    void invalidateNear(const Shape& shape); // Resets the cells whose rays pass near `shape`
+    void updateMemoryAccount();
+    // Traces the shadow rays of `entries` (light * count + hit) and stores the results in `visibility`.
+    void trace(const Kernels::SceneView& scene, const TileHits& hits, const std::vector<int>& entries,
+               unsigned char* visibility) const;
+    static void record(std::vector<Sample>& samples, std::vector<int>& lastSample, uint64_t key, int light, bool visible);
+
+    ShadowCache(const ShadowCache&) = delete;
+    ShadowCache& operator=(const ShadowCache&) = delete;
+};
+
+#endif // SHADOW_CACHE_H
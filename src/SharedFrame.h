@@ -0,0 +1,118 @@
+// src/SharedFrame.h
+#ifndef SHARED_FRAME_H
+#define SHARED_FRAME_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the shared-memory frame ring published by SharedFrameExport (--shm), for external
+// processes on the same host. This header depends on nothing else in the project, so readers
+// can include it on its own (see examples/shm_reader.cpp).
+//
+// The POSIX shared-memory object "/<name>" holds, from offset 0:
+//   Header                  format, resolution and the number of the newest frame
+//   Slot[slotCount]         per-slot sequence counter and frame number
+//   pixels[slotCount]       at header.dataOffset, slotBytes apart: rows top to bottom,
+//                           width * bytesPerPixel bytes each, no padding
+// Frame n goes to slot n % slotCount, so a reader can keep using a frame while the next
+// ones are written into the other slots.
+//
+// Each slot is a seqlock: the writer makes its sequence odd, writes the pixels, then makes it
+// even again. Readers never block the writer. They read the pixels in place and afterwards check
+// that the sequence did not change (beginRead / endRead below); if it did, the frame was
+// overwritten meanwhile and what was read must be discarded.
+namespace SharedFrame {
+    const uint32_t MAGIC = 0x53465452U; // "RTFS" in little-endian byte order
+    const uint32_t VERSION = 1;
+
+    // Values of Header::format (the same numbering as PixelFormat in PixelFormat.h).
+    enum Format : uint32_t {
+        FORMAT_RGB32F = 0, // 3 x float
+        FORMAT_RGB16F = 1, // 3 x IEEE half float
+        FORMAT_RGB9E5 = 2  // uint32: 9-bit mantissas with a shared 5-bit exponent (GL_RGB9_E5)
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;        // Format
+        uint32_t bytesPerPixel;
+        uint32_t slotCount;
+        uint32_t reserved;
+        uint64_t slotBytes;     // Bytes of one slot's pixels (width * height * bytesPerPixel)
+        uint64_t dataOffset;    // Offset of slot 0's pixels from the start of the mapping
+        // Number of the newest complete frame plus one (0 = no frame yet). Frames count from 0.
+        std::atomic<uint64_t> published;
+        // Set when the writer is gone or has replaced the object (e.g. at a new resolution):
+        // readers should unmap and open the name again.
+        std::atomic<uint32_t> closed;
+    };
+
+    struct Slot {
+        std::atomic<uint64_t> sequence; // Odd while the slot is being written
+        uint64_t frame;                 // Number of the frame in the slot
+    };
+
+    // Lock-free atomics are address-free, so they work between processes.
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared atomics must be lock-free");
+
+    // The slot array follows the header.
+    inline const Slot* slots(const Header* header) {
+        return reinterpret_cast<const Slot*>(header + 1);
+    }
+    inline Slot* slots(Header* header) {
+        return reinterpret_cast<Slot*>(header + 1);
+    }
+
+    // Bytes from the start of the mapping to the first slot's pixels, 64-byte aligned.
+    inline uint64_t dataOffset(uint32_t slotCount) {
+        const uint64_t end = sizeof(Header) + sizeof(Slot) * slotCount;
+        return (end + 63) & ~static_cast<uint64_t>(63);
+    }
+
+    // True once the writer has filled in the header (it stores the magic last) and the
+    // layout version is the one described here.
+    inline bool ready(const Header* header) {
+        const bool filled = header->magic == MAGIC && header->version == VERSION;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return filled;
+    }
+
+    // A frame being read in place.
+    struct FrameView {
+        const unsigned char* pixels; // Points into the mapping
+        uint64_t frame;
+        uint32_t slot;
+        uint64_t sequence;           // Slot sequence when the read began
+    };
+
+    // Starts reading the newest frame. Returns false if there is no frame yet or its slot is
+    // being rewritten right now (try again).
+    inline bool beginRead(const Header* header, FrameView& view) {
+        const uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published == 0) {
+            return false;
+        }
+        view.slot = static_cast<uint32_t>((published - 1) % header->slotCount);
+        const Slot& slot = slots(header)[view.slot];
+        view.sequence = slot.sequence.load(std::memory_order_acquire);
+        if (view.sequence & 1) {
+            return false;
+        }
+        view.frame = slot.frame;
+        view.pixels = reinterpret_cast<const unsigned char*>(header) + header->dataOffset + view.slot * header->slotBytes;
+        return true;
+    }
+
+    // True if the frame of `view` was not overwritten while it was read: only then is what
+    // was read (including view.frame) valid.
+    inline bool endRead(const Header* header, const FrameView& view) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slots(header)[view.slot].sequence.load(std::memory_order_relaxed) == view.sequence;
+    }
+}
+
+#endif // SHARED_FRAME_H
@@ -0,0 +1,162 @@
+// src/SharedFrameExport.cpp
+#include "SharedFrameExport.h"
+#include "Parallel.h"
+#include <new> // For placement new
+
+#ifndef _WIN32
+#include <fcntl.h>    // For O_CREAT, O_RDWR
+#include <sys/mman.h> // For shm_open, mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For ftruncate, close
+#endif
+
+static_assert(static_cast<int>(SharedFrame::FORMAT_RGB32F) == PIXEL_RGB32F &&
+              static_cast<int>(SharedFrame::FORMAT_RGB16F) == PIXEL_RGB16F &&
+              static_cast<int>(SharedFrame::FORMAT_RGB9E5) == PIXEL_RGB9E5,
+              "SharedFrame::Format numbers the formats as PixelFormat");
+
+SharedFrameExport::SharedFrameExport(const std::string& name, PixelFormat format, int slotCount)
+    : objectName(name.empty() || name[0] != '/' ? "/" + name : name), format(format),
+      slotCount(slotCount > 0 ? slotCount : 1), header(nullptr), mappedBytes(0), frames(0),
+      memory(MemoryTracker::MEMORY_IMAGE_OUTPUT) {}
+
+SharedFrameExport::~SharedFrameExport() {
+    destroy();
+}
+
+void SharedFrameExport::detach() {
+    if (!header) {
+        return;
+    }
+#ifndef _WIN32
+    munmap(header, mappedBytes);
+#endif
+    header = nullptr;
+    mappedBytes = 0;
+    memory.set(0);
+}
+
+bool SharedFrameExport::publish(const Vec3f* pixels, int width, int height) {
+    if (!header || header->width != static_cast<uint32_t>(width) || header->height != static_cast<uint32_t>(height)) {
+        destroy();
+        if (!create(width, height)) {
+            return false;
+        }
+    }
+
+    // Seqlock write: odd sequence, pixels, even sequence. The release fence keeps the pixel
+    // stores from becoming visible before the odd sequence does.
+    const uint32_t slotIndex = static_cast<uint32_t>(frames % header->slotCount);
+    SharedFrame::Slot& slot = SharedFrame::slots(header)[slotIndex];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    unsigned char* data = reinterpret_cast<unsigned char*>(header) + header->dataOffset + slotIndex * header->slotBytes;
+    const size_t rowBytes = static_cast<size_t>(width) * header->bytesPerPixel;
+    Parallel::forEach(height, [&](int j) {
+        PixelPacking::pack(format, pixels + static_cast<size_t>(j) * width, width, data + j * rowBytes);
+    });
+    slot.frame = frames;
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    header->published.store(++frames, std::memory_order_release);
+    return true;
+}
+
+#ifndef _WIN32
+
+namespace {
+    // Marks a ring left behind by a detached writer closed, so that its readers map the
+    // replacement. Does nothing if there is no such object or it is not a ring.
+    void closeExisting(const std::string& name) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(SharedFrame::Header))) {
+            mapping = mmap(nullptr, sizeof(SharedFrame::Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        SharedFrame::Header* header = static_cast<SharedFrame::Header*>(mapping);
+        if (header->magic == SharedFrame::MAGIC) {
+            header->closed.store(1, std::memory_order_release);
+        }
+        munmap(mapping, sizeof(SharedFrame::Header));
+    }
+}
+
+bool SharedFrameExport::create(int width, int height) {
+    const uint64_t slotBytes = static_cast<uint64_t>(width) * height * PixelPacking::bytesPerPixel(format);
+    const uint64_t offset = SharedFrame::dataOffset(static_cast<uint32_t>(slotCount));
+    const size_t bytes = static_cast<size_t>(offset + slotBytes * slotCount);
+
+    // A fresh object, so that readers still mapping an old one (other size) are not disturbed.
+    closeExisting(objectName);
+    shm_unlink(objectName.c_str());
+    const int fd = shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        lastError = "could not create shared memory " + objectName;
+        return false;
+    }
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd); // The mapping keeps the object alive
+    if (mapping == MAP_FAILED) {
+        shm_unlink(objectName.c_str());
+        lastError = "could not map " + std::to_string(bytes) + " bytes of shared memory " + objectName;
+        return false;
+    }
+
+    // New objects are zero-filled: every slot starts with an even (stable) sequence.
+    header = new (mapping) SharedFrame::Header();
+    for (int s = 0; s < slotCount; ++s) {
+        new (SharedFrame::slots(header) + s) SharedFrame::Slot();
+    }
+    header->width = static_cast<uint32_t>(width);
+    header->height = static_cast<uint32_t>(height);
+    header->format = static_cast<uint32_t>(format);
+    header->bytesPerPixel = static_cast<uint32_t>(PixelPacking::bytesPerPixel(format));
+    header->slotCount = static_cast<uint32_t>(slotCount);
+    header->slotBytes = slotBytes;
+    header->dataOffset = offset;
+    header->published.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    header->version = SharedFrame::VERSION;
+    // Readers check the magic last: once it is visible, the fields above are too.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedFrame::MAGIC;
+    mappedBytes = bytes;
+    memory.set(bytes);
+    return true;
+}
+
+void SharedFrameExport::destroy() {
+    if (!header) {
+        return;
+    }
+    header->closed.store(1, std::memory_order_release);
+    munmap(header, mappedBytes);
+    shm_unlink(objectName.c_str());
+    header = nullptr;
+    mappedBytes = 0;
+    memory.set(0);
+}
+
+#else
+
+bool SharedFrameExport::create(int, int) {
+    lastError = "shared-memory export needs POSIX shared memory";
+    return false;
+}
+
+void SharedFrameExport::destroy() {}
+
+#endif
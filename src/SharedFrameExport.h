@@ -0,0 +1,54 @@
+// src/SharedFrameExport.h
+#ifndef SHARED_FRAME_EXPORT_H
+#define SHARED_FRAME_EXPORT_H
+
+#include <cstdint>
+#include <string>
+
+#include "Vec3.h"
+#include "PixelFormat.h"
+#include "MemoryTracker.h"
+#include "SharedFrame.h"
+
+// Publishes rendered frames into a POSIX shared-memory ring (layout and read protocol in
+// SharedFrame.h), so that compositing and streaming tools on the same host can map it and
+// read frames without screen grabs or files. The pixels are packed straight into the shared
+// slot; readers use them in place.
+// Only available on POSIX systems; elsewhere publish() fails with an error.
+class SharedFrameExport {
+public:
+    // Shared-memory object "/<name>"; created (or replaced) on the first publish().
+    explicit SharedFrameExport(const std::string& name, PixelFormat format = PIXEL_RGB32F, int slotCount = 3);
+    ~SharedFrameExport(); // Marks the ring closed for readers and removes the name (unless detached)
+
+    // Publishes a width x height frame, recreating the object if the resolution changed.
+    // Returns false (see error()) if the shared memory cannot be set up.
+    bool publish(const Vec3f* pixels, int width, int height);
+
+    // Unmaps the ring but leaves the object, with its newest frame and not marked closed, for
+    // readers that map it after this process exits (the batch modes end right after their last
+    // frame). The next writer of the name marks it closed when replacing it.
+    void detach();
+
+    uint64_t framesPublished() const { return frames; }
+    const std::string& error() const { return lastError; }
+    const std::string& name() const { return objectName; }
+
+private:
+    std::string objectName;
+    PixelFormat format;
+    int slotCount;
+    SharedFrame::Header* header; // Start of the mapping (nullptr until the first publish())
+    size_t mappedBytes;
+    uint64_t frames;
+    std::string lastError;
+    MemoryTracker::Account memory; // Size of the mapping (image output)
+
+    bool create(int width, int height);
+    void destroy();
+
+    SharedFrameExport(const SharedFrameExport&) = delete;
+    SharedFrameExport& operator=(const SharedFrameExport&) = delete;
+};
+
+#endif // SHARED_FRAME_EXPORT_H
@@ -0,0 +1,361 @@
+// src/SimdMath.h
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include <cstdint>
+#include <cstring> // For std::memcpy
+#include <cmath>   // For std::sqrt
+
+#include "Vec3.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h> // SSE2
+#define SIMD_MATH_SSE2 1
+#endif
+
+// Wider instruction sets. A file that enables them for part of its code with a target
+// pragma (see KernelsAVX2.cpp) defines these itself, as the pragma does not set __AVX__.
+#if defined(__AVX__) && !defined(SIMD_MATH_AVX)
+#define SIMD_MATH_AVX 1
+#endif
+#if defined(__AVX512F__) && !defined(SIMD_MATH_AVX512)
+#define SIMD_MATH_AVX512 1
+#endif
+#if defined(SIMD_MATH_AVX) || defined(SIMD_MATH_AVX512)
+#include <immintrin.h>
+#endif
+
+// Vector math for kernels that process several rays (or several primitives) at once.
+//
+// FloatN<W>, MaskN<W> and Vec3xN<W> are structure-of-arrays types holding W lanes.
+// Each operation becomes one or a few vector instructions of whatever instruction set the
+// including code is compiled for (SSE2, AVX2, AVX-512): with GCC and Clang the lanes are
+// native vector types, elsewhere plain fixed-length loops left to the auto-vectorizer.
+// Comparisons produce masks (all bits set per true lane), which select() uses to blend
+// results without branches, so divergent lanes simply compute both sides.
+//
+// Everything lives in SIMD_NAMESPACE (default "simd"): a translation unit built with
+// different target flags defines its own namespace before including this header, so
+// inline functions compiled for different instruction sets never get merged by the linker.
+#ifndef SIMD_NAMESPACE
+#define SIMD_NAMESPACE simd
+#endif
+
+namespace SIMD_NAMESPACE {
+
+// Accuracy of rsqrt() and normalize():
+//   PRECISE  1 / sqrt(x), correctly rounded
+//   FAST     bit-trick estimate refined by two Newton steps (relative error < 5e-6),
+//            cheaper than a square root plus a division
+enum Precision { PRECISE, FAST };
+
+// Precision used when none is given; the RAYTRACER_FAST_MATH build option switches it.
+#ifdef RAYTRACER_FAST_MATH
+const Precision DEFAULT_PRECISION = FAST;
+#else
+const Precision DEFAULT_PRECISION = PRECISE;
+#endif
+
+// Fast reciprocal square root of one value (see Precision::FAST).
+inline float fastRsqrt(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    const float half = 0.5f * x;
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return y;
+}
+
+template <Precision P>
+inline float rsqrt(float x) {
+    return P == FAST ? fastRsqrt(x) : 1.0f / std::sqrt(x);
+}
+
+// GCC and Clang vector extensions: FloatN and MaskN hold their lanes in one native vector,
+// so operations map to vector instructions directly instead of relying on the
+// auto-vectorizer (which handles arrays inside small structs poorly). Other compilers
+// use the plain lane loops.
+#if defined(__GNUC__)
+#define SIMD_MATH_VECTOR_EXT 1
+#endif
+
+// ---------------------------------------------------------------------------
+// W-wide lane mask: each lane is 0 (false) or ~0 (true).
+template <int W>
+struct MaskN {
+#ifdef SIMD_MATH_VECTOR_EXT
+    typedef int32_t Native __attribute__((vector_size(W * sizeof(int32_t))));
+    union {
+        Native v;
+        int32_t lane[W];
+    };
+#else
+    int32_t lane[W];
+#endif
+
+    MaskN() {}
+    explicit MaskN(bool value) {
+        for (int k = 0; k < W; ++k) lane[k] = value ? -1 : 0;
+    }
+
+    bool operator[](int k) const { return lane[k] != 0; }
+    void set(int k, bool value) { lane[k] = value ? -1 : 0; }
+
+#ifdef SIMD_MATH_VECTOR_EXT
+    MaskN operator&(const MaskN& m) const { MaskN r; r.v = v & m.v; return r; }
+    MaskN operator|(const MaskN& m) const { MaskN r; r.v = v | m.v; return r; }
+    MaskN operator!() const { MaskN r; r.v = ~v; return r; }
+#else
+    MaskN operator&(const MaskN& m) const { MaskN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] & m.lane[k]; return r; }
+    MaskN operator|(const MaskN& m) const { MaskN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] | m.lane[k]; return r; }
+    MaskN operator!() const { MaskN r; for (int k = 0; k < W; ++k) r.lane[k] = ~lane[k]; return r; }
+#endif
+};
+
+// True if any / all lanes of the mask are set.
+template <int W>
+inline bool any(const MaskN<W>& m) {
+    int32_t bits = 0;
+    for (int k = 0; k < W; ++k) bits |= m.lane[k];
+    return bits != 0;
+}
+
+template <int W>
+inline bool all(const MaskN<W>& m) {
+    int32_t bits = -1;
+    for (int k = 0; k < W; ++k) bits &= m.lane[k];
+    return bits == -1;
+}
+
+// ---------------------------------------------------------------------------
+// W floats processed together.
+template <int W>
+struct FloatN {
+#ifdef SIMD_MATH_VECTOR_EXT
+    typedef float Native __attribute__((vector_size(W * sizeof(float))));
+    typedef float Unaligned __attribute__((vector_size(W * sizeof(float)), aligned(sizeof(float)), may_alias));
+    union {
+        Native v;
+        float lane[W];
+    };
+#else
+    float lane[W];
+#endif
+
+    FloatN() {}
+    FloatN(float value) { // Broadcast (implicit, so scalars mix freely with lanes)
+#ifdef SIMD_MATH_VECTOR_EXT
+        v = Native{} + value;
+#else
+        for (int k = 0; k < W; ++k) lane[k] = value;
+#endif
+    }
+
+    static FloatN load(const float* values) {
+        FloatN r;
+#ifdef SIMD_MATH_VECTOR_EXT
+        r.v = *reinterpret_cast<const Unaligned*>(values); // One unaligned vector load
+#else
+        std::memcpy(r.lane, values, sizeof(r.lane));
+#endif
+        return r;
+    }
+    void store(float* values) const {
+#ifdef SIMD_MATH_VECTOR_EXT
+        *reinterpret_cast<Unaligned*>(values) = v;
+#else
+        std::memcpy(values, lane, sizeof(lane));
+#endif
+    }
+
+    float operator[](int k) const { return lane[k]; }
+    float& operator[](int k) { return lane[k]; }
+
+#ifdef SIMD_MATH_VECTOR_EXT
+    FloatN operator+(const FloatN& b) const { FloatN r; r.v = v + b.v; return r; }
+    FloatN operator-(const FloatN& b) const { FloatN r; r.v = v - b.v; return r; }
+    FloatN operator*(const FloatN& b) const { FloatN r; r.v = v * b.v; return r; }
+    FloatN operator/(const FloatN& b) const { FloatN r; r.v = v / b.v; return r; }
+    FloatN operator-() const { FloatN r; r.v = -v; return r; }
+
+    FloatN& operator+=(const FloatN& b) { v += b.v; return *this; }
+    FloatN& operator-=(const FloatN& b) { v -= b.v; return *this; }
+    FloatN& operator*=(const FloatN& b) { v *= b.v; return *this; }
+
+    MaskN<W> operator<(const FloatN& b) const { MaskN<W> r; r.v = v < b.v; return r; }
+    MaskN<W> operator<=(const FloatN& b) const { MaskN<W> r; r.v = v <= b.v; return r; }
+    MaskN<W> operator>(const FloatN& b) const { MaskN<W> r; r.v = v > b.v; return r; }
+    MaskN<W> operator>=(const FloatN& b) const { MaskN<W> r; r.v = v >= b.v; return r; }
+#else
+    FloatN operator+(const FloatN& b) const { FloatN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] + b.lane[k]; return r; }
+    FloatN operator-(const FloatN& b) const { FloatN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] - b.lane[k]; return r; }
+    FloatN operator*(const FloatN& b) const { FloatN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] * b.lane[k]; return r; }
+    FloatN operator/(const FloatN& b) const { FloatN r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] / b.lane[k]; return r; }
+    FloatN operator-() const { FloatN r; for (int k = 0; k < W; ++k) r.lane[k] = -lane[k]; return r; }
+
+    FloatN& operator+=(const FloatN& b) { for (int k = 0; k < W; ++k) lane[k] += b.lane[k]; return *this; }
+    FloatN& operator-=(const FloatN& b) { for (int k = 0; k < W; ++k) lane[k] -= b.lane[k]; return *this; }
+    FloatN& operator*=(const FloatN& b) { for (int k = 0; k < W; ++k) lane[k] *= b.lane[k]; return *this; }
+
+    MaskN<W> operator<(const FloatN& b) const { MaskN<W> r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] < b.lane[k] ? -1 : 0; return r; }
+    MaskN<W> operator<=(const FloatN& b) const { MaskN<W> r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] <= b.lane[k] ? -1 : 0; return r; }
+    MaskN<W> operator>(const FloatN& b) const { MaskN<W> r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] > b.lane[k] ? -1 : 0; return r; }
+    MaskN<W> operator>=(const FloatN& b) const { MaskN<W> r; for (int k = 0; k < W; ++k) r.lane[k] = lane[k] >= b.lane[k] ? -1 : 0; return r; }
+#endif
+};
+
+template <int W>
+inline FloatN<W> operator+(float a, const FloatN<W>& b) { return FloatN<W>(a) + b; }
+template <int W>
+inline FloatN<W> operator-(float a, const FloatN<W>& b) { return FloatN<W>(a) - b; }
+template <int W>
+inline FloatN<W> operator*(float a, const FloatN<W>& b) { return FloatN<W>(a) * b; }
+
+// Per lane: mask ? a : b.
+template <int W>
+inline FloatN<W> select(const MaskN<W>& mask, const FloatN<W>& a, const FloatN<W>& b) {
+    FloatN<W> r;
+#ifdef SIMD_MATH_VECTOR_EXT
+    typedef typename MaskN<W>::Native Bits;
+    r.v = (typename FloatN<W>::Native)((mask.v & (Bits)a.v) | (~mask.v & (Bits)b.v));
+#else
+    for (int k = 0; k < W; ++k) r.lane[k] = mask.lane[k] ? a.lane[k] : b.lane[k];
+#endif
+    return r;
+}
+
+template <int W>
+inline FloatN<W> min(const FloatN<W>& a, const FloatN<W>& b) {
+    return select(a < b, a, b);
+}
+
+template <int W>
+inline FloatN<W> max(const FloatN<W>& a, const FloatN<W>& b) {
+    return select(a > b, a, b);
+}
+
+// Masked min/max: lanes outside the mask keep `a`.
+template <int W>
+inline FloatN<W> min(const MaskN<W>& mask, const FloatN<W>& a, const FloatN<W>& b) {
+    return select(mask, min(a, b), a);
+}
+
+template <int W>
+inline FloatN<W> max(const MaskN<W>& mask, const FloatN<W>& a, const FloatN<W>& b) {
+    return select(mask, max(a, b), a);
+}
+
+// std::sqrt may set errno for negative inputs, which keeps the compiler from vectorizing a
+// loop of them, so the lanes go through the square root instruction of the widest matching
+// register instead (correctly rounded as well, so the result is the same).
+template <int W>
+struct LaneSqrt {
+    static void apply(const FloatN<W>& a, FloatN<W>& r) {
+        int k = 0;
+#ifdef SIMD_MATH_SSE2
+        for (; k + 4 <= W; k += 4) _mm_storeu_ps(r.lane + k, _mm_sqrt_ps(_mm_loadu_ps(a.lane + k)));
+#endif
+        for (; k < W; ++k) r.lane[k] = std::sqrt(a.lane[k]);
+    }
+};
+
+#ifdef SIMD_MATH_VECTOR_EXT
+#ifdef SIMD_MATH_SSE2
+template <>
+struct LaneSqrt<4> {
+    static void apply(const FloatN<4>& a, FloatN<4>& r) { r.v = _mm_sqrt_ps(a.v); }
+};
+#endif
+#ifdef SIMD_MATH_AVX
+template <>
+struct LaneSqrt<8> {
+    static void apply(const FloatN<8>& a, FloatN<8>& r) { r.v = _mm256_sqrt_ps(a.v); }
+};
+#endif
+#ifdef SIMD_MATH_AVX512
+template <>
+struct LaneSqrt<16> {
+    // _mm512_sqrt_ps passes GCC 12 an undefined source vector that -Wmaybe-uninitialized reports
+    // (GCC bug 105593); the masked form with every lane selected computes the same, from `a`.
+    static void apply(const FloatN<16>& a, FloatN<16>& r) { r.v = _mm512_mask_sqrt_ps(a.v, 0xFFFF, a.v); }
+};
+#endif
+#endif
+
+template <int W>
+inline FloatN<W> sqrt(const FloatN<W>& a) {
+    FloatN<W> r;
+    LaneSqrt<W>::apply(a, r);
+    return r;
+}
+
+template <Precision P, int W>
+inline FloatN<W> rsqrt(const FloatN<W>& a) {
+    if (P == PRECISE) {
+        return FloatN<W>(1.0f) / sqrt(a);
+    }
+    FloatN<W> r;
+    for (int k = 0; k < W; ++k) r.lane[k] = fastRsqrt(a.lane[k]);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// W vectors in structure-of-arrays layout.
+template <int W>
+struct Vec3xN {
+    FloatN<W> x, y, z;
+
+    Vec3xN() {}
+    Vec3xN(const FloatN<W>& x, const FloatN<W>& y, const FloatN<W>& z) : x(x), y(y), z(z) {}
+    Vec3xN(const Vec3f& v) : x(v.x), y(v.y), z(v.z) {} // Broadcast
+
+    // Lane access as scalar vectors.
+    Vec3f get(int k) const { return Vec3f(x.lane[k], y.lane[k], z.lane[k]); }
+    void set(int k, const Vec3f& v) { x.lane[k] = v.x; y.lane[k] = v.y; z.lane[k] = v.z; }
+
+    Vec3xN operator+(const Vec3xN& b) const { return Vec3xN(x + b.x, y + b.y, z + b.z); }
+    Vec3xN operator-(const Vec3xN& b) const { return Vec3xN(x - b.x, y - b.y, z - b.z); }
+    Vec3xN operator*(const Vec3xN& b) const { return Vec3xN(x * b.x, y * b.y, z * b.z); } // Component-wise
+    Vec3xN operator*(const FloatN<W>& s) const { return Vec3xN(x * s, y * s, z * s); }
+    Vec3xN operator-() const { return Vec3xN(-x, -y, -z); }
+    Vec3xN& operator+=(const Vec3xN& b) { x += b.x; y += b.y; z += b.z; return *this; }
+
+    FloatN<W> dot(const Vec3xN& b) const { return x * b.x + y * b.y + z * b.z; }
+    Vec3xN cross(const Vec3xN& b) const {
+        return Vec3xN(y * b.z - z * b.y, z * b.x - x * b.z, x * b.y - y * b.x);
+    }
+    FloatN<W> lengthSquared() const { return dot(*this); }
+    FloatN<W> length() const { return sqrt(lengthSquared()); }
+
+    // Unit-length copy. Zero vectors stay zero, as with Vec3f::normalize().
+    // PRECISE divides by the length exactly like Vec3f::normalize(), so both give identical results.
+    template <Precision P>
+    Vec3xN normalize() const {
+        const FloatN<W> len2 = lengthSquared();
+        const MaskN<W> nonZero = len2 > FloatN<W>(0.0f);
+        if (P == FAST) {
+            return *this * select(nonZero, rsqrt<FAST>(len2), FloatN<W>(0.0f));
+        }
+        const FloatN<W> len = select(nonZero, sqrt(len2), FloatN<W>(1.0f));
+        return Vec3xN(select(nonZero, x / len, FloatN<W>(0.0f)), select(nonZero, y / len, FloatN<W>(0.0f)),
+                      select(nonZero, z / len, FloatN<W>(0.0f)));
+    }
+    Vec3xN normalize() const { return normalize<DEFAULT_PRECISION>(); }
+};
+
+template <int W>
+inline Vec3xN<W> select(const MaskN<W>& mask, const Vec3xN<W>& a, const Vec3xN<W>& b) {
+    return Vec3xN<W>(select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z));
+}
+
+typedef FloatN<4> Float4;
+typedef FloatN<8> Float8;
+typedef Vec3xN<4> Vec3x4;
+typedef Vec3xN<8> Vec3x8;
+
+} // namespace SIMD_NAMESPACE
+
+#endif // SIMD_MATH_H
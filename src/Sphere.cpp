@@ -1,8 +1,9 @@
 // src/Sphere.cpp
 #include "Sphere.h" // Include the header for Sphere class, which also includes Ray.h and Object.h (for IntersectionInfo)
+#include "Frustum.h"
 #include <cmath>    // For std::sqrt
 
-// Implements the ray-sphere intersection test.
+// Implements the ray-sphere distance test.
 // This uses the quadratic formula to find intersection points.
 // A ray is defined as P(t) = O + tD, where O is origin, D is direction, t is distance.
 // A sphere is defined as ||P - C||^2 = R^2, where C is center, R is radius.
@@ -15,7 +16,7 @@
 // If delta < 0, no real roots, no intersection.
 // If delta = 0, one real root, ray touches sphere.
 // If delta > 0, two real roots, ray intersects sphere at two points.
-bool Sphere::intersect(const Ray& ray, IntersectionInfo& info) const {
+bool Sphere::hitDistance(const Ray& ray, float& distance) const {
     Vec3f oc = ray.origin - center; // Vector from ray origin to sphere center
     float a = ray.direction.dot(ray.direction); // Should be 1 if ray.direction is normalized
     float b = 2.0f * oc.dot(ray.direction);
@@ -41,11 +42,21 @@ bool Sphere::intersect(const Ray& ray, IntersectionInfo& info) const {
         }
 
         if (t > 0) { // Valid intersection found
-            info.distance = t;
-            info.point = ray.origin + ray.direction * t;
-            info.normal = (info.point - center).normalize(); // Normal points outwards from sphere center
+            distance = t;
             return true;
         }
     }
     return false; // No valid intersection in front of the ray
 }
+
+// Computes the hit point and normal for a distance found by hitDistance().
+void Sphere::hitAttributes(const Ray& ray, float distance, IntersectionInfo& info) const {
+    info.distance = distance;
+    info.point = ray.origin + ray.direction * distance;
+    info.normal = (info.point - center).normalize(); // Normal points outwards from sphere center
+}
+
+// Culled by its bounding sphere, i.e. itself.
+bool Sphere::outsideFrustum(const Frustum& frustum) const {
+    return frustum.excludesSphere(center, radius);
+}
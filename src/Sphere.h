@@ -16,11 +16,15 @@ public:
     Sphere(const Vec3f& center, float radius, const Vec3f& color)
         : Object(color), center(center), radius(radius) {}
 
-    // Implements the pure virtual intersect function from the Object base class.
-    // This method calculates if a given ray intersects with this sphere.
-    // Returns true if an intersection occurs, and fills the IntersectionInfo struct
-    // with details about the closest intersection point, its normal, and distance.
-    bool intersect(const Ray& ray, IntersectionInfo& info) const override;
+    // Nearest of the two ray-sphere intersections in front of the ray origin.
+    bool hitDistance(const Ray& ray, float& distance) const override;
+
+    // Hit point and outward normal.
+    void hitAttributes(const Ray& ray, float distance, IntersectionInfo& info) const override;
+
+    bool outsideFrustum(const Frustum& frustum) const override;
+
+    size_t memorySize() const override { return sizeof(Sphere); }
 };
 
 #endif // SPHERE_H
@@ -0,0 +1,191 @@
+// src/StreamingOutput.cpp
+#include "StreamingOutput.h"
+#include "Renderer.h"
+#include "Parallel.h"
+#include "Kernels.h"
+#include "MemoryTracker.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include <vector>
+#include <fstream>   // For std::ifstream
+#include <chrono>    // For progress timing
+#include <algorithm> // For std::min
+#include <cstdio>    // For FILE, fwrite, fprintf, snprintf
+#include <cstring>   // For std::strlen
+#include <limits>
+#include <typeinfo>  // For typeid
+
+#ifndef _WIN32
+#include <unistd.h>  // For fsync
+#endif
+
+namespace {
+    std::string header(int width, int height, uint64_t fingerprint) {
+        char job[32];
+        snprintf(job, sizeof(job), "%016llx", static_cast<unsigned long long>(fingerprint));
+        return "P6\n# job " + std::string(job) + "\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    }
+
+    // FNV-1a over the bytes of the values added to it.
+    struct Hash {
+        uint64_t value = 14695981039346656037ULL;
+
+        void add(const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t k = 0; k < size; ++k) {
+                value = (value ^ bytes[k]) * 1099511628211ULL;
+            }
+        }
+        void add(const Vec3f& v) {
+            add(&v.x, sizeof(float));
+            add(&v.y, sizeof(float));
+            add(&v.z, sizeof(float));
+        }
+        void add(float f) { add(&f, sizeof(f)); }
+        void add(int i) { add(&i, sizeof(i)); }
+    };
+
+    // 64-bit seek: gigapixel files are larger than 2 GB.
+    bool seekTo(FILE* file, long long offset) {
+#ifdef _WIN32
+        return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    // Pushes written rows to disk so they survive a crash of the process or the machine.
+    void flushToDisk(FILE* file) {
+        fflush(file);
+#ifndef _WIN32
+        fsync(fileno(file));
+#endif
+    }
+}
+
+uint64_t StreamingOutput::fingerprint(const Scene& scene, const Camera& camera, int samplesPerPixel) {
+    Hash hash;
+    for (const Object* obj : scene.objects) {
+        const char* type = typeid(*obj).name();
+        hash.add(type, std::strlen(type));
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(obj)) {
+            hash.add(sphere->center);
+            hash.add(sphere->radius);
+        } else if (const Plane* plane = dynamic_cast<const Plane*>(obj)) {
+            hash.add(plane->point);
+            hash.add(plane->normal);
+        }
+        hash.add(obj->color);
+    }
+    for (const Light& light : scene.lights) {
+        hash.add(light.position);
+        hash.add(light.color);
+    }
+    hash.add(scene.backgroundColor);
+    hash.add(camera.eyePosition);
+    hash.add(camera.lookAt);
+    hash.add(camera.upVector);
+    hash.add(camera.fov);
+    hash.add(camera.imageWidth);
+    hash.add(camera.imageHeight);
+    hash.add(samplesPerPixel);
+    return hash.value;
+}
+
+int StreamingOutput::completedRows(const std::string& path, int width, int height, uint64_t fingerprint) {
+    std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return 0;
+    }
+    long long size = static_cast<long long>(in.tellg());
+    std::string expected = header(width, height, fingerprint);
+    std::string found(expected.size(), '\0');
+    in.seekg(0);
+    if (size < static_cast<long long>(expected.size()) || !in.read(&found[0], found.size()) || found != expected) {
+        return 0; // Not our file (or another job or size): start over
+    }
+    long long rows = (size - static_cast<long long>(expected.size())) / (3LL * width);
+    return static_cast<int>(std::min<long long>(rows, height));
+}
+
+int StreamingOutput::render(const Scene& scene, const Camera& camera, int samplesPerPixel, const std::string& path,
+                            int bandHeight) {
+    typedef std::chrono::steady_clock Clock;
+    const int width = camera.imageWidth;
+    const int height = camera.imageHeight;
+    const uint64_t job = fingerprint(scene, camera, samplesPerPixel);
+    const std::string fileHeader = header(width, height, job);
+    if ((std::numeric_limits<long long>::max() - static_cast<long long>(fileHeader.size())) / 3 / width < height) {
+        fprintf(stderr, "Error: a %dx%d image exceeds the largest file offset.\n", width, height);
+        return -1;
+    }
+
+    // Resume after the last complete row of the same job, or start a new file.
+    int firstRow = completedRows(path, width, height, job);
+    if (firstRow == 0) {
+        std::ifstream existing(path, std::ios::in | std::ios::binary);
+        if (existing.is_open() && existing.peek() != std::ifstream::traits_type::eof()) {
+            fprintf(stdout, "%s is not a partial render of this job; starting over\n", path.c_str());
+        }
+    }
+    FILE* file = fopen(path.c_str(), firstRow > 0 ? "r+b" : "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open file %s for writing.\n", path.c_str());
+        return -1;
+    }
+    if (firstRow == 0) {
+        fwrite(fileHeader.data(), 1, fileHeader.size(), file);
+    } else {
+        fprintf(stdout, "Resuming %s at row %d of %d\n", path.c_str(), firstRow, height);
+    }
+    // A partially written row after a crash is simply overwritten.
+    if (!seekTo(file, static_cast<long long>(fileHeader.size()) + 3LL * width * firstRow)) {
+        fprintf(stderr, "Error: Could not seek in %s.\n", path.c_str());
+        fclose(file);
+        return -1;
+    }
+
+    // The only image-sized state is one band of float pixels and its 8-bit copy.
+    Renderer renderer(&scene, &camera);
+    renderer.samplesPerPixel = samplesPerPixel;
+    const int columnsPerTile = 64;
+    const int tilesPerBand = (width + columnsPerTile - 1) / columnsPerTile;
+    std::vector<Vec3f> band(static_cast<size_t>(width) * bandHeight);
+    std::vector<unsigned char> bytes(band.size() * 3);
+    MemoryTracker::Account bandMemory(MemoryTracker::MEMORY_FRAMEBUFFERS);
+    MemoryTracker::Account outputMemory(MemoryTracker::MEMORY_IMAGE_OUTPUT);
+    bandMemory.set(MemoryTracker::capacityBytes(band));
+    outputMemory.set(MemoryTracker::capacityBytes(bytes));
+    fprintf(stdout, "Streaming %dx%d to %s in %d-row bands (%.1f MB working set)\n", width, height, path.c_str(),
+            bandHeight, (band.size() * sizeof(Vec3f) + bytes.size()) / (1024.0 * 1024.0));
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+    for (int y0 = firstRow; y0 < height; y0 += bandHeight) {
+        const int y1 = std::min(y0 + bandHeight, height);
+
+        // Render the band as a row of tiles spread over all cores.
+        Parallel::forEach(tilesPerBand, [&](int t) {
+            Tile tile = { t * columnsPerTile, y0, std::min((t + 1) * columnsPerTile, width), y1 };
+            renderer.renderTile(tile, &band[tile.x0], width);
+        });
+
+        const size_t count = static_cast<size_t>(width) * (y1 - y0);
+        Kernels::active().quantize(reinterpret_cast<const float*>(band.data()), count * 3, bytes.data());
+        if (fwrite(bytes.data(), 1, count * 3, file) != count * 3) {
+            fprintf(stderr, "Error: Could not write to %s.\n", path.c_str());
+            fclose(file);
+            return -1;
+        }
+        flushToDisk(file);
+
+        if (std::chrono::duration<double>(Clock::now() - lastReport).count() >= 1.0 || y1 == height) {
+            lastReport = Clock::now();
+            fprintf(stdout, "Progress: %d/%d rows (%d%%)\n", y1, height, static_cast<int>(100.0 * y1 / height));
+        }
+    }
+    fclose(file);
+    fprintf(stdout, "Image saved to %s (%d rows in %.2f s)\n", path.c_str(), height - firstRow,
+            std::chrono::duration<double>(Clock::now() - start).count());
+    return 0;
+}
@@ -0,0 +1,35 @@
+// src/StreamingOutput.h
+#ifndef STREAMING_OUTPUT_H
+#define STREAMING_OUTPUT_H
+
+#include <cstdint>
+#include <string>
+
+#include "Scene.h"
+#include "Camera.h"
+
+// Out-of-core rendering for images too large to keep in memory.
+// The image is rendered in horizontal bands; each finished band is converted to
+// 8-bit RGB and appended to a binary PPM (P6) file, so memory use depends on the
+// image width and band height only. Rows are written in order, which makes the
+// file size a record of progress: an interrupted render is resumed from the last
+// complete row already on disk. The PPM header carries a fingerprint of the job
+// ("# job <hex>" comment line), so that rows of a different scene, camera or sample
+// count are never continued: such a file is rendered again from the start.
+// The image size is only limited by 64-bit file offsets.
+namespace StreamingOutput {
+    // Hash of everything that determines the pixels: the scene's objects, lights and
+    // background, the camera and the samples per pixel.
+    uint64_t fingerprint(const Scene& scene, const Camera& camera, int samplesPerPixel);
+
+    // Returns the number of complete rows in `path` if it is a P6 file with the given size and
+    // fingerprint, 0 otherwise.
+    int completedRows(const std::string& path, int width, int height, uint64_t fingerprint);
+
+    // Renders the camera's image into `path`, resuming a partially written file of the same job.
+    // Returns 0 on success, -1 if the file could not be written or would exceed 64-bit offsets.
+    int render(const Scene& scene, const Camera& camera, int samplesPerPixel, const std::string& path,
+               int bandHeight = 32);
+}
+
+#endif // STREAMING_OUTPUT_H
@@ -0,0 +1,152 @@
+// src/TemporalReprojection.cpp
+#include "TemporalReprojection.h"
+#include <limits>    // For std::numeric_limits
+#include <algorithm> // For std::fill, std::swap
+
+TemporalReprojection::TemporalReprojection()
+    : refreshPeriod(16), depthTolerance(0.05f), reusedPixels(0), tracedPixels(0),
+      width(0), height(0), frameIndex(0), historyValid(false), memory(MemoryTracker::MEMORY_RENDER_CACHES) {}
+
+void TemporalReprojection::resize(int w, int h) {
+    width = w;
+    height = h;
+    release();
+}
+
+void TemporalReprojection::release() {
+    history.release();
+    current.release();
+    std::vector<Vec3f>().swap(historyColor);
+    std::vector<float>().swap(depth);
+    std::vector<unsigned char>().swap(traceMask);
+    memory.set(0);
+    historyValid = false;
+}
+
+void TemporalReprojection::allocate() {
+    history.resize(width, height);
+    current.resize(width, height);
+    historyColor.assign(width * height, Vec3f(0.0f));
+    depth.assign(width * height, 0.0f);
+    traceMask.assign(width * height, 1);
+    memory.set(history.bytes() + current.bytes() + MemoryTracker::capacityBytes(historyColor) +
+               MemoryTracker::capacityBytes(depth) + MemoryTracker::capacityBytes(traceMask));
+    historyValid = false;
+}
+
+void TemporalReprojection::invalidate() {
+    historyValid = false;
+}
+
+// Spreads the refresh pixels over the image with a multiplicative hash so that
+// the re-traced subset does not form visible lines or blocks.
+bool TemporalReprojection::isRefreshPixel(int i, int j) const {
+    if (refreshPeriod <= 1) {
+        return true;
+    }
+    unsigned int hash = static_cast<unsigned int>(j * width + i) * 2654435761u;
+    return (hash >> 16) % refreshPeriod == frameIndex % refreshPeriod;
+}
+
+void TemporalReprojection::reproject(const Camera& camera, std::vector<Vec3f>& framebuffer) {
+    const int pixelCount = width * height;
+    if (static_cast<int>(traceMask.size()) != pixelCount) {
+        allocate();
+    }
+    current.clear();
+    std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+
+    if (!historyValid) {
+        // Nothing to reuse: trace everything.
+        std::fill(traceMask.begin(), traceMask.end(), 1);
+        reusedPixels = 0;
+        tracedPixels = pixelCount;
+        return;
+    }
+
+    // 1. Splat every surface sample of the previous frame into the current view.
+    for (int index = 0; index < pixelCount; ++index) {
+        const Object* obj = history.object[index];
+        if (!obj) {
+            continue; // Background pixels have no world position to reproject
+        }
+
+        const Vec3f& point = history.position[index];
+        const Vec3f& normal = history.normal[index];
+
+        // A surface that now faces away from the eye cannot be visible.
+        if (normal.dot(camera.eyePosition - point) <= 0.0f) {
+            continue;
+        }
+
+        float px, py, z;
+        if (!camera.projectToPixel(point, px, py, z)) {
+            continue;
+        }
+        int i = static_cast<int>(px);
+        int j = static_cast<int>(py);
+        if (px < 0.0f || py < 0.0f || i >= width || j >= height) {
+            continue; // Left the screen
+        }
+
+        // Depth test: the closest reprojected surface wins the pixel.
+        int target = j * width + i;
+        if (z < depth[target]) {
+            depth[target] = z;
+            current.position[target] = point;
+            current.normal[target] = normal;
+            current.object[target] = obj;
+            framebuffer[target] = historyColor[index];
+        }
+    }
+
+    // 2. Decide which pixels must be traced.
+    reusedPixels = 0;
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            int index = j * width + i;
+            const Object* obj = current.object[index];
+            bool trace = !obj || isRefreshPixel(i, j);
+
+            // Reject samples at depth discontinuities: if a neighbour of another object is
+            // clearly closer, this sample may be a farther surface showing through a crack.
+            if (!trace) {
+                float limit = depth[index] * (1.0f - depthTolerance);
+                const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+                for (const auto& offset : offsets) {
+                    int ni = i + offset[0];
+                    int nj = j + offset[1];
+                    if (ni < 0 || nj < 0 || ni >= width || nj >= height) {
+                        continue;
+                    }
+                    int neighbour = nj * width + ni;
+                    if (current.object[neighbour] && current.object[neighbour] != obj && depth[neighbour] < limit) {
+                        trace = true;
+                        break;
+                    }
+                }
+            }
+
+            traceMask[index] = trace ? 1 : 0;
+            if (!trace) {
+                ++reusedPixels;
+            }
+        }
+    }
+    tracedPixels = pixelCount - reusedPixels;
+}
+
+void TemporalReprojection::record(int index, const IntersectionInfo& info, const Object* hitObject) {
+    current.object[index] = hitObject;
+    if (hitObject) {
+        current.position[index] = info.point;
+        current.normal[index] = info.normal;
+    }
+}
+
+void TemporalReprojection::endFrame(const std::vector<Vec3f>& framebuffer) {
+    std::swap(history, current);
+    historyColor = framebuffer;
+    historyValid = true;
+    ++frameIndex;
+}
@@ -0,0 +1,77 @@
+// src/TemporalReprojection.h
+#ifndef TEMPORAL_REPROJECTION_H
+#define TEMPORAL_REPROJECTION_H
+
+#include <vector>
+
+#include "Vec3.h"
+#include "Object.h"
+#include "Camera.h"
+#include "GBuffer.h"
+#include "MemoryTracker.h"
+
+// Reuses the previous frame while the camera moves.
+// The world-space hit points of the last frame are projected into the current camera and
+// splatted (with a depth test) into the framebuffer. Only pixels that received no valid
+// sample (disocclusions, cracks, depth edges) and a rotating subset of refresh pixels
+// need to be traced again. Shading is Lambertian and therefore view-independent,
+// so a reprojected color stays correct as long as the scene itself does not change.
+class TemporalReprojection {
+public:
+    // Every pixel is re-traced at least once every `refreshPeriod` frames.
+    int refreshPeriod;
+    // A reprojected sample is rejected if a neighbour from a different object is closer
+    // by more than this fraction of its depth (catches background leaking through cracks).
+    float depthTolerance;
+
+    // Statistics of the last reproject() call.
+    int reusedPixels;
+    int tracedPixels;
+
+    TemporalReprojection();
+
+    // Sets the image size and drops the history. Buffers are allocated by the next reproject(),
+    // so they only take memory while temporal reprojection is in use.
+    void resize(int width, int height);
+
+    // Frees the buffers and drops the history, e.g. when another render mode is selected
+    // or to stay within the memory budget. The next reproject() allocates them again.
+    void release();
+
+    // Drops the history, e.g. after an object's color or the scene changed.
+    void invalidate();
+
+    // Projects the previous frame into `camera` and writes accepted colors into `framebuffer`.
+    // Afterwards needsTrace() reports which pixels still have to be traced.
+    void reproject(const Camera& camera, std::vector<Vec3f>& framebuffer);
+
+    // True if pixel `index` has to be traced this frame.
+    bool needsTrace(int index) const { return traceMask[index] != 0; }
+
+    // Records the surface found by tracing pixel `index` (hitObject == nullptr for a miss).
+    void record(int index, const IntersectionInfo& info, const Object* hitObject);
+
+    // Finishes the frame: the current hits and `framebuffer` become the next frame's history.
+    void endFrame(const std::vector<Vec3f>& framebuffer);
+
+private:
+    int width;
+    int height;
+    unsigned int frameIndex;
+    bool historyValid;
+
+    GBuffer history;                   // Hits of the previous frame
+    GBuffer current;                   // Hits of the frame being rendered
+    std::vector<Vec3f> historyColor;   // Colors of the previous frame
+    std::vector<float> depth;          // Depth of the reprojected sample per pixel (z-buffer)
+    std::vector<unsigned char> traceMask;
+    MemoryTracker::Account memory;     // Bytes of the buffers above (render caches)
+
+    // Allocates the buffers for the current size.
+    void allocate();
+
+    // True if pixel (i, j) belongs to this frame's rotating refresh subset.
+    bool isRefreshPixel(int i, int j) const;
+};
+
+#endif // TEMPORAL_REPROJECTION_H
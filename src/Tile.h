@@ -0,0 +1,15 @@
+// src/Tile.h
+#ifndef TILE_H
+#define TILE_H
+
+// A rectangular block of pixels [x0, x1) x [y0, y1) rendered as one unit of work.
+struct Tile {
+    int x0, y0; // Top-left pixel (inclusive)
+    int x1, y1; // Bottom-right pixel (exclusive)
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+    int pixelCount() const { return width() * height(); }
+};
+
+#endif // TILE_H
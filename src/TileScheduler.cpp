@@ -0,0 +1,86 @@
+// src/TileScheduler.cpp
+#include "TileScheduler.h"
+#include "Parallel.h"
+#include <algorithm> // For std::stable_sort, std::min
+#include <atomic>    // For std::atomic
+#include <chrono>    // For std::chrono::steady_clock
+
+TileScheduler::TileScheduler(int tileSize)
+    : focusRadius(96.0f), lastTilesRendered(0), lastElapsedMs(0.0),
+      tileSize(tileSize), width(0), height(0), completed(0) {}
+
+void TileScheduler::resize(int w, int h) {
+    width = w;
+    height = h;
+    restart();
+}
+
+void TileScheduler::restart(float focusX, float focusY) {
+    order.clear();
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            Tile tile;
+            tile.x0 = x;
+            tile.y0 = y;
+            tile.x1 = std::min(x + tileSize, width);
+            tile.y1 = std::min(y + tileSize, height);
+            order.push_back(tile);
+        }
+    }
+
+    // Priority key: tiles within focusRadius of the focus point come first (closest first),
+    // followed by all remaining tiles sorted by their distance to the image center.
+    const bool hasFocus = focusX >= 0.0f && focusY >= 0.0f;
+    const float centerX = width * 0.5f;
+    const float centerY = height * 0.5f;
+    const float focusRadiusSquared = focusRadius * focusRadius;
+    auto priority = [&](const Tile& tile) {
+        float tx = (tile.x0 + tile.x1) * 0.5f;
+        float ty = (tile.y0 + tile.y1) * 0.5f;
+        if (hasFocus) {
+            float dx = tx - focusX;
+            float dy = ty - focusY;
+            float focusDistance = dx * dx + dy * dy;
+            if (focusDistance <= focusRadiusSquared) {
+                return focusDistance - focusRadiusSquared; // Negative: ahead of every center-out tile
+            }
+        }
+        float dx = tx - centerX;
+        float dy = ty - centerY;
+        return dx * dx + dy * dy;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](const Tile& a, const Tile& b) {
+        return priority(a) < priority(b);
+    });
+
+    completed = 0;
+}
+
+int TileScheduler::renderFor(double budgetMs, const std::function<void(const Tile&)>& renderTile) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + std::chrono::microseconds(static_cast<long long>(budgetMs * 1000.0));
+
+    // Threads claim tiles in priority order; claimed tiles always form a prefix of the
+    // pending range, so everything before `next` is finished once all threads are joined.
+    // At least one tile is claimed per call, so that a zero or exhausted budget still makes progress.
+    const int total = totalTiles();
+    const int first = completed;
+    std::atomic<int> next(first);
+    if (first < total) {
+        Parallel::run([&](int) {
+            while (Clock::now() < deadline || next.load() == first) {
+                int index = next++;
+                if (index >= total) {
+                    break;
+                }
+                renderTile(order[index]);
+            }
+        });
+    }
+
+    completed = std::min(next.load(), total);
+    lastTilesRendered = completed - first;
+    lastElapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return lastTilesRendered;
+}
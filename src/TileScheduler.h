@@ -0,0 +1,51 @@
+// src/TileScheduler.h
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <vector>
+#include <functional>
+
+#include "Tile.h"
+
+// Spreads the rendering of one image over several frames under a per-frame time budget.
+// Tiles are ordered by priority (tiles near the cursor first, then from the image center
+// outwards). Each call to renderFor() renders as many pending tiles as fit into the budget
+// and leaves the rest for the next call; unfinished tiles keep their previous (stale) pixels.
+class TileScheduler {
+public:
+    // Radius (in pixels) around the focus point whose tiles are rendered before the center-out order.
+    float focusRadius;
+
+    // Statistics of the last renderFor() call.
+    int lastTilesRendered;
+    double lastElapsedMs;
+
+    explicit TileScheduler(int tileSize = 32);
+
+    // Sets the image size and restarts the image.
+    void resize(int width, int height);
+
+    // Starts a new image (e.g. after the camera moved): every tile becomes pending again.
+    // (focusX, focusY) is the pixel that should be refined first; pass negative values for none.
+    void restart(float focusX = -1.0f, float focusY = -1.0f);
+
+    // Renders pending tiles in priority order on all cores until `budgetMs` has elapsed.
+    // A tile that was started is always finished, so the budget may be exceeded by up to one tile;
+    // at least one pending tile is rendered per call, whatever the budget.
+    // Returns the number of tiles rendered by this call.
+    int renderFor(double budgetMs, const std::function<void(const Tile&)>& renderTile);
+
+    int totalTiles() const { return static_cast<int>(order.size()); }
+    int completedTiles() const { return completed; }
+    float progress() const { return order.empty() ? 1.0f : static_cast<float>(completed) / order.size(); }
+    bool isComplete() const { return completed >= totalTiles(); }
+
+private:
+    int tileSize;
+    int width;
+    int height;
+    std::vector<Tile> order; // All tiles of the image, in the order they are rendered
+    int completed;           // order[0 .. completed) are done
+};
+
+#endif // TILE_SCHEDULER_H
@@ -1,8 +1,10 @@
 // src/Utils.cpp
 #include "Utils.h"     // Include the header for Utils namespace and function declarations
+#include "Kernels.h"   // Vectorized colour quantization
 #include <fstream>     // Required for std::ofstream (file output operations)
 #include <algorithm>   // Required for std::min and std::max
 #include <cstdio>      // Required for fprintf (standard C I/O functions for error reporting)
+#include <cstdint>     // Required for uint16_t
 
 // Definition of the savePPMImage function, which belongs to the Utils namespace.
 // This function writes the pixel data from the framebuffer to a PPM (Portable PixMap) file.
@@ -55,3 +57,40 @@ void Utils::savePPMImage(const std::string& filename, int width, int height, con
     // Print a success message to the standard output stream (stdout).
     fprintf(stdout, "Image saved to %s\n", filename.c_str());
 }
+
+// PFM is a binary PPM with 32-bit floats: "PF" header, then rows from the bottom up. A negative
+// scale in the header marks little-endian data, so the floats are written in host byte order.
+bool Utils::savePFMImage(const std::string& filename, int width, int height, const std::vector<Vec3f>& pixels) {
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary);
+    if (!ofs.is_open()) {
+        fprintf(stderr, "Error: Could not open file %s for writing.\n", filename.c_str());
+        return false;
+    }
+    const uint16_t endianProbe = 1;
+    const bool littleEndian = *reinterpret_cast<const unsigned char*>(&endianProbe) == 1;
+    ofs << "PF\n" << width << " " << height << "\n" << (littleEndian ? "-1.0" : "1.0") << "\n";
+
+    static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be tightly packed");
+    for (int j = height - 1; j >= 0; --j) {
+        ofs.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(j) * width]), sizeof(Vec3f) * width);
+    }
+    if (!ofs) {
+        fprintf(stderr, "Error: Could not write %s.\n", filename.c_str());
+        return false;
+    }
+    fprintf(stdout, "Image saved to %s\n", filename.c_str());
+    return true;
+}
+
+// Encodes the pixels as a binary PPM ("P6"): an ASCII header followed by 3 bytes per pixel.
+std::string Utils::encodePPM(int width, int height, const Vec3f* pixels) {
+    std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::string data(header.size() + static_cast<size_t>(width) * height * 3, '\0');
+    data.replace(0, header.size(), header);
+
+    unsigned char* out = reinterpret_cast<unsigned char*>(&data[header.size()]);
+    // Pixels are three consecutive floats, so the whole image converts as one array.
+    static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be tightly packed");
+    Kernels::active().quantize(reinterpret_cast<const float*>(pixels), static_cast<size_t>(width) * height * 3, out);
+    return data;
+}
@@ -11,6 +11,18 @@ namespace Utils {
     // Writes the framebuffer data to a PPM (Portable PixMap) image file.
     // PPM is a simple image format that can be easily viewed.
     void savePPMImage(const std::string& filename, int width, int height, const std::vector<Vec3f>& pixels);
+
+    // Writes unclamped float pixels to a PFM (Portable FloatMap) image file, for data such as
+    // render costs that do not fit in 8 bits. Returns false if the file cannot be written.
+    bool savePFMImage(const std::string& filename, int width, int height, const std::vector<Vec3f>& pixels);
+
+    // Converts a color component to an 8-bit value, clamping it to [0, 1] first.
+    inline unsigned char toByte(float value) {
+        return static_cast<unsigned char>(255.99f * (value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value)));
+    }
+
+    // Encodes pixels as a binary (P6) PPM image in memory, e.g. for sending it over a socket.
+    std::string encodePPM(int width, int height, const Vec3f* pixels);
 }
 
 #endif // UTILS_H
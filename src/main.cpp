@@ -1,6 +1,10 @@
 // src/main.cpp
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
 #include <limits>
 #include <algorithm>
 #include <GL/glew.h>  // For OpenGL functions (GLEW is commonly used to manage OpenGL extensions)
@@ -19,6 +23,29 @@
 #include "Scene.h"
 #include "Utils.h"
 #include "Plane.h" // Include Plane header
+#include "TemporalReprojection.h"
+#include "Renderer.h"
+#include "TileScheduler.h"
+#include "DecoupledShading.h"
+#include "ShadowCache.h"
+#include "SceneLoader.h"
+#include "RenderService.h"
+#include "DistributedRender.h"
+#include "StreamingOutput.h"
+#include "Parallel.h"
+#include "PixelFormat.h"
+#include "Kernels.h"
+#include "BatchQuery.h"
+#include "SceneWatcher.h"
+#include "SceneDiff.h"
+#include "CostHeatmap.h"
+#include "MemoryTracker.h"
+#include "Denoiser.h"
+#include "CameraPath.h"
+#include "Sequence.h"
+#include "ProgressiveRender.h"
+#include "SharedFrameExport.h"
+#include <memory>
 
 // Global variables for scene elements that will be modified by the GUI
 Camera* g_camera = nullptr;
@@ -26,10 +53,109 @@ Scene* g_scene = nullptr;
 Object* g_selectedObject = nullptr; // Pointer to the currently selected object
 IntersectionInfo g_selectedHitInfo; // Stores the intersection info for the selected object
 Plane* g_groundPlane = nullptr;     // Pointer to the ground plane for exclusion
+Kernels::PacketScene g_packetScene; // Resident kernel copy of g_scene, updated along with it
+
+// Scene file hot reload (--watch)
+SceneWatcher* g_sceneWatcher = nullptr;
+std::string g_reloadStatus; // Outcome of the last reload, shown in the GUI
+
+// Render resolution: set with --size and following the window size afterwards
+int g_imageWidth = 640;
+int g_imageHeight = 480;
+int g_windowWidth = 0;  // Latest window size reported by GLFW, applied at the start of the next frame
+int g_windowHeight = 0;
+std::vector<Vec3f> g_framebuffer; // Full float (RGB32F): modes accumulate and reuse samples here
+
+// Format of the pixels uploaded to the display texture (see PixelFormat.h).
+// The window shows 8 bits per channel, so the 4-byte shared-exponent format is enough.
+int g_displayFormat = PIXEL_RGB9E5;
+std::vector<unsigned char> g_displayPixels; // g_framebuffer converted to g_displayFormat
+
+// Memory accounting of the window's buffers and the --memory-budget fallbacks (see MemoryTracker.h)
+MemoryTracker::Account g_framebufferMemory(MemoryTracker::MEMORY_FRAMEBUFFERS); // g_framebuffer and g_displayPixels
+MemoryTracker::Account g_textureMemory(MemoryTracker::MEMORY_GL_TEXTURES);
+const int MAX_RESOLUTION_DIVISOR = 8;
+int g_resolutionDivisor = 1; // Render resolution = requested size / divisor, raised to stay within the budget
+int g_requestedWidth = 0;    // Size asked for by --size or the window, before the divisor
+int g_requestedHeight = 0;
+std::string g_memoryStatus;  // Last fallback taken for the budget, shown in the GUI
+
+// How renderScene() produces a frame (selected from the GUI)
+enum RenderMode {
+    RENDER_FULL_FRAME = 0, // Trace every pixel every frame
+    RENDER_TEMPORAL,       // Reuse the previous frame via reprojection
+    RENDER_TIME_SLICED,    // Refine tiles under a per-frame time budget
+    RENDER_DECOUPLED,      // Full-rate visibility, reduced-rate shadows
+    RENDER_MODE_COUNT
+};
+const char* RENDER_MODE_NAMES[RENDER_MODE_COUNT] = { "Full Frame", "Temporal Reprojection", "Time-Sliced Tiles", "Decoupled Shading" };
+int g_renderMode = RENDER_FULL_FRAME;
+bool g_shadows = true; // Shadow rays on/off (all modes except Decoupled Shading, which always casts them)
+bool g_frustumCulling = true;        // Per-tile frustum culling of primary rays (tiled modes)
+Renderer::CullingStats g_cullingStats = { 0, 0, 0 }; // Of the last frame (no tiles in the untiled modes)
+
+// Temporal reuse of the previous frame
+TemporalReprojection g_temporal;
+
+// Time-sliced tile rendering
+TileScheduler g_scheduler;
+float g_frameBudgetMs = 12.0f;
+bool g_frameDirty = true; // Set whenever the camera or scene changes; restarts the tile scheduler
+
+// Shadows evaluated at a reduced rate with edge-aware upsampling
+DecoupledShading g_decoupled;
+
+// Shadow visibility kept in world space, so that camera moves cost mostly primary rays
+// (Full Frame and Time-Sliced Tiles, with shadows on). It compares the scene with the previous
+// frame itself, so edits need no notification.
+ShadowCache g_shadowCache;
+bool g_cacheShadows = false;
+
+// Samples per pixel of the renderer, and denoising of the full-frame and headless images
+int g_samplesPerPixel = 1;
+Denoiser g_denoiser;
+bool g_denoise = false;
+
+// Shared-memory export of every finished frame (--shm), for external consumers on this host.
+// Owned here so that the window removes the shared-memory name on every exit path; the batch
+// modes detach it instead, leaving their last frame for readers.
+std::unique_ptr<SharedFrameExport> g_frameExport;
+uint64_t g_publishedFrameHash = 0; // Of the window's last published frame, to skip unchanged ones
+
+// Publishes `pixels` through --shm, if enabled; stops exporting after an error.
+void publishFrame(const std::vector<Vec3f>& pixels, int width, int height) {
+    if (g_frameExport && !g_frameExport->publish(pixels.data(), width, height)) {
+        std::cerr << "Shared-memory export disabled: " << g_frameExport->error() << std::endl;
+        g_frameExport.reset();
+    }
+}
+
+// Hash of a frame's pixels (FNV-1a over their 32-bit words), to tell whether the window's
+// image changed since it was last published.
+uint64_t hashFrame(const std::vector<Vec3f>& pixels) {
+    static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be tightly packed");
+    const float* values = &pixels.data()->x;
+    const size_t count = pixels.size() * 3;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t v = 0; v < count; ++v) {
+        uint32_t word;
+        std::memcpy(&word, &values[v], sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Detaches --shm at the end of a batch render, so that its last frame outlives the process.
+void detachFrameExport() {
+    if (g_frameExport && g_frameExport->framesPublished() > 0) {
+        g_frameExport->detach();
+        std::cout << "Shared memory " << g_frameExport->name() << " left with the last frame" << std::endl;
+    }
+}
 
-const int IMAGE_WIDTH = 640;
-const int IMAGE_HEIGHT = 480;
-std::vector<Vec3f> g_framebuffer(IMAGE_WIDTH * IMAGE_HEIGHT);
+// Per-pixel cost diagnostics, shown instead of the image when enabled
+CostHeatmap g_heatmap;
+bool g_showHeatmap = false;
 
 // OpenGL texture ID to display the ray-traced framebuffer
 GLuint g_framebufferTextureID = 0;
@@ -40,10 +166,12 @@ GLuint g_quadVAO = 0;
 GLuint g_quadVBO = 0;
 
 // --- GLOBAL VARIABLES FOR MOUSE CAMERA CONTROL ---
-float g_lastMouseX = IMAGE_WIDTH / 2.0f; // Initial mouse X position (center of screen)
-float g_lastMouseY = IMAGE_HEIGHT / 2.0f; // Initial mouse Y position (center of screen)
+float g_lastMouseX = g_imageWidth / 2.0f; // Initial mouse X position (center of screen)
+float g_lastMouseY = g_imageHeight / 2.0f; // Initial mouse Y position (center of screen)
 bool g_firstMouse = true; // Flag to indicate if it's the first mouse movement
 bool g_isRotating = false; // Flag to indicate if the camera is currently being rotated by mouse drag
+float g_cursorX = -1.0f; // Latest cursor position in image pixels, used to prioritize tiles under the cursor
+float g_cursorY = -1.0f;
 
 float g_cameraYaw = -90.0f;  // Initial yaw angle (looking along -Z axis)
 float g_cameraPitch = 0.0f; // Initial pitch angle
@@ -51,6 +179,22 @@ float g_cameraRadius = 6.0f; // Distance from lookAt point (orbital radius)
 const float CAMERA_SENSITIVITY = 0.1f; // How fast the camera rotates with mouse movement
 // --- END GLOBAL VARIABLES ---
 
+// Current orbit parameters of the interactive camera, e.g. as the start of a --sequence turntable.
+OrbitPose currentOrbit() {
+    OrbitPose pose;
+    pose.yaw = g_cameraYaw;
+    pose.pitch = g_cameraPitch;
+    pose.radius = g_cameraRadius;
+    pose.lookAt = g_camera->lookAt;
+    pose.fov = g_camera->fov;
+    return pose;
+}
+
+// Moves the camera to the current yaw, pitch and radius around its lookAt point and updates its basis.
+void placeOrbitCamera() {
+    currentOrbit().apply(*g_camera);
+}
+
 // Vertex Shader source code
 const char* vertexShaderSource = R"(
 #version 330 core
@@ -115,6 +259,8 @@ GLuint createShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
     return program;
 }
 
+void allocateOpenGLTexture();
+
 // Function to initialize OpenGL and create a texture for the framebuffer
 void setupOpenGLTexture() {
     glGenTextures(1, &g_framebufferTextureID); // Generate one texture ID
@@ -126,16 +272,47 @@ void setupOpenGLTexture() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // Clamp to edge for S coordinate
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Clamp to edge for T coordinate
 
-    // Allocate texture memory (initially empty or with dummy data)
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, IMAGE_WIDTH, IMAGE_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
     glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+    // Rows of 6-byte RGB16F pixels are not always 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    allocateOpenGLTexture();
+}
+
+// Allocates texture memory for the current resolution and display format
+void allocateOpenGLTexture() {
+    static const GLint INTERNAL_FORMATS[PIXEL_FORMAT_COUNT] = { GL_RGB32F, GL_RGB16F, GL_RGB9_E5 };
+    glBindTexture(GL_TEXTURE_2D, g_framebufferTextureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, INTERNAL_FORMATS[g_displayFormat], g_imageWidth, g_imageHeight, 0, GL_RGB, GL_FLOAT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    // Estimated from the format: the driver's actual layout (padding, copies) is not visible from here.
+    g_textureMemory.set(static_cast<size_t>(g_imageWidth) * g_imageHeight *
+                        PixelPacking::bytesPerPixel(static_cast<PixelFormat>(g_displayFormat)));
 }
 
 // Function to update the OpenGL texture with the current framebuffer data
 void updateOpenGLTexture() {
+    static const GLenum UPLOAD_TYPES[PIXEL_FORMAT_COUNT] = { GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_INT_5_9_9_9_REV };
+    const PixelFormat format = static_cast<PixelFormat>(g_displayFormat);
+    const void* pixels = g_framebuffer.data();
+
+    // Pack on all cores first: the upload then moves 2x (RGB16F) or 3x (RGB9E5) fewer bytes
+    // and the driver does not have to convert the floats itself.
+    if (format != PIXEL_RGB32F) {
+        const size_t rowBytes = g_imageWidth * PixelPacking::bytesPerPixel(format);
+        g_displayPixels.resize(rowBytes * g_imageHeight);
+        Parallel::forEach(g_imageHeight, [&](int j) {
+            PixelPacking::pack(format, &g_framebuffer[j * g_imageWidth], g_imageWidth, &g_displayPixels[j * rowBytes]);
+        });
+        pixels = g_displayPixels.data();
+    } else if (!g_displayPixels.empty()) {
+        std::vector<unsigned char>().swap(g_displayPixels); // Float uploads need no conversion buffer
+    }
+    g_framebufferMemory.set(MemoryTracker::capacityBytes(g_framebuffer) + MemoryTracker::capacityBytes(g_displayPixels));
+
     glBindTexture(GL_TEXTURE_2D, g_framebufferTextureID);
     // Upload the pixel data from the framebuffer to the texture
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, IMAGE_WIDTH, IMAGE_HEIGHT, GL_RGB, GL_FLOAT, g_framebuffer.data());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, g_imageWidth, g_imageHeight, GL_RGB, UPLOAD_TYPES[format], pixels);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -175,51 +352,83 @@ void setupFullscreenQuad() {
 }
 
 
+// Traces only the pixels the temporal reprojection could not reuse.
+void renderSceneTemporal(const Renderer& renderer) {
+    // The previous frame is first warped into the current view
+    // and only the pixels it could not cover are traced below.
+    g_temporal.reproject(*g_camera, g_framebuffer);
+
+    Parallel::forEach(g_imageHeight, [&](int j) {
+        for (int i = 0; i < g_imageWidth; ++i) {
+            int index = j * g_imageWidth + i;
+            if (!g_temporal.needsTrace(index)) {
+                continue; // Pixel was reused from the previous frame
+            }
+            IntersectionInfo hitInfo;
+            Object* hitObject = nullptr;
+            g_framebuffer[index] = renderer.renderPixel(i, j, hitInfo, hitObject);
+            g_temporal.record(index, hitInfo, hitObject);
+        }
+    });
+
+    g_temporal.endFrame(g_framebuffer);
+}
+
 // Function to perform the ray tracing and fill the framebuffer
 void renderScene() {
-    // Iterate over each pixel in the image, from top-left to bottom-right.
-    for (int j = 0; j < IMAGE_HEIGHT; ++j) { // Loop through rows (y-coordinate)
-        for (int i = 0; i < IMAGE_WIDTH; ++i) { // Loop through columns (x-coordinate)
-            // Compute the primary ray that originates from the camera's eye position
-            // and passes through the center of the current pixel on the image plane.
-            Ray primRay = g_camera->computePrimaryRay(i, j);
-
-            IntersectionInfo hitInfo;    // Struct to store details about the closest intersection found
-            Object* hitObject = nullptr; // Pointer to the object that was hit (nullptr if no hit)
-
-            // Trace the primary ray into the scene.
-            // If an intersection is found, hitInfo and hitObject will be populated.
-            if (g_scene->trace(primRay, hitInfo, hitObject)) {
-                // If an object was hit, calculate its color based on lighting.
-                Vec3f finalColor = Vec3f(0.0f); // Start with black (no light contribution yet)
-
-                // Iterate through each light source in the scene to calculate its contribution.
-                for (const auto& light : g_scene->lights) {
-                    // Check if the intersection point is in shadow relative to the current light.
-                    if (!g_scene->isInShadow(hitInfo.point, light)) {
-                        // If not in shadow, calculate the light direction vector
-                        // from the hit point to the light source.
-                        Vec3f lightDir = (light.position - hitInfo.point).normalize();
-
-                        // Calculate the diffuse component using Lambert's cosine law:
-                        // max(0, N . L), where N is the surface normal and L is the light direction.
-                        // This ensures that light only affects surfaces facing it.
-                        float diffuseFactor = std::max(0.0f, hitInfo.normal.dot(lightDir));
-
-                        // Add the contribution of this light to the final color.
-                        // The object's color is multiplied by the light's color (intensity)
-                        // and the diffuse factor.
-                        finalColor += hitObject->color * light.color * diffuseFactor;
-                    }
-                }
-                // Assign the calculated final color to the current pixel in the framebuffer.
-                g_framebuffer[j * IMAGE_WIDTH + i] = finalColor;
-            } else {
-                // If the primary ray did not hit any object, assign the scene's background color.
-                g_framebuffer[j * IMAGE_WIDTH + i] = g_scene->backgroundColor;
-            }
+    if (g_showHeatmap) {
+        g_heatmap.shadows = g_shadows;
+        g_heatmap.measure(*g_scene, *g_camera);
+        g_heatmap.colorize(g_framebuffer);
+        g_frameDirty = false;
+        return;
+    }
+
+    Renderer renderer(g_scene, g_camera, g_packetScene);
+    renderer.shadows = g_shadows;
+    renderer.frustumCulling = g_frustumCulling;
+    renderer.samplesPerPixel = g_samplesPerPixel;
+    const bool cacheShadows = g_cacheShadows && g_shadows &&
+                              (g_renderMode == RENDER_FULL_FRAME || g_renderMode == RENDER_TIME_SLICED);
+    if (cacheShadows) {
+        renderer.shadowCache = &g_shadowCache;
+        g_shadowCache.beginFrame(*g_scene);
+    }
+
+    switch (g_renderMode) {
+    case RENDER_TEMPORAL:
+        renderSceneTemporal(renderer);
+        break;
+    case RENDER_TIME_SLICED:
+        // Start over whenever the view changed; otherwise keep refining the current image.
+        // Tiles that are not reached within the budget keep showing the previous image.
+        if (g_frameDirty) {
+            g_scheduler.restart(g_cursorX, g_cursorY);
         }
+        g_scheduler.renderFor(g_frameBudgetMs, [&](const Tile& tile) {
+            renderer.renderTile(tile, &g_framebuffer[tile.y0 * g_imageWidth + tile.x0], g_imageWidth);
+        });
+        break;
+    case RENDER_DECOUPLED:
+        g_decoupled.render(*g_scene, *g_camera, g_framebuffer);
+        break;
+    default:
+        // Only this mode renders a complete new image every frame, which the denoiser needs:
+        // the other modes keep parts of the previous frame, which would be filtered again and again.
+        if (g_denoise) {
+            renderer.features = g_denoiser.prepare(g_imageWidth, g_imageHeight);
+        }
+        renderer.renderFrame(g_framebuffer);
+        if (g_denoise) {
+            g_denoiser.filter(g_framebuffer);
+        }
+        break;
+    }
+    if (cacheShadows) {
+        g_shadowCache.endFrame();
     }
+    g_cullingStats = renderer.cullingStats();
+    g_frameDirty = false;
 }
 
 // --- Custom GLFW Callbacks (now explicitly defined and passed to ImGui's handlers) ---
@@ -243,41 +452,38 @@ void customMouseButtonCallback(GLFWwindow* window, int button, int action, int m
         // Handle left mouse button for object picking
         else if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
             double xpos, ypos;
+            int windowWidth, windowHeight;
             glfwGetCursorPos(window, &xpos, &ypos);
-
-            float ndcX = (2.0f * static_cast<float>(xpos) / IMAGE_WIDTH) - 1.0f;
-            float ndcY = 1.0f - (2.0f * static_cast<float>(ypos) / IMAGE_HEIGHT);
-
-            float fov_rad = g_camera->fov * M_PI / 180.0f;
-            float aspectRatio = static_cast<float>(IMAGE_WIDTH) / IMAGE_HEIGHT;
-            float halfHeight = std::tan(fov_rad / 2.0f);
-            float halfWidth = halfHeight * aspectRatio;
-
-            Vec3f rayDirection = (ndcX * halfWidth * g_camera->u + ndcY * halfHeight * g_camera->v - g_camera->w).normalize();
-            Ray pickingRay(g_camera->eyePosition, rayDirection);
-
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+            // Same ray generation as rendering, through the image position under the cursor
+            // (the image can be smaller than the window, see g_resolutionDivisor).
+            RayBatch pick;
+            pick.resize(1);
+            pick.pixelX[0] = static_cast<float>(xpos * g_imageWidth / std::max(windowWidth, 1));
+            pick.pixelY[0] = static_cast<float>(ypos * g_imageHeight / std::max(windowHeight, 1));
+            g_camera->generateRays(pick);
+            Ray pickingRay = pick.ray(0);
+
+            // Closest pickable object by distance only; the hit point is computed for it alone.
             float closestHitDistance = std::numeric_limits<float>::max();
             Object* potentialHitObject = nullptr;
-            IntersectionInfo currentHitInfo;
-            IntersectionInfo tempSelectedHitInfo;
+            float currentDistance;
 
             for (Object* obj : g_scene->objects) {
                 if (obj == g_groundPlane) {
                     continue;
                 }
 
-                if (obj->intersect(pickingRay, currentHitInfo)) {
-                    if (currentHitInfo.distance < closestHitDistance) {
-                        closestHitDistance = currentHitInfo.distance;
-                        potentialHitObject = obj;
-                        tempSelectedHitInfo = currentHitInfo;
-                    }
+                if (obj->hitDistance(pickingRay, currentDistance) && currentDistance < closestHitDistance) {
+                    closestHitDistance = currentDistance;
+                    potentialHitObject = obj;
                 }
             }
 
             g_selectedObject = potentialHitObject;
             if (g_selectedObject) {
-                g_selectedHitInfo = tempSelectedHitInfo;
+                g_selectedObject->hitAttributes(pickingRay, closestHitDistance, g_selectedHitInfo);
                 std::cout << "Selected object at: (" << g_selectedHitInfo.point.x << ", " << g_selectedHitInfo.point.y << ", " << g_selectedHitInfo.point.z << ")" << std::endl;
             } else {
                 std::cout << "No object selected (or ground plane hit)." << std::endl;
@@ -290,6 +496,11 @@ void customMouseButtonCallback(GLFWwindow* window, int button, int action, int m
 void customCursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
     // Always pass the event to ImGui's handler first
     ImGui_ImplGlfw_CursorPosCallback(window, xpos, ypos);
+    // Window to image coordinates, as for picking (the image can be smaller than the window).
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    g_cursorX = static_cast<float>(xpos * g_imageWidth / std::max(windowWidth, 1));
+    g_cursorY = static_cast<float>(ypos * g_imageHeight / std::max(windowHeight, 1));
 
     // Only rotate if right mouse button is pressed AND ImGui is not capturing the mouse
     if (g_isRotating && !ImGui::GetIO().WantCaptureMouse) {
@@ -320,19 +531,8 @@ void customCursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
         }
 
         // Calculate new camera position based on yaw, pitch, and radius
-        // Convert degrees to radians for trigonometric functions
-        float yaw_rad = g_cameraYaw * M_PI / 180.0f;
-        float pitch_rad = g_cameraPitch * M_PI / 180.0f;
-
-        // Spherical coordinates to Cartesian
-        g_camera->eyePosition.x = g_cameraRadius * std::cos(yaw_rad) * std::cos(pitch_rad);
-        g_camera->eyePosition.y = g_cameraRadius * std::sin(pitch_rad);
-        g_camera->eyePosition.z = g_cameraRadius * std::sin(yaw_rad) * std::cos(pitch_rad);
-
-        // Adjust for lookAt point if it's not at the origin
-        g_camera->eyePosition += g_camera->lookAt;
-
-        g_camera->updateBasis(); // Call updateBasis here
+        placeOrbitCamera();
+        g_frameDirty = true;
     }
 }
 
@@ -347,13 +547,8 @@ void customScrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
         if (g_cameraRadius > 20.0f) g_cameraRadius = 20.0f; // Maximum radius
 
         // Recalculate camera position after radius change
-        float yaw_rad = g_cameraYaw * M_PI / 180.0f;
-        float pitch_rad = g_cameraPitch * M_PI / 180.0f;
-        g_camera->eyePosition.x = g_cameraRadius * std::cos(yaw_rad) * std::cos(pitch_rad);
-        g_camera->eyePosition.y = g_cameraRadius * std::sin(pitch_rad);
-        g_camera->eyePosition.z = g_cameraRadius * std::sin(yaw_rad) * std::cos(pitch_rad);
-        g_camera->eyePosition += g_camera->lookAt;
-        g_camera->updateBasis();
+        placeOrbitCamera();
+        g_frameDirty = true;
     }
 }
 
@@ -363,6 +558,14 @@ void customKeyCallback(GLFWwindow* window, int key, int scancode, int action, in
     // Add custom key logic here if needed, checking ImGui::GetIO().WantCaptureKeyboard
 }
 
+// Custom window size callback: the render resolution follows the window.
+// The render targets are reallocated at the start of the next frame rather than here.
+void customWindowSizeCallback(GLFWwindow* window, int width, int height) {
+    (void)window;
+    g_windowWidth = width;
+    g_windowHeight = height;
+}
+
 // Custom character input callback
 void customCharCallback(GLFWwindow* window, unsigned int c) {
     ImGui_ImplGlfw_CharCallback(window, c);
@@ -372,8 +575,579 @@ void customCharCallback(GLFWwindow* window, unsigned int c) {
 // --- END Custom GLFW Callbacks ---
 
 
+// Reallocates everything sized by the render resolution.
+// Under a memory budget the resolution is lowered before allocating, rather than after exceeding it.
+void resizeRenderTargets(int requestedWidth, int requestedHeight) {
+    g_requestedWidth = requestedWidth;
+    g_requestedHeight = requestedHeight;
+
+    // Bytes per pixel of everything that scales with the resolution, measured on the current
+    // buffers (or the framebuffer and display copies before the first allocation).
+    const size_t resolutionBytes = MemoryTracker::current(MemoryTracker::MEMORY_FRAMEBUFFERS) +
+                                   MemoryTracker::current(MemoryTracker::MEMORY_GL_TEXTURES) +
+                                   MemoryTracker::current(MemoryTracker::MEMORY_RENDER_CACHES);
+    size_t perPixel = sizeof(Vec3f) + 2 * PixelPacking::bytesPerPixel(static_cast<PixelFormat>(g_displayFormat));
+    if (!g_framebuffer.empty()) {
+        perPixel = std::max(perPixel, resolutionBytes / g_framebuffer.size());
+    }
+    const size_t otherBytes = MemoryTracker::total() - std::min(resolutionBytes, MemoryTracker::total());
+    const size_t budget = MemoryTracker::budget();
+    while (budget > 0 && g_resolutionDivisor < MAX_RESOLUTION_DIVISOR &&
+           otherBytes + perPixel * (requestedWidth / g_resolutionDivisor) * (requestedHeight / g_resolutionDivisor) > budget) {
+        g_resolutionDivisor *= 2;
+    }
+    const int width = std::max(1, requestedWidth / g_resolutionDivisor);
+    const int height = std::max(1, requestedHeight / g_resolutionDivisor);
+    if (g_resolutionDivisor > 1) {
+        g_memoryStatus = "Rendering at " + std::to_string(width) + "x" + std::to_string(height) + " instead of " +
+                         std::to_string(requestedWidth) + "x" + std::to_string(requestedHeight) + " to fit the budget";
+        std::cerr << "Memory: " << g_memoryStatus << std::endl;
+    }
+
+    g_imageWidth = width;
+    g_imageHeight = height;
+    g_framebuffer.assign(static_cast<size_t>(width) * height, Vec3f(0.0f));
+    std::vector<Vec3f>(g_framebuffer).swap(g_framebuffer); // Shrink the allocation when the size went down
+    g_framebufferMemory.set(MemoryTracker::capacityBytes(g_framebuffer) + MemoryTracker::capacityBytes(g_displayPixels));
+    g_camera->imageWidth = width;
+    g_camera->imageHeight = height;
+    g_camera->updateBasis();
+    g_temporal.resize(width, height);
+    g_scheduler.resize(width, height);
+    g_frameDirty = true;
+}
+
+// Keeps the accounted memory within --memory-budget after a frame allocated more than foreseen
+// (e.g. a render mode's caches): the caches are dropped first, switching to full-frame rendering,
+// then the render resolution is halved.
+void enforceMemoryBudget() {
+    if (MemoryTracker::fits()) {
+        return;
+    }
+    if (MemoryTracker::current(MemoryTracker::MEMORY_RENDER_CACHES) > 0) {
+        g_temporal.release();
+        g_decoupled.release();
+        g_shadowCache.release();
+        g_cacheShadows = false;
+        g_denoiser.release();
+        g_denoise = false;
+        if (g_renderMode == RENDER_TEMPORAL || g_renderMode == RENDER_DECOUPLED) {
+            g_renderMode = RENDER_FULL_FRAME;
+        }
+        g_frameDirty = true;
+        g_memoryStatus = "Render caches dropped to fit the budget";
+        std::cerr << "Memory: " << g_memoryStatus << std::endl;
+    } else if (g_resolutionDivisor < MAX_RESOLUTION_DIVISOR) {
+        g_resolutionDivisor *= 2;
+        resizeRenderTargets(g_requestedWidth, g_requestedHeight);
+        allocateOpenGLTexture();
+    } else if (g_memoryStatus.compare(0, 4, "Over") != 0) {
+        g_memoryStatus = "Over budget at the lowest resolution (scene data alone may exceed it)";
+        std::cerr << "Memory: " << g_memoryStatus << std::endl;
+    }
+}
+
+// The first plane is treated as the ground and excluded from picking.
+void findGroundPlane() {
+    g_groundPlane = nullptr;
+    for (Object* obj : g_scene->objects) {
+        g_groundPlane = dynamic_cast<Plane*>(obj);
+        if (g_groundPlane) {
+            break;
+        }
+    }
+}
+
+// Re-reads the watched scene file and applies only what changed to the resident scene
+// and its kernel copy. The camera keeps orbiting where it is; a file that fails to parse
+// (e.g. saved half-way through an edit) leaves the resident scene untouched.
+void reloadScene() {
+    Scene loaded;
+    SceneCamera ignoredCamera;
+    std::string error;
+    if (!SceneLoader::load(g_sceneWatcher->path(), loaded, ignoredCamera, error)) {
+        std::cerr << "Scene reload failed: " << error << std::endl;
+        g_reloadStatus = "Reload failed: " + error;
+        return;
+    }
+
+    SceneChanges changes = SceneDiff::apply(*g_scene, loaded);
+    g_packetScene.update(*g_scene, changes);
+
+    // The selection survives unless its object was removed (changed objects are updated in place).
+    if (std::find(g_scene->objects.begin(), g_scene->objects.end(), g_selectedObject) == g_scene->objects.end()) {
+        g_selectedObject = nullptr;
+    }
+    findGroundPlane();
+    if (!changes.empty()) {
+        g_temporal.invalidate(); // Reused pixels may show (or point to) objects that changed
+        g_frameDirty = true;
+    }
+
+    g_reloadStatus = "Reloaded: +" + std::to_string(changes.count(SceneChanges::OBJECT_ADDED)) +
+                     " -" + std::to_string(changes.count(SceneChanges::OBJECT_REMOVED)) +
+                     " ~" + std::to_string(changes.count(SceneChanges::OBJECT_CHANGED)) + " objects" +
+                     (changes.lightsChanged ? ", lights" : "") + (changes.backgroundChanged ? ", background" : "");
+    std::cout << g_reloadStatus << " (" << g_scene->objects.size() << " objects)" << std::endl;
+}
+
+// Loads the scene (the built-in demo scene unless a file is given) and places the orbit camera
+// at the scene's stored camera position. Returns false if the scene file cannot be loaded.
+bool setupCameraAndScene(const std::string& sceneFile) {
+    // Scene Setup
+    g_scene = new Scene();
+    SceneCamera sceneCamera;
+    std::string error;
+    if (!SceneLoader::load(sceneFile, *g_scene, sceneCamera, error)) {
+        std::cerr << "Failed to load scene: " << error << std::endl;
+        return false;
+    }
+
+    findGroundPlane();
+    g_packetScene = Kernels::PacketScene(*g_scene);
+
+    // Camera Setup
+    // Derive the orbit parameters (yaw, pitch, radius around lookAt) from the stored eye position,
+    // so that mouse orbiting continues smoothly from there.
+    OrbitPose start = OrbitPose::fromEye(sceneCamera.eye, sceneCamera.lookAt, sceneCamera.fov);
+    g_cameraRadius = std::max(1.0f, start.radius);
+    g_cameraPitch = start.pitch;
+    g_cameraYaw = start.yaw;
+
+    g_camera = new Camera(
+        Vec3f(0.0f, 0.0f, 0.0f),  // Placeholder eyePosition, will be updated by orbit logic
+        sceneCamera.lookAt,       // lookAt
+        Vec3f(0.0f, 1.0f, 0.0f),  // upVector
+        sceneCamera.fov,          // fov
+        g_imageWidth, g_imageHeight
+    );
+    // Initialize camera's actual eye position based on initial yaw, pitch, radius
+    placeOrbitCamera();
+
+    resizeRenderTargets(g_imageWidth, g_imageHeight);
+    return true;
+}
+
+// Renders one image without opening a window and writes it to `outputPath`.
+// The image is produced by the same time-sliced tile scheduler as the interactive mode,
+// reporting progress after every budget slice until all tiles are done.
+// With a checkpoint file the image is rendered progressively instead (ProgressiveRender.h),
+// so that a stopped render can be resumed.
+int runHeadless(const std::string& outputPath, const ProgressiveRender::Options& progressive) {
+    if (!progressive.checkpointPath.empty()) {
+        int result = ProgressiveRender::render(*g_scene, *g_camera, progressive, g_framebuffer);
+        if (result != 0) {
+            return result;
+        }
+        if (g_denoise) {
+            std::cerr << "Note: --denoise is not applied to checkpointed renders" << std::endl;
+        }
+        publishFrame(g_framebuffer, g_imageWidth, g_imageHeight);
+        Utils::savePPMImage(outputPath, g_imageWidth, g_imageHeight, g_framebuffer);
+        return 0;
+    }
+    Renderer renderer(g_scene, g_camera);
+    renderer.samplesPerPixel = g_samplesPerPixel;
+    if (g_denoise) {
+        renderer.features = g_denoiser.prepare(g_imageWidth, g_imageHeight);
+    }
+    if (g_cacheShadows) {
+        renderer.shadowCache = &g_shadowCache;
+        g_shadowCache.beginFrame(*g_scene);
+    }
+    g_scheduler.restart();
+    while (!g_scheduler.isComplete()) {
+        g_scheduler.renderFor(g_frameBudgetMs, [&](const Tile& tile) {
+            renderer.renderTile(tile, &g_framebuffer[tile.y0 * g_imageWidth + tile.x0], g_imageWidth);
+        });
+        if (g_cacheShadows) {
+            g_shadowCache.merge(); // Later slices reuse the shadow rays of the earlier ones
+        }
+        std::cout << "Progress: " << g_scheduler.completedTiles() << "/" << g_scheduler.totalTiles()
+                  << " tiles (" << static_cast<int>(g_scheduler.progress() * 100.0f) << "%)" << std::endl;
+    }
+    if (g_cacheShadows) {
+        g_shadowCache.endFrame();
+        const ShadowCache::Stats& cache = g_shadowCache.stats;
+        std::printf("Shadow cache: %.1f%% hit rate, %lld of %lld shadow rays saved (traced %lld, edges %lld, mismatches %lld), "
+                    "%d cells\n", 100.0 * cache.hitRate(), cache.raysSaved(), cache.lookups, cache.shadowRays, cache.refined,
+                    cache.mismatches, cache.cells);
+    }
+    if (g_denoise) {
+        g_denoiser.filter(g_framebuffer);
+        std::cout << "Denoised in " << g_denoiser.lastMilliseconds << " ms" << std::endl;
+    }
+    publishFrame(g_framebuffer, g_imageWidth, g_imageHeight);
+    Utils::savePPMImage(outputPath, g_imageWidth, g_imageHeight, g_framebuffer);
+    return 0;
+}
+
+// Renders the frames of a camera path (--path file, or a turntable from the scene's camera) to
+// numbered images. `frames` is "<first>-<last>", "<count>" or empty for the whole path.
+int runSequence(const std::string& prefix, const std::string& pathFile, const std::string& frames, int depth) {
+    CameraPath path;
+    std::string error;
+    if (!pathFile.empty() && !path.load(pathFile, error)) {
+        std::cerr << "Failed to load camera path: " << error << std::endl;
+        return -1;
+    }
+
+    Sequence::Options options;
+    options.prefix = prefix;
+    options.samplesPerPixel = g_samplesPerPixel;
+    options.denoise = g_denoise;
+    options.shadowCache = g_cacheShadows ? &g_shadowCache : nullptr;
+    options.depth = depth;
+    options.frameExport = g_frameExport.get();
+    int first = 0, last = 0, count = 0;
+    if (std::sscanf(frames.c_str(), "%d-%d", &first, &last) == 2 && first >= 0 && last >= first) {
+        options.firstFrame = first;
+        options.lastFrame = last;
+    } else if (frames.find('-') == std::string::npos && std::sscanf(frames.c_str(), "%d", &count) == 1 && count > 0) {
+        options.firstFrame = path.empty() ? 0 : path.firstFrame();
+        options.lastFrame = options.firstFrame + count - 1;
+    } else if (!frames.empty()) {
+        std::cerr << "Error: --frames expects <first>-<last> or <count>" << std::endl;
+        return -1;
+    } else if (!path.empty()) {
+        options.firstFrame = path.firstFrame();
+        options.lastFrame = path.lastFrame();
+    } else {
+        options.lastFrame = 119;
+    }
+    if (path.empty()) {
+        // One turn over the rendered frames, so that the sequence loops.
+        path = CameraPath::turntable(currentOrbit(), options.lastFrame + 1);
+    }
+    return Sequence::render(*g_scene, *g_camera, path, options);
+}
+
+// Parses the --job description used by the batch modes; --scene applies unless the job names its own.
+bool parseCommandLineJob(const std::string& spec, const std::string& sceneFile, RenderJob& job,
+                         int maxSize = RenderJob::MAX_SIZE) {
+    std::string error;
+    if (!job.parse(spec, error, maxSize)) {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+    if (spec.find("scene=") == std::string::npos) {
+        job.scene = sceneFile;
+    }
+    return true;
+}
+
+// Prints the command line options.
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --scene <file>         Load a scene file instead of the built-in demo scene\n"
+              << "  --watch                Reload the --scene file in the window whenever it is saved,\n"
+              << "                         applying only the objects and lights that changed\n"
+              << "  --headless <file.ppm>  Render one image without a window and save it\n"
+              << "  --heatmap <file.pfm>   Save per-pixel intersection tests, shadow rays and nanoseconds\n"
+              << "                         (red, green, blue) as a float image without a window\n"
+              << "  --size <w>x<h>         Image and initial window size (default 640x480)\n"
+              << "  --budget <ms>          Time budget per frame for time-sliced rendering (default 12)\n"
+              << "  --sequence <prefix>    Render an animation without a window to <prefix>_0000.ppm, ...,\n"
+              << "                         tracing each frame while the previous one is denoised and written\n"
+              << "  --path <file>          Keyframed orbit camera path for --sequence (default: one turn around\n"
+              << "                         the scene camera's lookAt point)\n"
+              << "  --frames <a>-<b>|<n>   Frames a to b of the path, or n frames (default: all keys, or 120)\n"
+              << "  --pipeline-depth <n>   Frames in flight between the --sequence stages (default 3)\n"
+              << "  --samples <n>          Jittered samples per pixel (default 1)\n"
+              << "  --denoise              Filter the image with the edge-aware denoiser (headless and full frame)\n"
+              << "  --shadow-cache         Reuse shadow rays through the world-space shadow cache (window, --headless,\n"
+              << "                         --sequence) and print its hit rate\n"
+              << "  --checkpoint <file>    Render the --headless image progressively (one sample per pixel per\n"
+              << "                         pass), saving its state to this file periodically and on SIGINT/SIGTERM\n"
+              << "  --checkpoint-every <s> Seconds between checkpoints (default 60)\n"
+              << "  --resume               Continue the --checkpoint render where it stopped\n"
+              << "  --shm <name>           Publish every finished frame (window, --headless, --sequence) to the\n"
+              << "                         shared-memory ring /<name> for other processes (see SharedFrame.h);\n"
+              << "                         --headless and --sequence leave it with their last frame on exit\n"
+              << "  --shm-format <format>  Pixel format of --shm: rgb32f (default), rgb16f or rgb9e5\n"
+              << "  --memory-budget <MiB>  Stay within this much tracked memory: drop render caches, then\n"
+              << "                         lower the render resolution (default: unlimited)\n"
+              << "  --allow-downscale      Let --headless, --sequence and --heatmap write smaller images when\n"
+              << "                         the --size does not fit the --memory-budget (default: fail)\n"
+              << "  --memory-stats         Print current and peak memory per subsystem before exiting\n"
+              << "  --threads <n>          Number of render threads (default: all cores)\n"
+              << "  --isa <name>           Force the SIMD kernels: avx512, avx2 or sse2 (default: best the CPU\n"
+              << "                         supports; the RAYTRACER_ISA environment variable works too)\n"
+              << "  --serve <address>      Run the render service on a socket path or [host:]port\n"
+              << "  --client <address> <job>...  Send jobs to a render service, e.g.\n"
+              << "                         \"scene=default width=320 height=240 samples=4 out=a.ppm\"\n"
+              << "  --coordinator <address> Render one frame on worker processes; saves to the --headless file\n"
+              << "  --workers <n>          Local workers spawned by the coordinator (default 0)\n"
+              << "  --tile-format <name>   How workers send tiles: rgb32f (default, exact), rgb16f or rgb9e5\n"
+              << "  --job \"<job>\"          Frame rendered by the coordinator, same keys as --client\n"
+              << "  --worker <address>     Render tiles for a coordinator\n"
+              << "  --stream <file.ppm>    Render the --job frame band by band straight to disk (any size);\n"
+              << "                         an interrupted render of the same job resumes where the file ends\n"
+              << "  --bench-queries <n>    Measure batch visibility queries (BatchQuery.h) on n random rays\n"
+              << "                         against the --scene file or the demo scene\n"
+              << "  --bench-rays <frames>  Measure camera ray generation (rays/s) over this many frames\n"
+              << "  --bench-kernels <frames> Measure the scene's specialized render kernel against the generic one\n"
+              << "  --check-scene-diff <n> Check scene reloads (SceneDiff.h) and the kernels' scene copy on n\n"
+              << "                         random scenes\n"
+              << "  --help                 Show this message" << std::endl;
+}
+
 // Main function for the ray tracing application.
-int main(void) {
+int main(int argc, char** argv) {
+    // Parse command line options
+    std::string headlessOutput;
+    std::string sceneFile = SceneLoader::DEFAULT_SCENE;
+    std::string serveAddress;
+    std::string workerAddress;
+    std::string jobSpec;
+    std::string streamOutput;
+    long benchmarkRays = 0;
+    int benchmarkRayFrames = 0;
+    int benchmarkKernelFrames = 0;
+    int sceneDiffChecks = 0;
+    std::string heatmapOutput;
+    std::string sequencePrefix;
+    std::string cameraPathFile;
+    std::string frameRange;
+    int pipelineDepth = 3;
+    ProgressiveRender::Options progressive;
+    std::string sharedName;
+    PixelFormat sharedFormat = PIXEL_RGB32F;
+    bool memoryStats = false;
+    bool allowDownscale = false;
+    bool watchScene = false;
+    CoordinatorOptions coordinator;
+    coordinator.program = argv[0];
+    for (int a = 1; a < argc; ++a) {
+        bool hasValue = a + 1 < argc;
+        if (std::strcmp(argv[a], "--headless") == 0 && hasValue) {
+            headlessOutput = argv[++a];
+        } else if (std::strcmp(argv[a], "--samples") == 0 && hasValue) {
+            g_samplesPerPixel = std::max(1, std::atoi(argv[++a]));
+        } else if (std::strcmp(argv[a], "--denoise") == 0) {
+            g_denoise = true;
+        } else if (std::strcmp(argv[a], "--shadow-cache") == 0) {
+            g_cacheShadows = true;
+        } else if (std::strcmp(argv[a], "--budget") == 0 && hasValue) {
+            g_frameBudgetMs = static_cast<float>(std::atof(argv[++a]));
+            if (!(g_frameBudgetMs > 0.0f)) {
+                std::cerr << "Error: --budget expects a positive number of milliseconds" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[a], "--threads") == 0 && hasValue) {
+            Parallel::setThreadCount(std::atoi(argv[++a]));
+        } else if (std::strcmp(argv[a], "--scene") == 0 && hasValue) {
+            sceneFile = argv[++a];
+        } else if (std::strcmp(argv[a], "--serve") == 0 && hasValue) {
+            serveAddress = argv[++a];
+        } else if (std::strcmp(argv[a], "--coordinator") == 0 && hasValue) {
+            coordinator.address = argv[++a];
+        } else if (std::strcmp(argv[a], "--workers") == 0 && hasValue) {
+            coordinator.spawnWorkers = std::atoi(argv[++a]);
+        } else if (std::strcmp(argv[a], "--tile-format") == 0 && hasValue) {
+            const std::string name = argv[++a];
+            if (name == "rgb32f") {
+                coordinator.tileFormat = PIXEL_RGB32F;
+            } else if (name == "rgb16f") {
+                coordinator.tileFormat = PIXEL_RGB16F;
+            } else if (name == "rgb9e5") {
+                coordinator.tileFormat = PIXEL_RGB9E5;
+            } else {
+                std::cerr << "Error: --tile-format expects rgb32f, rgb16f or rgb9e5" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[a], "--job") == 0 && hasValue) {
+            jobSpec = argv[++a];
+        } else if (std::strcmp(argv[a], "--worker") == 0 && hasValue) {
+            workerAddress = argv[++a];
+        } else if (std::strcmp(argv[a], "--size") == 0 && hasValue) {
+            if (std::sscanf(argv[++a], "%dx%d", &g_imageWidth, &g_imageHeight) != 2 || g_imageWidth < 1 || g_imageHeight < 1) {
+                std::cerr << "Error: --size expects <width>x<height>" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[a], "--isa") == 0 && hasValue) {
+            if (!Kernels::force(argv[++a])) {
+                std::cerr << "Error: --isa " << argv[a] << " is not supported on this CPU; choose one of:";
+                for (const std::string& name : Kernels::supportedNames()) {
+                    std::cerr << " " << name;
+                }
+                std::cerr << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[a], "--sequence") == 0 && hasValue) {
+            sequencePrefix = argv[++a];
+        } else if (std::strcmp(argv[a], "--path") == 0 && hasValue) {
+            cameraPathFile = argv[++a];
+        } else if (std::strcmp(argv[a], "--frames") == 0 && hasValue) {
+            frameRange = argv[++a];
+        } else if (std::strcmp(argv[a], "--pipeline-depth") == 0 && hasValue) {
+            pipelineDepth = std::max(1, std::atoi(argv[++a]));
+        } else if (std::strcmp(argv[a], "--checkpoint") == 0 && hasValue) {
+            progressive.checkpointPath = argv[++a];
+        } else if (std::strcmp(argv[a], "--checkpoint-every") == 0 && hasValue) {
+            progressive.checkpointSeconds = std::atof(argv[++a]);
+        } else if (std::strcmp(argv[a], "--resume") == 0) {
+            progressive.resume = true;
+        } else if (std::strcmp(argv[a], "--shm") == 0 && hasValue) {
+            sharedName = argv[++a];
+        } else if (std::strcmp(argv[a], "--shm-format") == 0 && hasValue) {
+            const std::string name = argv[++a];
+            if (name == "rgb32f") {
+                sharedFormat = PIXEL_RGB32F;
+            } else if (name == "rgb16f") {
+                sharedFormat = PIXEL_RGB16F;
+            } else if (name == "rgb9e5") {
+                sharedFormat = PIXEL_RGB9E5;
+            } else {
+                std::cerr << "Error: --shm-format expects rgb32f, rgb16f or rgb9e5" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[a], "--heatmap") == 0 && hasValue) {
+            heatmapOutput = argv[++a];
+        } else if (std::strcmp(argv[a], "--memory-budget") == 0 && hasValue) {
+            MemoryTracker::setBudget(static_cast<size_t>(std::atof(argv[++a]) * 1024.0 * 1024.0));
+        } else if (std::strcmp(argv[a], "--memory-stats") == 0) {
+            memoryStats = true;
+        } else if (std::strcmp(argv[a], "--allow-downscale") == 0) {
+            allowDownscale = true;
+        } else if (std::strcmp(argv[a], "--watch") == 0) {
+            watchScene = true;
+        } else if (std::strcmp(argv[a], "--bench-queries") == 0 && hasValue) {
+            benchmarkRays = std::atol(argv[++a]);
+        } else if (std::strcmp(argv[a], "--bench-rays") == 0 && hasValue) {
+            benchmarkRayFrames = std::atoi(argv[++a]);
+        } else if (std::strcmp(argv[a], "--bench-kernels") == 0 && hasValue) {
+            benchmarkKernelFrames = std::atoi(argv[++a]);
+        } else if (std::strcmp(argv[a], "--check-scene-diff") == 0 && hasValue) {
+            sceneDiffChecks = std::atoi(argv[++a]);
+        } else if (std::strcmp(argv[a], "--stream") == 0 && hasValue) {
+            streamOutput = argv[++a];
+        } else if (std::strcmp(argv[a], "--client") == 0 && hasValue) {
+            std::string address = argv[++a];
+            return runRenderClient(address, std::vector<std::string>(argv + a + 1, argv + argc));
+        } else {
+            printUsage(argv[0]);
+            return std::strcmp(argv[a], "--help") == 0 ? 0 : -1;
+        }
+    }
+
+    if (!sharedName.empty()) {
+        g_frameExport.reset(new SharedFrameExport(sharedName, sharedFormat));
+    }
+
+    // Report which build of the SIMD kernels this process renders with.
+    std::cout << "Kernels: " << Kernels::active().name << " (" << Kernels::active().width << "-wide)" << std::endl;
+
+    if (sceneDiffChecks > 0) {
+        return runSceneDiffCheck(sceneDiffChecks);
+    }
+    if (!serveAddress.empty()) {
+        RenderServer server(serveAddress);
+        return server.run();
+    }
+    if (!workerAddress.empty()) {
+        return runWorker(workerAddress);
+    }
+    if (!coordinator.address.empty()) {
+        RenderJob job;
+        if (!parseCommandLineJob(jobSpec, sceneFile, job)) {
+            return -1;
+        }
+        return runCoordinator(coordinator, job, headlessOutput.empty() ? "distributed.ppm" : headlessOutput);
+    }
+    if (!streamOutput.empty()) {
+        RenderJob job;
+        Scene scene;
+        SceneCamera sceneCamera;
+        std::string error;
+        // Streamed images are never held in memory, so only the file size limits them (checked by render()).
+        if (!parseCommandLineJob(jobSpec, sceneFile, job, std::numeric_limits<int>::max())) {
+            return -1;
+        }
+        if (!SceneLoader::load(job.scene, scene, sceneCamera, error)) {
+            std::cerr << "Failed to load scene: " << error << std::endl;
+            return -1;
+        }
+        return StreamingOutput::render(scene, job.makeCamera(sceneCamera), job.samples, streamOutput);
+    }
+
+    if (!setupCameraAndScene(sceneFile)) {
+        return -1;
+    }
+    // The batch modes write images of the requested size: rendering them smaller to fit the
+    // memory budget is only done when asked for.
+    const bool writesImages = !headlessOutput.empty() || !sequencePrefix.empty() || !heatmapOutput.empty();
+    if (writesImages && g_resolutionDivisor > 1 && !allowDownscale) {
+        std::cerr << "Error: " << g_requestedWidth << "x" << g_requestedHeight << " does not fit --memory-budget; "
+                  << "raise the budget, lower --size, or pass --allow-downscale to render at " << g_imageWidth << "x"
+                  << g_imageHeight << std::endl;
+        delete g_camera;
+        delete g_scene;
+        return -1;
+    }
+
+    if (benchmarkRays > 0) {
+        int result = runBatchQueryBenchmark(*g_scene, static_cast<size_t>(benchmarkRays));
+        if (memoryStats) {
+            std::cout << MemoryTracker::report();
+        }
+        delete g_camera;
+        delete g_scene;
+        return result;
+    }
+    if (benchmarkRayFrames > 0) {
+        int result = runRayGenerationBenchmark(*g_camera, benchmarkRayFrames);
+        delete g_camera;
+        delete g_scene;
+        return result;
+    }
+    if (benchmarkKernelFrames > 0) {
+        int result = runRenderKernelBenchmark(*g_scene, *g_camera, benchmarkKernelFrames);
+        delete g_camera;
+        delete g_scene;
+        return result;
+    }
+    if (!heatmapOutput.empty()) {
+        g_heatmap.measure(*g_scene, *g_camera);
+        bool saved = g_heatmap.savePFM(heatmapOutput);
+        if (memoryStats) {
+            std::cout << MemoryTracker::report();
+        }
+        delete g_camera;
+        delete g_scene;
+        return saved ? 0 : -1;
+    }
+    if (!sequencePrefix.empty()) {
+        int result = runSequence(sequencePrefix, cameraPathFile, frameRange, pipelineDepth);
+        detachFrameExport();
+        if (memoryStats) {
+            std::cout << MemoryTracker::report();
+        }
+        delete g_camera;
+        delete g_scene;
+        return result;
+    }
+    if (!headlessOutput.empty()) {
+        progressive.scene = sceneFile;
+        progressive.samples = g_samplesPerPixel;
+        int result = runHeadless(headlessOutput, progressive);
+        detachFrameExport();
+        if (memoryStats) {
+            std::cout << MemoryTracker::report();
+        }
+        delete g_camera;
+        delete g_scene;
+        return result;
+    }
+
+    if (watchScene) {
+        if (sceneFile == SceneLoader::DEFAULT_SCENE) {
+            std::cerr << "Error: --watch needs a --scene file" << std::endl;
+            return -1;
+        }
+        g_sceneWatcher = new SceneWatcher(sceneFile);
+    }
+
     // 1. Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -389,7 +1163,7 @@ int main(void) {
 #endif
 
     // Create a windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(IMAGE_WIDTH, IMAGE_HEIGHT, "Interactive Ray Tracer", NULL, NULL);
+    GLFWwindow* window = glfwCreateWindow(g_requestedWidth, g_requestedHeight, "Interactive Ray Tracer", NULL, NULL);
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -430,6 +1204,7 @@ int main(void) {
     glfwSetScrollCallback(window, customScrollCallback); // Added scroll callback for camera zoom
     glfwSetKeyCallback(window, customKeyCallback);       // Added key callback
     glfwSetCharCallback(window, customCharCallback);     // Added char callback
+    glfwSetWindowSizeCallback(window, customWindowSizeCallback);
     // --- END Manual Callback Setup ---
 
     // Setup OpenGL texture for framebuffer display
@@ -442,47 +1217,24 @@ int main(void) {
     glDeleteShader(fragmentShader);
     setupFullscreenQuad();
 
-    // 2. Camera Setup
-    // Initial camera setup for orbit. The actual eyePosition will be calculated
-    // based on g_cameraYaw, g_cameraPitch, and g_cameraRadius.
-    // The initial lookAt point is (0,0,0), and upVector is (0,1,0).
-    g_camera = new Camera(
-        Vec3f(0.0f, 0.0f, 0.0f),  // Placeholder eyePosition, will be updated by orbit logic
-        Vec3f(0.0f, 0.0f, 0.0f),  // lookAt
-        Vec3f(0.0f, 1.0f, 0.0f),  // upVector
-        75.0f,                    // fov (wider view)
-        IMAGE_WIDTH, IMAGE_HEIGHT
-    );
-    // Initialize camera's actual eye position based on initial yaw, pitch, radius
-    float initial_yaw_rad = g_cameraYaw * M_PI / 180.0f;
-    float initial_pitch_rad = g_cameraPitch * M_PI / 180.0f;
-    g_camera->eyePosition.x = g_cameraRadius * std::cos(initial_yaw_rad) * std::cos(initial_pitch_rad);
-    g_camera->eyePosition.y = g_cameraRadius * std::sin(initial_pitch_rad);
-    g_camera->eyePosition.z = g_cameraRadius * std::sin(initial_yaw_rad) * std::cos(initial_pitch_rad);
-    g_camera->eyePosition += g_camera->lookAt;
-    g_camera->updateBasis(); // Call updateBasis here
-
-
-    // 3. Scene Setup
-    g_scene = new Scene(Vec3f(0.1f, 0.1f, 0.2f)); // Slightly bluish background
-
-    // Add objects to the scene
-    g_scene->addObject(new Sphere(Vec3f(0.0f, 0.5f, 0.0f), 1.0f, Vec3f(1.0f, 0.0f, 0.0f))); // Red sphere (sits on plane)
-    g_scene->addObject(new Sphere(Vec3f(1.8f, 0.0f, -1.5f), 0.6f, Vec3f(0.0f, 1.0f, 0.0f))); // Green sphere (raised to be above plane)
-    g_scene->addObject(new Sphere(Vec3f(-1.5f, 1.0f, 0.8f), 0.7f, Vec3f(0.0f, 0.0f, 1.0f))); // Blue sphere (already above plane)
-    g_groundPlane = new Plane(Vec3f(0.0f, -1.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f), Vec3f(0.8f, 0.8f, 0.8f)); // Ground Plane
-    g_scene->addObject(g_groundPlane); // Add ground plane and store its pointer
-    g_scene->addObject(new Sphere(Vec3f(-2.0f, 0.0f, -0.5f), 0.4f, Vec3f(1.0f, 1.0f, 0.0f))); // Yellow sphere (raised to be above plane)
-
-    // Add light sources to the scene
-    g_scene->addLight(Light(Vec3f(6.0f, 6.0f, 6.0f), Vec3f(1.0f, 1.0f, 1.0f)));
-    g_scene->addLight(Light(Vec3f(-6.0f, 4.0f, 3.0f), Vec3f(0.5f, 0.8f, 1.0f)));
 
     // Main application loop
     while (!glfwWindowShouldClose(window)) {
         // Poll and process events
         glfwPollEvents();
 
+        // Apply edits saved to the scene file since the last frame
+        if (g_sceneWatcher && g_sceneWatcher->changed()) {
+            reloadScene();
+        }
+
+        // Follow window resizes (a minimized window reports 0x0 and keeps the old size)
+        if (g_windowWidth > 0 && g_windowHeight > 0 &&
+            (g_windowWidth != g_requestedWidth || g_windowHeight != g_requestedHeight)) {
+            resizeRenderTargets(g_windowWidth, g_windowHeight);
+            allocateOpenGLTexture();
+        }
+
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -501,27 +1253,19 @@ int main(void) {
         if (ImGui::SliderFloat3("LookAt Point", &g_camera->lookAt.x, -5.0f, 5.0f)) {
             // If lookAt changes, recalculate camera position based on current yaw/pitch/radius
             // and then update camera basis vectors
-            float yaw_rad = g_cameraYaw * M_PI / 180.0f;
-            float pitch_rad = g_cameraPitch * M_PI / 180.0f;
-            g_camera->eyePosition.x = g_cameraRadius * std::cos(yaw_rad) * std::cos(pitch_rad);
-            g_camera->eyePosition.y = g_cameraRadius * std::sin(pitch_rad);
-            g_camera->eyePosition.z = g_cameraRadius * std::sin(yaw_rad) * std::cos(pitch_rad);
-            g_camera->eyePosition += g_camera->lookAt; // Adjust for new lookAt
-            g_camera->updateBasis(); // Call updateBasis here
+            placeOrbitCamera();
+            g_frameDirty = true;
         }
         if (ImGui::SliderFloat("FOV", &g_camera->fov, 10.0f, 120.0f)) {
-            // No direct camera basis recalculation needed for FOV, but it affects ray generation.
+            // The basis does not change, but the cached projection constants do.
+            g_camera->updateBasis();
+            g_frameDirty = true;
         }
         // New slider for camera orbital radius
         if (ImGui::SliderFloat("Orbit Radius", &g_cameraRadius, 1.0f, 20.0f)) {
             // When radius changes, recalculate camera position
-            float yaw_rad = g_cameraYaw * M_PI / 180.0f;
-            float pitch_rad = g_cameraPitch * M_PI / 180.0f;
-            g_camera->eyePosition.x = g_cameraRadius * std::cos(yaw_rad) * std::cos(pitch_rad);
-            g_camera->eyePosition.y = g_cameraRadius * std::sin(pitch_rad);
-            g_camera->eyePosition.z = g_cameraRadius * std::sin(yaw_rad) * std::cos(pitch_rad);
-            g_camera->eyePosition += g_camera->lookAt; // Adjust for lookAt
-            g_camera->updateBasis(); // Call updateBasis here
+            placeOrbitCamera();
+            g_frameDirty = true;
         }
         ImGui::Separator();
 
@@ -531,13 +1275,155 @@ int main(void) {
             ImGui::Text("Type: Sphere (for now)");
             ImGui::Text("Address: %p", (void*)g_selectedObject);
             if (ImGui::ColorEdit3("Color", &g_selectedObject->color.x)) {
-                // Color change will be reflected in next renderScene call
+                // Color change will be reflected in next renderScene call, once copied for the kernels.
+                // Reprojected colors of the old shade are no longer valid.
+                SceneChanges changes;
+                SceneChanges::Edit edit = { SceneChanges::OBJECT_CHANGED, static_cast<int>(
+                    std::find(g_scene->objects.begin(), g_scene->objects.end(), g_selectedObject) - g_scene->objects.begin()) };
+                changes.edits.push_back(edit);
+                g_packetScene.update(*g_scene, changes);
+                g_temporal.invalidate();
+                g_frameDirty = true;
             }
         } else {
             ImGui::Text("No object selected. Click on a sphere to select it.");
         }
         ImGui::Separator();
 
+        // Rendering options
+        ImGui::Text("Rendering");
+        ImGui::Text("Resolution: %d x %d", g_imageWidth, g_imageHeight);
+        ImGui::Text("Kernels: %s (%d-wide)", Kernels::active().name, Kernels::active().width);
+        if (g_sceneWatcher) {
+            ImGui::Text("Watching: %s", g_sceneWatcher->path().c_str());
+            if (!g_reloadStatus.empty()) {
+                ImGui::TextWrapped("%s", g_reloadStatus.c_str());
+            }
+        }
+        if (ImGui::Combo("Display Format", &g_displayFormat, PIXEL_FORMAT_NAMES, PIXEL_FORMAT_COUNT)) {
+            allocateOpenGLTexture();
+        }
+        if (ImGui::Checkbox("Shadows", &g_shadows)) {
+            g_temporal.invalidate();
+            g_frameDirty = true;
+        }
+        if (g_shadows && (g_renderMode == RENDER_FULL_FRAME || g_renderMode == RENDER_TIME_SLICED)) {
+            if (ImGui::Checkbox("Cache Shadows", &g_cacheShadows) && !g_cacheShadows) {
+                g_shadowCache.release();
+            }
+            if (g_cacheShadows) {
+                // A new cell size starts the cache over; the other settings apply to the next lookups.
+                ImGui::SliderFloat("Cell Size", &g_shadowCache.cellSize, 0.005f, 0.5f, "%.3f");
+                ImGui::SliderInt("Min Samples", &g_shadowCache.minSamples, 1, 32);
+                ImGui::SliderFloat("Verify Fraction", &g_shadowCache.verifyFraction, 0.0f, 0.25f);
+                ImGui::Checkbox("Refine Shadow Edges", &g_shadowCache.refineShadowEdges);
+                if (ImGui::Button("Clear Shadow Cache")) {
+                    g_shadowCache.invalidate();
+                }
+                const ShadowCache::Stats& cache = g_shadowCache.stats;
+                ImGui::Text("Hit rate: %.1f%% (%lld of %lld lookups), shadow rays: %lld", 100.0 * cache.hitRate(), cache.hits,
+                            cache.lookups, cache.shadowRays);
+                ImGui::Text("Edge rays: %lld, mismatches: %lld", cache.refined, cache.mismatches);
+                ImGui::Text("Cells: %d, invalidated by edits: %lld", cache.cells, cache.invalidated);
+            }
+        }
+        // The temporal and decoupled modes trace one ray per pixel, whatever the sample count.
+        if ((g_renderMode == RENDER_FULL_FRAME || g_renderMode == RENDER_TIME_SLICED) &&
+            ImGui::SliderInt("Samples per Pixel", &g_samplesPerPixel, 1, 16)) {
+            g_frameDirty = true;
+        }
+        if (g_renderMode == RENDER_FULL_FRAME) {
+            if (ImGui::Checkbox("Denoise", &g_denoise) && !g_denoise) {
+                g_denoiser.release();
+            }
+            if (g_denoise) {
+                ImGui::SliderInt("Denoise Passes", &g_denoiser.iterations, 1, Denoiser::MAX_ITERATIONS);
+                ImGui::SliderFloat("Color Sigma", &g_denoiser.colorSigma, 0.05f, 2.0f);
+                ImGui::Text("Denoising: %.2f ms", g_denoiser.lastMilliseconds);
+            }
+        }
+        // Culling does not change the image, only how many objects each tile's rays are tested against.
+        ImGui::Checkbox("Frustum Culling", &g_frustumCulling);
+        if (g_cullingStats.tiles > 0) {
+            ImGui::Text("Culled: %.1f%% of object tests (%.1f of %.1f objects per tile)",
+                        g_cullingStats.culledFraction() * 100.0,
+                        static_cast<double>(g_cullingStats.candidates) / g_cullingStats.tiles,
+                        static_cast<double>(g_cullingStats.objects) / g_cullingStats.tiles);
+        }
+        if (ImGui::Checkbox("Cost Heatmap", &g_showHeatmap)) {
+            g_temporal.invalidate(); // The framebuffer held the heatmap, not the image
+            g_frameDirty = true;
+        }
+        if (g_showHeatmap) {
+            ImGui::Combo("Heatmap Metric", &g_heatmap.metric, CostHeatmap::METRIC_NAMES, CostHeatmap::METRIC_COUNT);
+            ImGui::SliderFloat("Scale Percentile", &g_heatmap.percentile, 50.0f, 100.0f);
+            const double pixels = static_cast<double>(g_imageWidth) * g_imageHeight;
+            ImGui::Text("Red = %.0f; per pixel (scalar path): %.1f tests, %.2f shadow rays, %.0f ns (max %.0f / %.0f / %.0f)",
+                        g_heatmap.scale, g_heatmap.totals[CostHeatmap::METRIC_INTERSECTION_TESTS] / pixels,
+                        g_heatmap.totals[CostHeatmap::METRIC_SHADOW_RAYS] / pixels, g_heatmap.totals[CostHeatmap::METRIC_TIME] / pixels,
+                        g_heatmap.maxima[CostHeatmap::METRIC_INTERSECTION_TESTS], g_heatmap.maxima[CostHeatmap::METRIC_SHADOW_RAYS],
+                        g_heatmap.maxima[CostHeatmap::METRIC_TIME]);
+            if (ImGui::Button("Export Costs (costs.pfm)")) {
+                g_heatmap.savePFM("costs.pfm");
+            }
+        }
+        if (ImGui::Combo("Render Mode", &g_renderMode, RENDER_MODE_NAMES, RENDER_MODE_COUNT)) {
+            // Only the selected mode keeps its buffers; history is stale after running without it anyway.
+            if (g_renderMode != RENDER_TEMPORAL) {
+                g_temporal.release();
+            }
+            if (g_renderMode != RENDER_DECOUPLED) {
+                g_decoupled.release();
+            }
+            if (g_renderMode != RENDER_FULL_FRAME && g_renderMode != RENDER_TIME_SLICED) {
+                g_shadowCache.release();
+            }
+            if (g_renderMode != RENDER_FULL_FRAME) {
+                g_denoiser.release();
+            }
+            g_temporal.invalidate();
+            g_frameDirty = true;
+        }
+        if (g_renderMode == RENDER_TEMPORAL) {
+            ImGui::SliderInt("Refresh Period", &g_temporal.refreshPeriod, 1, 64);
+            ImGui::Text("Reused: %d px, Traced: %d px (%.1f%%)", g_temporal.reusedPixels, g_temporal.tracedPixels,
+                        100.0f * g_temporal.tracedPixels / (g_imageWidth * g_imageHeight));
+        } else if (g_renderMode == RENDER_TIME_SLICED) {
+            ImGui::SliderFloat("Frame Budget (ms)", &g_frameBudgetMs, 1.0f, 100.0f);
+            ImGui::ProgressBar(g_scheduler.progress());
+            ImGui::Text("Tiles: %d / %d (+%d in %.2f ms)", g_scheduler.completedTiles(), g_scheduler.totalTiles(),
+                        g_scheduler.lastTilesRendered, g_scheduler.lastElapsedMs);
+        } else if (g_renderMode == RENDER_DECOUPLED) {
+            const char* rateNames[] = { "1x1", "2x2", "4x4" };
+            int rateIndex = g_decoupled.rate >= 4 ? 2 : g_decoupled.rate - 1;
+            if (ImGui::Combo("Shading Rate", &rateIndex, rateNames, 3)) {
+                g_decoupled.rate = 1 << rateIndex;
+            }
+            ImGui::SliderFloat("Normal Threshold", &g_decoupled.normalThreshold, 0.0f, 1.0f);
+            ImGui::SliderFloat("Depth Threshold", &g_decoupled.depthThreshold, 0.001f, 0.5f);
+            ImGui::Checkbox("Refine Shadow Edges", &g_decoupled.refineShadowEdges);
+            ImGui::Text("Shadow rays: %lld of %lld (%.1fx fewer)", g_decoupled.shadowRays, g_decoupled.fullRateRays,
+                        g_decoupled.shadowRays > 0 ? static_cast<double>(g_decoupled.fullRateRays) / g_decoupled.shadowRays : 0.0);
+            ImGui::Text("Full-rate pixels: %d edges, %d shadow boundaries", g_decoupled.fallbackPixels, g_decoupled.refinedPixels);
+        }
+        ImGui::Separator();
+
+        if (ImGui::CollapsingHeader("Memory")) {
+            for (int c = 0; c < MemoryTracker::MEMORY_CATEGORY_COUNT; ++c) {
+                const MemoryTracker::Category category = static_cast<MemoryTracker::Category>(c);
+                ImGui::Text("%-16s %9.2f MiB (peak %.2f)", MemoryTracker::CATEGORY_NAMES[c],
+                            MemoryTracker::current(category) / 1048576.0, MemoryTracker::peak(category) / 1048576.0);
+            }
+            ImGui::Text("%-16s %9.2f MiB (peak %.2f)", "Total", MemoryTracker::total() / 1048576.0, MemoryTracker::peakTotal() / 1048576.0);
+            if (MemoryTracker::budget() > 0) {
+                ImGui::Text("Budget: %.2f MiB", MemoryTracker::budget() / 1048576.0);
+            }
+            if (!g_memoryStatus.empty()) {
+                ImGui::TextWrapped("%s", g_memoryStatus.c_str());
+            }
+        }
+        ImGui::Separator();
+
         ImGui::Text("Application Average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
         ImGui::End(); // End the GUI window
         // ---------------------------------------------------------------------
@@ -545,9 +1431,22 @@ int main(void) {
         // 5. Ray Trace the Scene
         renderScene();
         updateOpenGLTexture(); // Update the OpenGL texture with the new framebuffer data
+        // Only complete images are published, each once: not the cost heatmap, not a time-sliced
+        // image that still shows tiles of the previous view, and not the same image again.
+        if (g_frameExport && !g_showHeatmap && (g_renderMode != RENDER_TIME_SLICED || g_scheduler.isComplete())) {
+            const uint64_t hash = hashFrame(g_framebuffer);
+            if (hash != g_publishedFrameHash) {
+                g_publishedFrameHash = hash;
+                publishFrame(g_framebuffer, g_imageWidth, g_imageHeight);
+            }
+        }
+        enforceMemoryBudget();
 
         // 6. OpenGL Rendering (Display the ray-traced image using shaders)
-        glViewport(0, 0, IMAGE_WIDTH, IMAGE_HEIGHT); // Set viewport to match image dimensions
+        // Set viewport to the window's framebuffer, which is larger than the image on high-DPI displays
+        int displayWidth, displayHeight;
+        glfwGetFramebufferSize(window, &displayWidth, &displayHeight);
+        glViewport(0, 0, displayWidth, displayHeight);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Clear with black background
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -572,6 +1471,10 @@ int main(void) {
     }
 
     // 8. Cleanup
+    if (memoryStats) {
+        std::cout << MemoryTracker::report();
+    }
+    delete g_sceneWatcher;
     delete g_camera;
     delete g_scene;
 